@@ -1,10 +1,19 @@
 #version 330 core
 
-uniform vec3 u_lightColor;
-uniform float u_brightness;
+layout (std140) uniform FrameBlock {  // See UniformBlocks
+  mat4 projection;
+  mat4 view;
+  vec4 cameraPosition;
+  vec4 lightPosition;
+  vec4 lightColor;  // w: Brightness of the light sphere
+  vec4 lighting;    // Ambient, specular strength, shininess
+  highp ivec4 highlight;  // Hovered object id, triangle
+} frame;
 
-out vec4 fragColor;
+layout (location = 0) out vec4 fragColor;
+layout (location = 1) out highp ivec2 fragId;  // Not an object
 
 void main() {
-  fragColor = vec4(u_lightColor * u_brightness, 1.0);
+  fragColor = vec4(frame.lightColor.rgb * frame.lightColor.w, 1.0);
+  fragId = ivec2(0);
 }
\ No newline at end of file
@@ -2,8 +2,17 @@
 
 layout(location = 0) in vec3 a_position;
 
-uniform mat4 u_transform;
+layout (std140) uniform ObjectBlock {  // See UniformBlocks
+  mat4 transform;
+  mat4 modelTransform;
+  mat4 normalTransform;
+  highp ivec4 ids;  // Object id
+} object;
+
+uniform vec3 u_positionOffset;  // Vertex format (see VertexFormat)
+uniform vec3 u_positionScale;
 
 void main() {
-  gl_Position = u_transform * vec4(a_position, 1.0);
+  vec3 position = u_positionOffset + a_position * u_positionScale;
+  gl_Position = object.transform * vec4(position, 1.0);
 }
\ No newline at end of file
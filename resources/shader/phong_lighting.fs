@@ -4,29 +4,72 @@ in vec3 v_normal;
 in vec2 v_texCoord;
 in vec3 v_fragPosition;
 
-uniform vec3 u_lightPosition;
-uniform vec3 u_lightColor;
+layout (std140) uniform FrameBlock {  // See UniformBlocks
+  mat4 projection;
+  mat4 view;
+  vec4 cameraPosition;
+  vec4 lightPosition;
+  vec4 lightColor;  // w: Brightness of the light sphere
+  vec4 lighting;    // Ambient, specular strength, shininess
+  highp ivec4 highlight;  // Hovered object id, triangle
+} frame;
+
+layout (std140) uniform ObjectBlock {  // See UniformBlocks
+  mat4 transform;
+  mat4 modelTransform;
+  mat4 normalTransform;
+  highp ivec4 ids;  // Object id
+} object;
+
 uniform vec3 u_objectColor;
-uniform float u_ambientStrength;
+uniform bool u_useMaterial;  // Use the material instead of u_objectColor
+
+struct Material {
+  sampler2D diffuse;
+  vec3 diffuseColor;
+  bool useDiffuseTexture;
+};
+uniform Material material;
 
-uniform float u_specularStrength;
-uniform float u_specularShiness;
-uniform vec3 u_viewPosition;
+// Picking (see SceneWindow)
+uniform highp int u_primitiveBase;  // Triangle of gl_PrimitiveID 0, or -1
 
-out vec4 fragColor;
+layout (location = 0) out vec4 fragColor;
+layout (location = 1) out highp ivec2 fragId;  // Object, triangle + 1
 
 void main() {
-  vec3 ambient = u_ambientStrength * u_lightColor;
+  vec3 lightColor = frame.lightColor.rgb;
+  vec3 ambient = frame.lighting.x * lightColor;
 
-  vec3 lightDir = normalize(u_lightPosition - v_fragPosition);
+  vec3 lightDir = normalize(frame.lightPosition.xyz - v_fragPosition);
   vec3 fragNormal = normalize(v_normal);
-  vec3 diffuse = max(dot(fragNormal, lightDir), 0.0) * u_lightColor;
+  vec3 diffuse = max(dot(fragNormal, lightDir), 0.0) * lightColor;
 
-  vec3 viewDir = normalize(u_viewPosition - v_fragPosition);
+  vec3 viewDir = normalize(frame.cameraPosition.xyz - v_fragPosition);
   vec3 reflectDir = reflect(-lightDir, fragNormal);
-  float spec = pow(max(dot(viewDir, reflectDir), 0.0), u_specularShiness);
-  vec3 specular = u_specularStrength * spec * u_lightColor;
+  float spec = pow(max(dot(viewDir, reflectDir), 0.0), frame.lighting.z);
+  vec3 specular = frame.lighting.y * spec * lightColor;
+
+  vec3 objectColor = u_objectColor;
+  if (u_useMaterial) {
+    objectColor = material.diffuseColor;
+    if (material.useDiffuseTexture) {
+      objectColor *= texture(material.diffuse, v_texCoord).rgb;
+    }
+  }
+
+  // OpenGL ES 3.0 has no gl_PrimitiveID
+  highp int triangle = -1;
+#ifndef GL_ES
+  if (u_primitiveBase >= 0) triangle = u_primitiveBase + gl_PrimitiveID;
+#endif
 
-  vec3 finalColor = (ambient + diffuse + specular) * u_objectColor;
+  vec3 finalColor = (ambient + diffuse + specular) * objectColor;
+  if (object.ids.x != 0 && object.ids.x == frame.highlight.x) {
+    bool hoveredTriangle = triangle >= 0 && triangle == frame.highlight.y;
+    finalColor = mix(finalColor, vec3(1.0, 0.8, 0.2),
+                     hoveredTriangle ? 0.6 : 0.25);
+  }
   fragColor = vec4(finalColor, 1.0);
+  fragId = ivec2(object.ids.x, triangle + 1);
 }
\ No newline at end of file
@@ -4,16 +4,36 @@ layout (location = 0) in vec3 a_position;  // a_ : attribute
 layout (location = 1) in vec3 a_normal;
 layout (location = 2) in vec2 a_texCoord;
 
-uniform mat4 u_transform;  // u_ : uniform
-uniform mat4 u_modelTransform;
+layout (std140) uniform ObjectBlock {  // See UniformBlocks
+  mat4 transform;
+  mat4 modelTransform;
+  mat4 normalTransform;
+  highp ivec4 ids;  // Object id
+} object;
+
+// Vertex format (see VertexFormat)
+uniform vec3 u_positionOffset;
+uniform vec3 u_positionScale;
+uniform bool u_octahedralNormal;
 
 out vec3 v_normal;  // v_ : varying
 out vec2 v_texCoord;
 out vec3 v_fragPosition;
 
+vec3 decodeOctahedral(vec2 e) {
+  vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  if (v.z < 0.0) {
+    v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0,
+                                    v.y >= 0.0 ? 1.0 : -1.0);
+  }
+  return normalize(v);
+}
+
 void main() {
-  gl_Position = u_transform * vec4(a_position, 1.0);
-  v_normal = (transpose(inverse(u_modelTransform)) * vec4(a_normal, 0.0)).xyz;
+  vec3 position = u_positionOffset + a_position * u_positionScale;
+  vec3 normal = u_octahedralNormal ? decodeOctahedral(a_normal.xy) : a_normal;
+  gl_Position = object.transform * vec4(position, 1.0);
+  v_normal = mat3(object.normalTransform) * normal;
   v_texCoord = a_texCoord;
-  v_fragPosition = (u_modelTransform * vec4(a_position, 1.0)).xyz;
+  v_fragPosition = (object.modelTransform * vec4(position, 1.0)).xyz;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "font_manager.h"
 #include "scene_window.h"
 #include "scene_tree.h"
+#include "util/file_view.h"
 
 // Standard library
 #include <fstream>
@@ -76,18 +77,14 @@ void App::SaveImGuiIniFile() {
 void App::LoadImGuiIniFile() {
   const char* filePath = Instance().IMGUI_SETTING_FILE_PATH;
 
-  std::ifstream fin(filePath, std::ifstream::in);
-  if (!fin) {
+  FileViewUPtr fileView = FileView::New(filePath);
+  if (!fileView) {
     SPDLOG_ERROR("Failed to find ImGui setting file!");
     return;
   }
 
-  std::ostringstream ss;
-  ss << fin.rdbuf();
-  fin.close();
-  std::string fileContents = ss.str();
-
-  ImGui::LoadIniSettingsFromMemory(fileContents.c_str(), fileContents.size());
+  std::string_view fileContents = fileView->GetString();
+  ImGui::LoadIniSettingsFromMemory(fileContents.data(), fileContents.size());
 }
 #endif
 
@@ -205,6 +202,63 @@ void App::renderDockSpaceAndMenu() {
       if (ImGui::MenuItem(ICON_FA6_FILE_IMPORT "  Import")) {
         FileLoader::Instance().OpenFileBrowser();
       };
+      if (ImGui::MenuItem(ICON_FA6_FOLDER_OPEN "  Import Folder")) {
+        FileLoader::Instance().OpenFolderBrowser();
+      }
+      if (ImGui::BeginMenu("Import Options")) {
+        ImportOptions& options = FileLoader::Instance().GetImportOptions();
+        ImGui::MenuItem("Weld Vertices", nullptr, &options.weldVertices);
+        ImGui::BeginDisabled(!options.weldVertices);
+        ImGui::SetNextItemWidth(IMPORT_OPTION_WIDTH);
+        VertexWelder::Tolerance& tolerance = options.weldTolerance;
+        ImGui::DragFloat("Weld Position", &tolerance.position, 1.0e-5f,
+                         0.0f, 1.0f, "%.5f", ImGuiSliderFlags_AlwaysClamp);
+        ImGui::SetNextItemWidth(IMPORT_OPTION_WIDTH);
+        ImGui::DragFloat("Weld Normal", &tolerance.normal, 1.0e-3f, 0.0f,
+                         1.0f, "%.3f", ImGuiSliderFlags_AlwaysClamp);
+        ImGui::SetNextItemWidth(IMPORT_OPTION_WIDTH);
+        ImGui::DragFloat("Weld UV", &tolerance.texCoord, 1.0e-4f, 0.0f,
+                         1.0f, "%.4f", ImGuiSliderFlags_AlwaysClamp);
+        ImGui::EndDisabled();
+        ImGui::MenuItem("Page Large Meshes", nullptr,
+                        &options.pageLargeMeshes);
+        ImGui::MenuItem("Optimize Vertex Order", nullptr,
+                        &options.optimizeMeshes);
+        ImGui::MenuItem("Skip Untextured Tangents", nullptr,
+                        &options.skipUntexturedTangents);
+        ImGui::MenuItem("Build Meshlets", nullptr, &options.buildMeshlets);
+        ImGui::MenuItem("Generate LODs", nullptr, &options.generateLods);
+        ImGui::MenuItem("Build Picking BVH", nullptr, &options.buildBvh);
+        if (ImGui::BeginMenu("CPU Copy")) {
+          MeshResidency& residency = options.residency;
+          if (ImGui::MenuItem("Full", nullptr,
+                              residency == MeshResidency::MIRROR)) {
+            residency = MeshResidency::MIRROR;
+          }
+          if (ImGui::MenuItem("Positions Only", nullptr,
+                              residency == MeshResidency::POSITIONS)) {
+            residency = MeshResidency::POSITIONS;
+          }
+          if (ImGui::MenuItem("None", nullptr,
+                              residency == MeshResidency::RELEASED)) {
+            residency = MeshResidency::RELEASED;
+          }
+          ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("Vertex Format")) {
+          VertexFormat& format = options.vertexFormat;
+          ImGui::MenuItem("16-bit Positions", nullptr,
+                          &format.quantizePositions);
+          ImGui::MenuItem("Octahedral Normals", nullptr,
+                          &format.octahedralNormals);
+          ImGui::MenuItem("Half-float TexCoords", nullptr,
+                          &format.halfTexCoords);
+          ImGui::MenuItem("Omit Unused TexCoords", nullptr,
+                          &options.omitUnusedTexCoords);
+          ImGui::EndMenu();
+        }
+        ImGui::EndMenu();
+      }
       ImGui::EndMenu();
     }
     if (ImGui::BeginMenu("Settings")) {
@@ -221,6 +275,10 @@ void App::renderDockSpaceAndMenu() {
         ImGui::EndMenu();
       }
       ImGui::MenuItem("Background Color", nullptr, &m_bShowBgColorPopup);
+      bool idBuffer = SceneWindow::Instance().IsIdBufferEnabled();
+      if (ImGui::MenuItem("Hover Picking", nullptr, &idBuffer)) {
+        SceneWindow::Instance().SetIdBufferEnabled(idBuffer);
+      }
 
 #ifdef __EMSCRIPTEN__
       ImGui::Separator();
@@ -249,6 +307,7 @@ void App::renderDockSpaceAndMenu() {
 #endif
       ImGui::EndMenu();
     }
+    FileLoader::Instance().RenderImportProgress();
     ImGui::EndMenuBar();
   }
   ImGui::End();
@@ -35,6 +35,7 @@ class App {
   const char* IDBFS_MOUNT_PATH = "/settings";
   const char* IMGUI_SETTING_FILE_PATH = "/settings/imgui.ini";
   const char* APP_STYLE_KEY = "App-Style";
+  const float IMPORT_OPTION_WIDTH = 100.0f;
 
   AppStyle m_Style{AppStyle::DARK};
 
@@ -12,5 +12,8 @@ EMSCRIPTEN_BINDINGS(Constant) {
   emscripten::function("saveImGuiIniFile", &App::SaveImGuiIniFile);
   emscripten::function("loadImGuiIniFile", &App::LoadImGuiIniFile);
   emscripten::function("loadArrayBuffer", &FileLoader::LoadArrayBuffer);
+  emscripten::function("allocImportBuffer", &FileLoader::AllocImportBuffer);
+  emscripten::function("freeImportBuffer", &FileLoader::FreeImportBuffer);
+  emscripten::function("loadImportBuffer", &FileLoader::LoadImportBuffer);
 }
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "buffer.h"
 
 #include "config/gl_config.h"
+#include "gl_state.h"
 
 BufferUPtr Buffer::New(uint32_t bufferType, uint32_t usage, const void* data,
                        size_t stride, size_t count) {
@@ -13,11 +14,33 @@ BufferUPtr Buffer::New(uint32_t bufferType, uint32_t usage, const void* data,
 
 Buffer::~Buffer() {
   if (m_Buffer) {
+    GLState::Instance().OnDeleteBuffer(m_Buffer);
     glDeleteBuffers(1, &m_Buffer);
   }
 }
 
-void Buffer::Bind() const { glBindBuffer(m_BufferType, m_Buffer); }
+void Buffer::Bind() const {
+  GLState::Instance().BindBuffer(m_BufferType, m_Buffer);
+}
+
+void Buffer::SetData(const void* data, size_t count) {
+  m_Count = count;
+  Bind();
+  glBufferData(m_BufferType, m_Stride * m_Count, data, m_Usage);
+}
+
+void Buffer::SetSubData(size_t index, const void* data, size_t count) const {
+  Bind();
+  glBufferSubData(m_BufferType, m_Stride * index, m_Stride * count, data);
+}
+
+void Buffer::GetSubData(size_t index, void* data, size_t count) const {
+  // Bound to the copy target, so that reading an index buffer does not
+  // change the element buffer of the bound vertex layout.
+  GLState::Instance().BindBuffer(GL_COPY_READ_BUFFER, m_Buffer);
+  glGetBufferSubData(GL_COPY_READ_BUFFER, m_Stride * index, m_Stride * count,
+                     data);
+}
 
 bool Buffer::init(uint32_t bufferType, uint32_t usage, const void* data,
                   size_t stride, size_t count) {
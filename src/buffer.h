@@ -14,6 +14,13 @@ class Buffer {
   size_t GetStride() const { return m_Stride; }
   size_t GetCount() const { return m_Count; }
   void Bind() const;
+  // Replace the storage with count elements. The old storage is orphaned,
+  // so draws still reading it do not stall the upload.
+  void SetData(const void* data, size_t count);
+  // Overwrite count elements from element index. The range must fit.
+  void SetSubData(size_t index, const void* data, size_t count) const;
+  // Read count elements from element index back from the GPU
+  void GetSubData(size_t index, void* data, size_t count) const;
 
  private:
   Buffer() = default;
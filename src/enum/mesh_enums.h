@@ -0,0 +1,8 @@
+#pragma once
+
+// CPU-side copy of the geometry which a mesh keeps after upload
+enum class MeshResidency {
+  MIRROR = 0,     // Vertices and indices
+  RELEASED = 1,   // Nothing. Read back from the mesh cache or the GPU.
+  POSITIONS = 2,  // Positions and indices, for CPU queries such as picking
+};
\ No newline at end of file
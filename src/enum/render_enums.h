@@ -0,0 +1,9 @@
+#pragma once
+
+// Pass of a draw item in the render queue, drawn in this order
+// (OPAQUE and TRANSPARENT are macros of wingdi.h)
+enum class RenderPass {
+  OPAQUE_GEOMETRY = 0,       // Front to back, grouped by state
+  TRANSPARENT_GEOMETRY = 1,  // Back to front
+  OVERLAY = 2,               // Drawn last, grouped by state
+};
\ No newline at end of file
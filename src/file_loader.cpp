@@ -1,9 +1,24 @@
 #include "file_loader.h"
 
 #include "config/log_config.h"
+#include "font_manager.h"
+#include "gl_state.h"
+#include "mesh_manager.h"
+#include "thread_pool.h"
+#include "util/path_util.h"
 
 // Standard library
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef __EMSCRIPTEN__
+#include <filesystem>
+#endif
+
+// ImGui
+#include <imgui.h>
 
 // Emscripten
 #ifdef __EMSCRIPTEN__
@@ -18,81 +33,379 @@
 #include "platform/win_helper.h"
 #endif
 
+#if !defined(__EMSCRIPTEN__) && !defined(__APPLE__) && !defined(_WIN32)
+#include "platform/linux_helper.h"
+#endif
+
 FileLoader::FileLoader() {}
 
 FileLoader::~FileLoader() {}
 
-void FileLoader::OpenFileBrowser() {
+void FileLoader::OpenFileBrowser() { openBrowser(false); }
+
+void FileLoader::OpenFolderBrowser() { openBrowser(true); }
+
+void FileLoader::openBrowser(bool folder) {
 #ifdef __EMSCRIPTEN__
-  EM_ASM({
-    let fileInput = document.createElement('input');
-    fileInput.type = 'file';
-    fileInput.multiple = false;  // Get single file. TODO: Get multiple files
-    fileInput.accept = '.obj';   // Set possible extensions
-    fileInput.onchange = () => {
-      if (fileInput.files.length == 0) {
-        return;
-      }
-      const file = fileInput.files[0];  // Get the first file
-      const reader = new FileReader();
-      reader.readAsArrayBuffer(file);
-      reader.onload = () => {
-        const data = new Uint8Array(reader.result);
-
-        // Use ArrayBuffer directly without copying data
-        // FS.createDataFile(parent, name, data, canRead, canWrite, canOwn);
-        // If canOwn is true, the ownership of data is transferred to MemFS
-        Constant.FS.createDataFile('/', file.name, data, true, false, true);
-
-        // deleteFile: The file in MemFS is deleted inside this function.
-        Constant.loadArrayBuffer(file.name, true);
-      };
-    };
-    fileInput.click();
-  });
-#elif defined(__APPLE__)
-  std::vector<std::string> filePaths = MacHelper::OpenFileDialog();
-  for (const auto& filePath : filePaths) {
-    LoadArrayBuffer(filePath, false);
+  EM_ASM(
+      {
+        let fileInput = document.createElement('input');
+        fileInput.type = 'file';
+        fileInput.multiple = true;
+        fileInput.webkitdirectory = $0;  // Folder: Every file below it
+        fileInput.accept = '.obj,.stl,.ply,.gltf,.glb,.cmesh';
+        fileInput.onchange = async () => {
+          const supported = /\.(obj|stl|ply|gltf|glb|cmesh)$/i;
+          const files = Array.from(fileInput.files)
+                            .filter(file => supported.test(file.name));
+
+          // Files are streamed one after another straight into the wasm
+          // heap and handed over as soon as each is complete, so that
+          // parsing overlaps reading.
+          for (const file of files) {
+            const address = Constant.allocImportBuffer(file.size);
+            if (!address) {
+              console.error('Not enough memory for ' + file.name);
+              continue;
+            }
+            try {
+              const reader = file.stream().getReader();
+              let offset = 0;
+              for (;;) {
+                const chunk = await reader.read();
+                if (chunk.done) break;
+                // HEAPU8 is only refreshed on the thread that grew the
+                // heap, and workers grow it while this loop awaits
+                const heap = new Uint8Array(Constant.wasmMemory.buffer);
+                heap.set(chunk.value, address + offset);
+                offset += chunk.value.length;
+              }
+              Constant.loadImportBuffer(file.name, address, offset);
+            } catch (error) {
+              console.error('Failed to read ' + file.name + ': ' + error);
+              Constant.freeImportBuffer(address);
+            }
+          }
+        };
+        fileInput.click();
+      },
+      folder);
+#else
+  std::vector<std::string> paths;
+#if defined(__APPLE__)
+  if (folder) {
+    paths.push_back(MacHelper::OpenFolderDialog());
+  } else {
+    paths = MacHelper::OpenFileDialog();
   }
 #elif defined(_WIN32)
-  std::vector<std::string> filePaths = WinHelper::OpenFileDialog();
-  for (const auto& filePath : filePaths) {
-    LoadArrayBuffer(filePath, false);
+  if (folder) {
+    paths.push_back(WinHelper::OpenFolderDialog());
+  } else {
+    paths = WinHelper::OpenFileDialog();
+  }
+#else
+  if (folder) {
+    paths.push_back(LinuxHelper::OpenFolderDialog());
+  } else {
+    paths = LinuxHelper::OpenFileDialog();
+  }
+#endif
+  for (const auto& path : paths) {
+    if (!path.empty()) {
+      LoadPath(path);
+    }
   }
 #endif
 }
 
 void FileLoader::LoadArrayBuffer(const std::string& fileName, bool deleteFile) {
-  std::ifstream file(fileName, std::ios::binary | std::ios::ate);
-
-  std::string s;
-  if (file.is_open()) {
-    file.seekg(0, std::ios::end);
-    int size = file.tellg();
-    s.resize(size);
-    file.seekg(0, std::ios::beg);
-    file.read(&s[0], size);
-    SPDLOG_INFO("Read {} bytes from {}", size, fileName);
-    SPDLOG_INFO("File content: {}", s);
-  }
-
-  // Check to binary or not
-  // bool isBinary = isBinaryFile(pData, dataLength);
-
-  // if (isBinary)
-  // {
-  //     // TODO: Read binary file
-  // }
-  // else {
-  //     // TODO: Read ascii file
-  // }
-
-  if (deleteFile) {
-    if (std::remove(fileName.c_str()) != 0) {
-      SPDLOG_ERROR("Failed to remove {} in MemFs", fileName);
+  Instance().submitImport(fileName, deleteFile);
+}
+
+#ifdef __EMSCRIPTEN__
+double FileLoader::AllocImportBuffer(double size) {
+  // malloc(0) may return nullptr
+  void* buffer = std::malloc(std::max<size_t>(static_cast<size_t>(size), 1));
+  if (!buffer) {
+    SPDLOG_ERROR("Failed to allocate {} bytes for an import", size);
+  }
+  return static_cast<double>(reinterpret_cast<uintptr_t>(buffer));
+}
+
+void FileLoader::FreeImportBuffer(double address) {
+  std::free(reinterpret_cast<void*>(static_cast<uintptr_t>(address)));
+}
+
+void FileLoader::LoadImportBuffer(const std::string& fileName, double address,
+                                  double size) {
+  auto* data = reinterpret_cast<uint8_t*>(static_cast<uintptr_t>(address));
+  Instance().submitImport(
+      fileName, false,
+      FileView::New(fileName, data, static_cast<size_t>(size)));
+}
+#endif
+
+#ifndef __EMSCRIPTEN__
+void FileLoader::LoadPath(const std::string& path) {
+  namespace fs = std::filesystem;
+  std::error_code error;
+  if (!fs::is_directory(path, error)) {
+    submitImport(path, false);
+    return;
+  }
+
+  // Unsupported files are skipped silently, so that folders of mixed files
+  // can be imported.
+  std::vector<std::string> filePaths;
+  for (fs::recursive_directory_iterator it(
+           path, fs::directory_options::skip_permission_denied, error),
+       end;
+       it != end; it.increment(error)) {
+    if (error) break;
+    if (it->is_regular_file(error) &&
+        MeshImporter::IsSupported(it->path().string())) {
+      filePaths.push_back(it->path().string());
+    }
+  }
+  if (error) {
+    SPDLOG_ERROR("Failed to read folder {}: {}", path, error.message());
+  }
+
+  std::sort(filePaths.begin(), filePaths.end());
+  SPDLOG_INFO("Importing {} files from {}", filePaths.size(), path);
+  for (const auto& filePath : filePaths) {
+    // Caches next to their source files are used by the source import.
+    std::string ext = PathUtil::GetExtension(filePath);
+    if ((ext == ".cmesh" || ext == ".cpage") &&
+        std::binary_search(filePaths.begin(), filePaths.end(),
+                           filePath.substr(0, filePath.size() - 6))) {
+      continue;
+    }
+    submitImport(filePath, false);
+  }
+}
+#endif
+
+void FileLoader::ProcessImports(double timeBudget) {
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+
+  for (const auto& job : m_Jobs) {
+    updatePreview(*job);
+  }
+
+  while (true) {
+    ImportResult result;
+    {
+      std::lock_guard<std::mutex> lock(m_ResultMutex);
+      if (m_Results.empty()) break;
+      result = std::move(m_Results.front());
+      m_Results.pop();
+    }
+    m_Jobs.erase(std::remove(m_Jobs.begin(), m_Jobs.end(), result.job),
+                 m_Jobs.end());
+
+    // The job may have been cancelled after its worker finished.
+    --m_RunningCount;
+    removePreview(*result.job);
+    if (result.scene && !result.job->progress.cancelled) {
+      addScene(*result.scene, result.job->options);
+    }
+
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    if (elapsed.count() >= timeBudget) break;
+  }
+
+  dispatchImports();
+}
+
+void FileLoader::RenderImportProgress() {
+  if (m_Jobs.empty()) return;
+
+  float progress = 0.0f;
+  for (const auto& job : m_Jobs) {
+    progress += job->progress.progress;
+  }
+  progress /= static_cast<float>(m_Jobs.size());
+
+  ImGui::Separator();
+  if (m_Jobs.size() == 1) {
+    ImGui::TextUnformatted(PathUtil::GetFileName(m_Jobs[0]->fileName).c_str());
+  } else {
+    ImGui::Text("Importing %zu files", m_Jobs.size());
+  }
+  ImGui::ProgressBar(progress, ImVec2(PROGRESS_BAR_WIDTH, 0.0f));
+  if (ImGui::IsItemHovered()) {
+    ImGui::BeginTooltip();
+    for (const auto& job : m_Jobs) {
+      ImGui::Text("%s: %.0f%%", job->fileName.c_str(),
+                  job->progress.progress * 100.0f);
+    }
+    ImGui::EndTooltip();
+  }
+  if (ImGui::SmallButton(ICON_FA6_XMARK "  Cancel")) {
+    CancelImports();
+  }
+}
+
+void FileLoader::CancelImports() {
+  for (const auto& job : m_Jobs) {
+    job->progress.cancelled = true;
+    removePreview(*job);
+  }
+
+  // Queued jobs are dropped right away, running ones when their result
+  // comes back.
+  for (const auto& job : m_PendingJobs) {
+    if (job->deleteFile) {
+      std::remove(job->fileName.c_str());
+    }
+    m_Jobs.erase(std::remove(m_Jobs.begin(), m_Jobs.end(), job),
+                 m_Jobs.end());
+  }
+  m_PendingJobs.clear();
+}
+
+void FileLoader::submitImport(const std::string& fileName, bool deleteFile,
+                              FileViewUPtr source) {
+  if (!MeshImporter::IsSupported(fileName)) {
+    SPDLOG_ERROR("Unsupported file format: {}", fileName);
+    if (deleteFile) {
+      std::remove(fileName.c_str());
+    }
+    return;
+  }
+
+  auto job = std::make_shared<ImportJob>();
+  job->fileName = fileName;
+  job->deleteFile = deleteFile;
+  job->source = std::move(source);
+  job->options = m_ImportOptions;
+  m_Jobs.push_back(job);
+  m_PendingJobs.push_back(job);
+  dispatchImports();
+}
+
+void FileLoader::dispatchImports() {
+  while (!m_PendingJobs.empty() && m_RunningCount < getMaxRunningImports()) {
+    ImportJobPtr job = std::move(m_PendingJobs.front());
+    m_PendingJobs.pop_front();
+    ++m_RunningCount;
+    ThreadPool::Instance().Submit([this, job]() { runImport(job); });
+  }
+}
+
+size_t FileLoader::getMaxRunningImports() const {
+  // Each import also splits its own work over the pool, so one file per
+  // thread keeps every thread busy.
+  return std::max<size_t>(ThreadPool::Instance().GetThreadCount(), 1);
+}
+
+void FileLoader::runImport(ImportJobPtr job) {
+  auto scene = std::make_unique<ImportScene>();
+  // Files in MemFS or memory are temporary, so there is no point in caching
+  // them.
+  bool useCache = !job->deleteFile && !job->source;
+  bool imported =
+      MeshImporter::Import(job->fileName, job->options, useCache,
+                           job->progress, *scene, std::move(job->source));
+
+  if (job->deleteFile) {
+    if (std::remove(job->fileName.c_str()) != 0) {
+      SPDLOG_ERROR("Failed to remove {} in MemFs", job->fileName);
+    } else {
+      SPDLOG_DEBUG("Removed {} in MemFs", job->fileName);
+    }
+  }
+
+  ImportResult result;
+  result.job = std::move(job);
+  if (imported) {
+    result.scene = std::move(scene);
+  }
+
+  std::lock_guard<std::mutex> lock(m_ResultMutex);
+  m_Results.push(std::move(result));
+}
+
+void FileLoader::updatePreview(ImportJob& job) {
+  std::vector<std::vector<Vertex>> batches = job.progress.TakePreview();
+  if (batches.empty() || job.progress.cancelled) return;
+
+  if (!job.preview) {
+    job.preview = Mesh::CreateGrowing();
+  }
+  for (const auto& batch : batches) {
+    job.preview->Append(batch);
+  }
+  GLState::Instance().BindVertexArray(0);
+
+  if (job.previewId < 0) {
+    std::string label = PathUtil::GetFileName(job.fileName) + " (loading)";
+    job.previewId = MeshManager::Instance().AddMesh(label.c_str(), job.preview);
+  }
+}
+
+void FileLoader::removePreview(ImportJob& job) {
+  if (job.previewId >= 0) {
+    // The node may have been deleted from the scene tree already.
+    MeshManager::Instance().DeleteMesh(job.previewId);
+  }
+  job.previewId = -1;
+  job.preview.reset();
+}
+
+void FileLoader::addScene(ImportScene& scene, const ImportOptions& options) {
+  MeshManager& meshManager = MeshManager::Instance();
+
+  std::vector<MeshPtr> meshes = scene.CreateMeshes(options);
+  std::vector<RenderMaterialPtr> materials = scene.CreateMaterials();
+  for (size_t i = 0; i < meshes.size(); ++i) {
+    int32_t material = scene.meshes[i].material;
+    if (!meshes[i]) {
+      SPDLOG_ERROR("Failed to create mesh {} from {}", scene.meshes[i].name,
+                   scene.name);
+    } else if (material >= 0) {
+      meshes[i]->SetMaterial(materials[material]);
+    }
+  }
+
+  if (scene.nodes.empty()) {
+    for (size_t i = 0; i < meshes.size(); ++i) {
+      if (meshes[i]) {
+        meshManager.AddMesh(scene.meshes[i].name.c_str(), meshes[i]);
+      }
+    }
+    return;
+  }
+
+  // Nodes with a single mesh become mesh nodes. Other nodes become groups
+  // with their meshes as children.
+  int32_t rootId = meshManager.AddGroup(scene.name.c_str());
+  std::vector<int32_t> nodeIds(scene.nodes.size(), -1);
+  for (size_t i = 0; i < scene.nodes.size(); ++i) {
+    const NodeData& node = scene.nodes[i];
+    int32_t parentId = node.parent >= 0 ? nodeIds[node.parent] : rootId;
+    TreeNode* parent = meshManager.GetTreeNode(parentId);
+
+    int32_t id = -1;
+    if (node.meshes.size() == 1 && meshes[node.meshes[0]]) {
+      id = meshManager.AddMesh(node.name.c_str(), meshes[node.meshes[0]],
+                               parent);
     } else {
-      SPDLOG_DEBUG("Removed {} in MemFs", fileName);
+      id = meshManager.AddGroup(node.name.c_str(), parent);
+      TreeNode* group = meshManager.GetTreeNode(id);
+      for (int32_t mesh : node.meshes) {
+        if (group && meshes[mesh]) {
+          meshManager.AddMesh(scene.meshes[mesh].name.c_str(), meshes[mesh],
+                              group);
+        }
+      }
+    }
+    if (id >= 0) {
+      meshManager.SetLocalTransform(id, node.transform);
     }
+    nodeIds[i] = id;
   }
 }
\ No newline at end of file
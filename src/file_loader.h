@@ -1,17 +1,112 @@
 #pragma once
 
+#include "importer/mesh_importer.h"
 #include "macro/singleton_macro.h"
 
 // Standard library
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
 #include <string>
+#include <vector>
 
 class FileLoader {
   DECLARE_SINGLETON(FileLoader)
 
  public:
+  static constexpr double UPLOAD_TIME_BUDGET = 0.004;  // 4 ms per frame
+
+  // Select one or more mesh files
   void OpenFileBrowser();
+  // Select a folder and import every mesh file below it
+  void OpenFolderBrowser();
 
+  // Files are parsed on the thread pool, at most one file per thread at a
+  // time. The others wait in a queue, so that a large selection does not
+  // hold every parsed file in memory at once. The parsed meshes are uploaded
+  // by ProcessImports() on the main thread as each file finishes.
   // fileName: File name in MemFS
-  // deleteFile: Delete file in MemFS in this function
+  // deleteFile: Delete file in MemFS after it is parsed
   static void LoadArrayBuffer(const std::string& fileName, bool deleteFile);
+
+#ifdef __EMSCRIPTEN__
+  // Upload from the browser without MemFS. JavaScript allocates a buffer in
+  // the wasm heap, streams the file into it, and hands it over. The importer
+  // parses the buffer in place and frees it, so the file is held once.
+  // Addresses and sizes are doubles, which JavaScript numbers hold exactly
+  // with MEMORY64.
+  // Return 0 if the buffer cannot be allocated.
+  static double AllocImportBuffer(double size);
+  // Free a buffer which is not handed over, e.g. after a read error
+  static void FreeImportBuffer(double address);
+  static void LoadImportBuffer(const std::string& fileName, double address,
+                               double size);
+#endif
+
+#ifndef __EMSCRIPTEN__
+  // Import a file, or every supported file below a folder (recursively, in
+  // path order). Used by the file dialogs and the command line.
+  void LoadPath(const std::string& path);
+#endif
+
+  // Create GL meshes for finished imports. Called once per frame on the main
+  // thread. At least one file is created per call, and no more are started
+  // after timeBudget (seconds) has elapsed. Running imports of large files
+  // show a preview of what has been read so far.
+  void ProcessImports(double timeBudget = UPLOAD_TIME_BUDGET);
+
+  // Applied to imports submitted after a change
+  ImportOptions& GetImportOptions() { return m_ImportOptions; }
+
+  // Progress bar and cancel button for the running imports (menu bar)
+  void RenderImportProgress();
+  bool IsImporting() const { return !m_Jobs.empty(); }
+  void CancelImports();
+
+ private:
+  static constexpr float PROGRESS_BAR_WIDTH = 150.0f;
+
+  struct ImportJob {
+    std::string fileName;
+    bool deleteFile{false};
+    FileViewUPtr source;  // Taken by the worker
+    ImportOptions options;
+    ImportProgress progress;
+
+    // Main thread: Preview drawn until the result is added
+    MeshPtr preview;
+    int32_t previewId{-1};
+  };
+  using ImportJobPtr = std::shared_ptr<ImportJob>;
+
+  // Result of a job handed back to the main thread. scene is null if the
+  // import failed or was cancelled.
+  struct ImportResult {
+    ImportJobPtr job;
+    std::unique_ptr<ImportScene> scene;
+  };
+
+  void openBrowser(bool folder);
+  void submitImport(const std::string& fileName, bool deleteFile,
+                    FileViewUPtr source = nullptr);
+  // Start queued jobs while fewer than getMaxRunningImports() are running
+  void dispatchImports();
+  size_t getMaxRunningImports() const;
+  void runImport(ImportJobPtr job);
+  // Append the batches published by a running job to its preview mesh
+  void updatePreview(ImportJob& job);
+  void removePreview(ImportJob& job);
+  // Create the meshes of a scene and add them with its node hierarchy
+  void addScene(ImportScene& scene, const ImportOptions& options);
+
+  // Owned by the main thread
+  ImportOptions m_ImportOptions;
+  std::vector<ImportJobPtr> m_Jobs;          // Queued and running
+  std::deque<ImportJobPtr> m_PendingJobs;    // Not submitted yet
+  size_t m_RunningCount{0};                  // Submitted, result not taken
+
+  // Filled by the workers, drained by ProcessImports()
+  std::mutex m_ResultMutex;
+  std::queue<ImportResult> m_Results;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "framebuffer.h"
 
 #include "config/log_config.h"
+#include "gl_state.h"
 
 FramebufferUPtr Framebuffer::New(
     const std::vector<TexturePtr>& colorAttachments) {
@@ -18,23 +19,24 @@ Framebuffer::~Framebuffer() {
     glDeleteRenderbuffers(1, &m_DepthStencilBuffer);
   }
   if (m_Framebuffer) {
+    GLState::Instance().OnDeleteFramebuffer(m_Framebuffer);
     glDeleteFramebuffers(1, &m_Framebuffer);
   }
 }
 
 void Framebuffer::BindToDefault() {
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);  // Bind to default framebuffer
+  GLState::Instance().BindFramebuffer(0);  // Bind to default framebuffer
 }
 
 void Framebuffer::Bind() const {
-  glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+  GLState::Instance().BindFramebuffer(m_Framebuffer);
 }
 
 bool Framebuffer::initWithColorAttachments(
     const std::vector<TexturePtr>& colorAttachments) {
   m_ColorAttachments = colorAttachments;
   glGenFramebuffers(1, &m_Framebuffer);
-  glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+  Bind();
 
   for (size_t i = 0; i < m_ColorAttachments.size(); ++i) {
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
@@ -0,0 +1,184 @@
+#include "gl_state.h"
+
+#include "config/gl_config.h"
+
+namespace {
+
+constexpr size_t NO_SLOT = SIZE_MAX;
+
+}  // namespace
+
+GLState::GLState() { Invalidate(); }
+
+GLState::~GLState() {}
+
+void GLState::Invalidate() {
+  m_Program = UNKNOWN;
+  m_VertexArray = UNKNOWN;
+  m_Buffers.fill(UNKNOWN);
+  m_UniformRanges.fill(BufferRange());
+  m_ActiveTextureUnit = UNKNOWN;
+  m_Textures.fill(UNKNOWN);
+  m_Framebuffer = UNKNOWN;
+  m_Capabilities.fill(UNKNOWN);
+  m_bViewportKnown = false;
+}
+
+void GLState::UseProgram(uint32_t program) {
+  if (m_Program == program) return;
+  m_Program = program;
+  glUseProgram(program);
+}
+
+void GLState::BindVertexArray(uint32_t vertexArray) {
+  if (m_VertexArray == vertexArray) return;
+  m_VertexArray = vertexArray;
+  m_Buffers[ELEMENT_ARRAY_SLOT] = UNKNOWN;  // State of the vertex array
+  glBindVertexArray(vertexArray);
+}
+
+void GLState::BindBuffer(uint32_t target, uint32_t buffer) {
+  size_t slot = NO_SLOT;
+  switch (target) {
+    case GL_ARRAY_BUFFER:
+      slot = ARRAY_SLOT;
+      break;
+    case GL_ELEMENT_ARRAY_BUFFER:
+      slot = ELEMENT_ARRAY_SLOT;
+      break;
+    case GL_UNIFORM_BUFFER:
+      slot = UNIFORM_SLOT;
+      break;
+    case GL_PIXEL_PACK_BUFFER:
+      slot = PIXEL_PACK_SLOT;
+      break;
+    case GL_PIXEL_UNPACK_BUFFER:
+      slot = PIXEL_UNPACK_SLOT;
+      break;
+    case GL_COPY_READ_BUFFER:
+      slot = COPY_READ_SLOT;
+      break;
+    case GL_COPY_WRITE_BUFFER:
+      slot = COPY_WRITE_SLOT;
+      break;
+    default:
+      break;
+  }
+  if (slot != NO_SLOT) {
+    if (m_Buffers[slot] == buffer) return;
+    m_Buffers[slot] = buffer;
+  }
+  glBindBuffer(target, buffer);
+}
+
+void GLState::BindUniformBufferRange(uint32_t binding, uint32_t buffer,
+                                     size_t offset, size_t size) {
+  if (binding < UNIFORM_BINDING_COUNT) {
+    BufferRange& range = m_UniformRanges[binding];
+    if (range.buffer == buffer && range.offset == offset &&
+        range.size == size) {
+      return;
+    }
+    range = {buffer, offset, size};
+  }
+  m_Buffers[UNIFORM_SLOT] = buffer;
+  glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer,
+                    static_cast<GLintptr>(offset),
+                    static_cast<GLsizeiptr>(size));
+}
+
+void GLState::BindTexture(uint32_t unit, uint32_t texture) {
+  if (unit < TEXTURE_UNIT_COUNT) {
+    if (m_Textures[unit] == texture) return;
+    m_Textures[unit] = texture;
+  }
+  activeTexture(unit);
+  glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLState::SelectTexture(uint32_t texture) {
+  activeTexture(0);
+  if (m_Textures[0] == texture) return;
+  m_Textures[0] = texture;
+  glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLState::activeTexture(uint32_t unit) {
+  if (m_ActiveTextureUnit == unit) return;
+  m_ActiveTextureUnit = unit;
+  glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::BindFramebuffer(uint32_t framebuffer) {
+  if (m_Framebuffer == framebuffer) return;
+  m_Framebuffer = framebuffer;
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GLState::SetEnabled(uint32_t capability, bool enabled) {
+  size_t slot = NO_SLOT;
+  switch (capability) {
+    case GL_DEPTH_TEST:
+      slot = DEPTH_TEST_SLOT;
+      break;
+    case GL_BLEND:
+      slot = BLEND_SLOT;
+      break;
+    case GL_CULL_FACE:
+      slot = CULL_FACE_SLOT;
+      break;
+    default:
+      break;
+  }
+  if (slot != NO_SLOT) {
+    uint32_t value = enabled ? 1 : 0;
+    if (m_Capabilities[slot] == value) return;
+    m_Capabilities[slot] = value;
+  }
+  if (enabled) {
+    glEnable(capability);
+  } else {
+    glDisable(capability);
+  }
+}
+
+void GLState::SetViewport(int32_t x, int32_t y, int32_t width,
+                          int32_t height) {
+  std::array<int32_t, 4> viewport{x, y, width, height};
+  if (m_bViewportKnown && m_Viewport == viewport) return;
+  m_Viewport = viewport;
+  m_bViewportKnown = true;
+  glViewport(x, y, width, height);
+}
+
+void GLState::OnDeleteProgram(uint32_t program) {
+  // A program in use stays in use until another is, so its name is not
+  // reused before then. Forget it anyway.
+  if (m_Program == program) m_Program = UNKNOWN;
+}
+
+void GLState::OnDeleteVertexArray(uint32_t vertexArray) {
+  if (m_VertexArray == vertexArray) {
+    m_VertexArray = 0;
+    m_Buffers[ELEMENT_ARRAY_SLOT] = UNKNOWN;
+  }
+}
+
+void GLState::OnDeleteBuffer(uint32_t buffer) {
+  for (uint32_t& bound : m_Buffers) {
+    if (bound == buffer) bound = 0;
+  }
+  for (BufferRange& range : m_UniformRanges) {
+    if (range.buffer == buffer) range = BufferRange();
+  }
+}
+
+void GLState::OnDeleteTexture(uint32_t texture) {
+  for (uint32_t& bound : m_Textures) {
+    if (bound == texture) bound = 0;
+  }
+}
+
+void GLState::OnDeleteFramebuffer(uint32_t framebuffer) {
+  if (m_Framebuffer == framebuffer) m_Framebuffer = 0;
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "macro/singleton_macro.h"
+
+// Standard library
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Cache of the OpenGL state set through the wrapper classes
+// Each setter compares with the cached value and calls GL only on a change.
+// State that is not known, at start and after Invalidate(), is always set.
+// The element buffer belongs to the vertex array, so it is forgotten when
+// the vertex array changes. The wrappers report deleted objects, which GL
+// unbinds. Main thread only.
+class GLState {
+  DECLARE_SINGLETON(GLState)
+
+ public:
+  static constexpr size_t TEXTURE_UNIT_COUNT = 16;
+  static constexpr size_t UNIFORM_BINDING_COUNT = 16;
+
+  // Forget the cached state, after code that sets GL state on its own (the
+  // ImGui backend, GLFW callbacks)
+  void Invalidate();
+
+  void UseProgram(uint32_t program);
+  void BindVertexArray(uint32_t vertexArray);
+  // Targets other than the vertex, index, uniform, pixel and copy buffers
+  // are passed through
+  void BindBuffer(uint32_t target, uint32_t buffer);
+  // Range of a uniform buffer for a binding point. Also binds the buffer to
+  // GL_UNIFORM_BUFFER, as GL does.
+  void BindUniformBufferRange(uint32_t binding, uint32_t buffer,
+                              size_t offset, size_t size);
+  // Bind a 2D texture to a unit for drawing. The active unit is only changed
+  // if the binding is, so glTex* calls need SelectTexture() instead.
+  void BindTexture(uint32_t unit, uint32_t texture);
+  // Bind a 2D texture to unit 0 and make it active, for glTex* calls
+  void SelectTexture(uint32_t texture);
+  void BindFramebuffer(uint32_t framebuffer);  // Read and draw
+  // Cached for GL_DEPTH_TEST, GL_BLEND and GL_CULL_FACE
+  void SetEnabled(uint32_t capability, bool enabled);
+  void SetViewport(int32_t x, int32_t y, int32_t width, int32_t height);
+
+  // To be called before the objects are deleted
+  void OnDeleteProgram(uint32_t program);
+  void OnDeleteVertexArray(uint32_t vertexArray);
+  void OnDeleteBuffer(uint32_t buffer);
+  void OnDeleteTexture(uint32_t texture);
+  void OnDeleteFramebuffer(uint32_t framebuffer);
+
+ private:
+  static constexpr uint32_t UNKNOWN = UINT32_MAX;
+
+  enum BufferSlot : size_t {
+    ARRAY_SLOT,
+    ELEMENT_ARRAY_SLOT,
+    UNIFORM_SLOT,
+    PIXEL_PACK_SLOT,
+    PIXEL_UNPACK_SLOT,
+    COPY_READ_SLOT,
+    COPY_WRITE_SLOT,
+    BUFFER_SLOT_COUNT
+  };
+  enum CapabilitySlot : size_t {
+    DEPTH_TEST_SLOT,
+    BLEND_SLOT,
+    CULL_FACE_SLOT,
+    CAPABILITY_SLOT_COUNT
+  };
+
+  struct BufferRange {
+    uint32_t buffer{UNKNOWN};
+    size_t offset{0};
+    size_t size{0};
+  };
+
+  uint32_t m_Program{UNKNOWN};
+  uint32_t m_VertexArray{UNKNOWN};
+  std::array<uint32_t, BUFFER_SLOT_COUNT> m_Buffers;
+  std::array<BufferRange, UNIFORM_BINDING_COUNT> m_UniformRanges;
+  uint32_t m_ActiveTextureUnit{UNKNOWN};
+  std::array<uint32_t, TEXTURE_UNIT_COUNT> m_Textures;
+  uint32_t m_Framebuffer{UNKNOWN};
+  std::array<uint32_t, CAPABILITY_SLOT_COUNT> m_Capabilities;  // 0, 1
+  std::array<int32_t, 4> m_Viewport;
+  bool m_bViewportKnown{false};
+
+  void activeTexture(uint32_t unit);
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "image.h"
 
 #include "config/log_config.h"
+#include "util/file_view.h"
 #include "util/path_util.h"
 
 // stb image
@@ -15,6 +16,15 @@ ImageUPtr Image::New(const std::string& filepath, bool flipVertical) {
   return std::move(image);
 }
 
+ImageUPtr Image::New(const uint8_t* data, size_t size, bool flipVertical,
+                     bool isHdr) {
+  auto image = ImageUPtr(new Image());
+  if (!image->decode(data, size, flipVertical, isHdr)) {
+    return nullptr;
+  }
+  return std::move(image);
+}
+
 ImageUPtr Image::New(int32_t width, int32_t height, int32_t channelCount,
                      int32_t bytePerChannel) {
   auto image = ImageUPtr(new Image());
@@ -46,32 +56,48 @@ Image::~Image() {
 }
 
 bool Image::loadWithStb(const std::string& filepath, bool flipVertical) {
-  stbi_set_flip_vertically_on_load(flipVertical);  // Make image upside down
-
   std::string ext = PathUtil::GetExtension(filepath);
   if (ext.empty()) {
     SPDLOG_ERROR("failed to load image: {}", filepath);
     return false;
   }
 
-  if (ext == ".hdr" || ext == ".HDR") {
-    m_Data = (uint8_t*)stbi_loadf(filepath.c_str(), &m_Width, &m_Height,
-                                  &m_ChannelCount, 0);
-    m_BytePerChannel = 4;
-  } else {
-    m_Data =
-        stbi_load(filepath.c_str(), &m_Width, &m_Height, &m_ChannelCount, 0);
-    m_BytePerChannel = 1;
+  // Decode straight from the mapped file
+  FileViewUPtr fileView = FileView::New(filepath);
+  if (!fileView) {
+    return false;
   }
-
-  if (!m_Data) {
+  if (!decode(fileView->GetData(), fileView->GetSize(), flipVertical,
+              ext == ".hdr" || ext == ".HDR")) {
     SPDLOG_ERROR("failed to load image: {}", filepath);
     return false;
   }
-
   return true;
 }
 
+bool Image::decode(const uint8_t* data, size_t size, bool flipVertical,
+                   bool isHdr) {
+  if (size > static_cast<size_t>(INT32_MAX)) {
+    SPDLOG_ERROR("Image data is too large: {} bytes", size);
+    return false;
+  }
+  const stbi_uc* fileData = data;
+  int32_t fileSize = static_cast<int32_t>(size);
+
+  // The flag is per thread, so images can be decoded on workers.
+  stbi_set_flip_vertically_on_load_thread(flipVertical);
+  if (isHdr) {
+    m_Data = (uint8_t*)stbi_loadf_from_memory(
+        fileData, fileSize, &m_Width, &m_Height, &m_ChannelCount, 0);
+    m_BytePerChannel = 4;
+  } else {
+    m_Data = stbi_load_from_memory(fileData, fileSize, &m_Width, &m_Height,
+                                   &m_ChannelCount, 0);
+    m_BytePerChannel = 1;
+  }
+  return m_Data != nullptr;
+}
+
 bool Image::allocate(int32_t width, int32_t height, int32_t channelCount,
                      int32_t bytePerChannel) {
   m_Width = width;
@@ -14,6 +14,11 @@ class Image {
   // Create image from file
   static ImageUPtr New(const std::string& filepath, bool flipVertical = true);
 
+  // Decode an image file in memory, e.g. embedded in a glTF file.
+  // Safe to call from worker threads.
+  static ImageUPtr New(const uint8_t* data, size_t size,
+                       bool flipVertical = true, bool isHdr = false);
+
   // Create empty image
   static ImageUPtr New(int32_t width, int32_t height, int32_t channelCount = 4,
                        int32_t bytePerChannel = 1);
@@ -33,6 +38,8 @@ class Image {
   Image() = default;
 
   bool loadWithStb(const std::string& filepath, bool flipVertical);
+  bool decode(const uint8_t* data, size_t size, bool flipVertical,
+              bool isHdr);
   bool allocate(int32_t width, int32_t height, int32_t channelCount,
                 int32_t bytePerChannel);
 
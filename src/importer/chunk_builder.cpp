@@ -0,0 +1,230 @@
+#include "chunk_builder.h"
+
+#include "../config/log_config.h"
+#include "../mesh_optimizer.h"
+#include "../util/file_view.h"
+#include "vertex_welder.h"
+
+// Standard library
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+// position (3) + normal (3) + texCoord (2) per corner
+constexpr size_t CORNER_FLOAT_COUNT = 8;
+
+}  // namespace
+
+ChunkBuilder::ChunkBuilder(const glm::vec3& boundsMin,
+                           const glm::vec3& boundsMax, size_t triangleCount,
+                           bool attributes)
+    : m_BoundsMin(boundsMin), m_bAttributes(attributes) {
+  m_TriangleFloatCount = attributes ? 3 * CORNER_FLOAT_COUNT : 9;
+
+  // A surface crosses about n^(2/3) of n cells, so n = chunks^1.5 puts
+  // roughly one chunk worth of triangles in each occupied cell.
+  double chunkCount =
+      std::max(1.0, double(triangleCount) / TARGET_CHUNK_TRIANGLES);
+  double cellCount = std::min(std::pow(chunkCount, 1.5),
+                              double(MAX_CELL_COUNT));
+
+  glm::vec3 extent = boundsMax - boundsMin;
+  float maxExtent = std::max({extent.x, extent.y, extent.z, 1.0e-6f});
+  extent = glm::max(extent, glm::vec3(maxExtent * 1.0e-3f));
+  double cellLength =
+      std::cbrt(double(extent.x) * extent.y * extent.z / cellCount);
+  for (int i = 0; i < 3; ++i) {
+    m_GridSize[i] = std::max(1, int(std::ceil(extent[i] / cellLength)));
+    m_CellScale[i] = m_GridSize[i] / extent[i];
+  }
+  m_Cells.resize(size_t(m_GridSize.x) * m_GridSize.y * m_GridSize.z);
+}
+
+ChunkBuilder::~ChunkBuilder() {
+  if (m_SpillFile) {
+    std::fclose(m_SpillFile);
+  }
+  if (!m_SpillPath.empty()) {
+    std::remove(m_SpillPath.c_str());
+  }
+}
+
+bool ChunkBuilder::Open(const std::string& spillPath) {
+  m_SpillPath = spillPath;
+  m_SpillFile = std::fopen(spillPath.c_str(), "wb");
+  if (!m_SpillFile) {
+    SPDLOG_WARN("Failed to create spill file: {}", spillPath);
+    m_SpillPath.clear();
+    return false;
+  }
+  return true;
+}
+
+size_t ChunkBuilder::getCell(const glm::vec3& point) const {
+  glm::ivec3 cell = glm::ivec3((point - m_BoundsMin) * m_CellScale);
+  cell = glm::clamp(cell, glm::ivec3(0), m_GridSize - glm::ivec3(1));
+  return (size_t(cell.z) * m_GridSize.y + cell.y) * m_GridSize.x + cell.x;
+}
+
+void ChunkBuilder::AddTriangle(const Vertex* corners) {
+  glm::vec3 centroid =
+      (corners[0].position + corners[1].position + corners[2].position) /
+      3.0f;
+  Cell& cell = m_Cells[getCell(centroid)];
+  if (cell.pending.empty()) {
+    cell.pending.reserve(BLOCK_TRIANGLES * m_TriangleFloatCount);
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    const Vertex& corner = corners[i];
+    cell.pending.insert(cell.pending.end(), {corner.position.x,
+                                             corner.position.y,
+                                             corner.position.z});
+    if (m_bAttributes) {
+      cell.pending.insert(cell.pending.end(),
+                          {corner.normal.x, corner.normal.y, corner.normal.z,
+                           corner.texCoord.x, corner.texCoord.y});
+    }
+  }
+  ++cell.triangleCount;
+
+  if (cell.pending.size() == BLOCK_TRIANGLES * m_TriangleFloatCount) {
+    size_t written = std::fwrite(cell.pending.data(), sizeof(float),
+                                 cell.pending.size(), m_SpillFile);
+    m_bFailed = m_bFailed || written != cell.pending.size();
+    cell.blocks.push_back(m_SpillSize);
+    m_SpillSize += cell.pending.size() * sizeof(float);
+    cell.pending.clear();
+  }
+}
+
+void ChunkBuilder::readTriangles(const uint8_t* spill, const Cell& cell,
+                                 std::vector<Vertex>& corners) const {
+  corners.clear();
+  corners.reserve(cell.triangleCount * 3);
+  auto append = [&](const float* values, size_t triangleCount) {
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+      Vertex vertex{};
+      vertex.position = glm::vec3(values[0], values[1], values[2]);
+      if (m_bAttributes) {
+        vertex.normal = glm::vec3(values[3], values[4], values[5]);
+        vertex.texCoord = glm::vec2(values[6], values[7]);
+      }
+      values += m_bAttributes ? CORNER_FLOAT_COUNT : 3;
+      corners.push_back(vertex);
+    }
+  };
+
+  for (uint64_t offset : cell.blocks) {
+    append(reinterpret_cast<const float*>(spill + offset), BLOCK_TRIANGLES);
+  }
+  append(cell.pending.data(), cell.pending.size() / m_TriangleFloatCount);
+}
+
+bool ChunkBuilder::writeChunks(const std::vector<Vertex>& corners,
+                               uint32_t* begin, uint32_t* end,
+                               PagedMesh::Writer& writer, bool weld,
+                               const VertexWelder::Tolerance& weldTolerance,
+                               bool computeNormals, bool computeTangents,
+                               bool optimize) {
+  auto getCentroid = [&corners](uint32_t triangle) {
+    return corners[triangle * 3].position + corners[triangle * 3 + 1].position +
+           corners[triangle * 3 + 2].position;
+  };
+
+  size_t triangleCount = end - begin;
+  if (triangleCount > MAX_CHUNK_TRIANGLES) {
+    glm::vec3 boundsMin = getCentroid(*begin);
+    glm::vec3 boundsMax = boundsMin;
+    for (uint32_t* it = begin; it != end; ++it) {
+      boundsMin = glm::min(boundsMin, getCentroid(*it));
+      boundsMax = glm::max(boundsMax, getCentroid(*it));
+    }
+    glm::vec3 extent = boundsMax - boundsMin;
+    int axis = extent.x >= extent.y && extent.x >= extent.z ? 0
+               : extent.y >= extent.z                       ? 1
+                                                            : 2;
+
+    uint32_t* middle = begin + triangleCount / 2;
+    std::nth_element(begin, middle, end, [&](uint32_t a, uint32_t b) {
+      return getCentroid(a)[axis] < getCentroid(b)[axis];
+    });
+    return writeChunks(corners, begin, middle, writer, weld, weldTolerance,
+                       computeNormals, computeTangents, optimize) &&
+           writeChunks(corners, middle, end, writer, weld, weldTolerance,
+                       computeNormals, computeTangents, optimize);
+  }
+
+  std::vector<Vertex> vertices;
+  vertices.reserve(triangleCount * 3);
+  for (uint32_t* it = begin; it != end; ++it) {
+    vertices.insert(vertices.end(), corners.begin() + *it * 3,
+                    corners.begin() + *it * 3 + 3);
+  }
+  std::vector<uint32_t> indices(vertices.size());
+  std::iota(indices.begin(), indices.end(), 0u);
+
+  if (weld) {
+    VertexWelder::Weld(vertices, indices, weldTolerance);
+  }
+  if (computeNormals) {
+    Mesh::ComputeNormals(vertices, indices);
+  }
+  if (computeTangents) {
+    Mesh::ComputeTangents(vertices, indices);
+  }
+  if (optimize) {
+    MeshOptimizer::Optimize(vertices, indices);
+  }
+  return writer.AddChunk(vertices, indices);
+}
+
+bool ChunkBuilder::Finish(PagedMesh::Writer& writer, bool weld,
+                          const VertexWelder::Tolerance& weldTolerance,
+                          bool computeNormals, bool computeTangents,
+                          bool optimize,
+                          const std::function<bool(float)>& progress) {
+  if (!m_SpillFile) {
+    return false;
+  }
+  m_bFailed = m_bFailed || std::fclose(m_SpillFile) != 0;
+  m_SpillFile = nullptr;
+  if (m_bFailed) {
+    SPDLOG_WARN("Failed to write spill file: {}", m_SpillPath);
+    return false;
+  }
+
+  FileViewUPtr spill;
+  if (m_SpillSize > 0) {
+    spill = FileView::New(m_SpillPath);
+    if (!spill) return false;
+  }
+
+  std::vector<Vertex> corners;
+  std::vector<uint32_t> triangles;
+  for (size_t i = 0; i < m_Cells.size(); ++i) {
+    Cell& cell = m_Cells[i];
+    if (cell.triangleCount == 0) continue;
+    if (!progress(float(i) / m_Cells.size())) return false;
+
+    readTriangles(spill ? spill->GetData() : nullptr, cell, corners);
+    for (uint64_t offset : cell.blocks) {
+      spill->ReleasePages(offset,
+                          BLOCK_TRIANGLES * m_TriangleFloatCount *
+                              sizeof(float));
+    }
+    cell = Cell();
+
+    triangles.resize(corners.size() / 3);
+    std::iota(triangles.begin(), triangles.end(), 0u);
+    if (!writeChunks(corners, triangles.data(),
+                     triangles.data() + triangles.size(), writer, weld,
+                     weldTolerance, computeNormals, computeTangents,
+                     optimize)) {
+      return false;
+    }
+  }
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../mesh.h"
+#include "../paged_mesh.h"
+#include "vertex_welder.h"
+
+// Standard library
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// Splits a triangle soup into the spatial chunks of a page file without
+// holding it in memory.
+// - AddTriangle() bins triangles by centroid into a uniform grid over the
+//   bounds. Each cell buffers one block of triangles, and full blocks are
+//   appended to a single spill file.
+// - Finish() reads back one cell at a time, splits cells larger than
+//   MAX_CHUNK_TRIANGLES at the median of their longest axis, then welds,
+//   fills normals, computes tangents, optimizes and writes each chunk.
+// The grid is sized for surfaces, which occupy far fewer cells than the
+// volume holds, and cell buffers are allocated on first use.
+class ChunkBuilder {
+ public:
+  static constexpr size_t TARGET_CHUNK_TRIANGLES = 256 * 1024;
+  static constexpr size_t MAX_CHUNK_TRIANGLES = 2 * TARGET_CHUNK_TRIANGLES;
+  static constexpr size_t BLOCK_TRIANGLES = 512;
+  static constexpr size_t MAX_CELL_COUNT = 32 * 1024;
+
+  // attributes: Keep the normals and texCoords of the corners. Otherwise
+  // only positions are spilled, and normals must be computed in Finish().
+  ChunkBuilder(const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+               size_t triangleCount, bool attributes);
+  ~ChunkBuilder();
+
+  // spillPath: Temporary file, removed by the destructor
+  bool Open(const std::string& spillPath);
+  void AddTriangle(const Vertex* corners);
+
+  // progress: Called with 0 ~ 1 between cells. Return false to cancel.
+  bool Finish(PagedMesh::Writer& writer, bool weld,
+              const VertexWelder::Tolerance& weldTolerance,
+              bool computeNormals, bool computeTangents, bool optimize,
+              const std::function<bool(float)>& progress);
+
+ private:
+  struct Cell {
+    std::vector<float> pending;   // Block being filled
+    std::vector<uint64_t> blocks;  // Offsets of full blocks in the spill file
+    size_t triangleCount{0};
+  };
+
+  glm::vec3 m_BoundsMin;
+  glm::vec3 m_CellScale;  // Cells per unit length
+  glm::ivec3 m_GridSize{1};
+  bool m_bAttributes{false};
+  size_t m_TriangleFloatCount{0};
+  std::vector<Cell> m_Cells;
+
+  std::string m_SpillPath;
+  std::FILE* m_SpillFile{nullptr};
+  uint64_t m_SpillSize{0};
+  bool m_bFailed{false};
+
+  size_t getCell(const glm::vec3& point) const;
+  void readTriangles(const uint8_t* spill, const Cell& cell,
+                     std::vector<Vertex>& corners) const;
+  // Split triangles [begin, end) of corners until each part fits in a chunk
+  bool writeChunks(const std::vector<Vertex>& corners, uint32_t* begin,
+                   uint32_t* end, PagedMesh::Writer& writer, bool weld,
+                   const VertexWelder::Tolerance& weldTolerance,
+                   bool computeNormals, bool computeTangents, bool optimize);
+};
\ No newline at end of file
@@ -0,0 +1,1081 @@
+#include "gltf_reader.h"
+
+#include "../config/log_config.h"
+#include "../thread_pool.h"
+#include "../util/path_util.h"
+
+// Standard library
+#include <algorithm>
+#include <cctype>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+// glm
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+// cereal
+#include <cereal/external/base64.hpp>
+#include <cereal/external/rapidjson/document.h>
+#include <cereal/external/rapidjson/error/en.h>
+
+namespace {
+
+using JsonValue = CEREAL_RAPIDJSON_NAMESPACE::Value;
+using JsonDocument = CEREAL_RAPIDJSON_NAMESPACE::Document;
+
+// GLB: 12-byte header (magic, version, length), then chunks of
+// (length, type, data). The JSON chunk comes first, the BIN chunk second.
+constexpr uint32_t GLB_MAGIC = 0x46546C67;       // "glTF"
+constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;  // "JSON"
+constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;   // "BIN\0"
+constexpr size_t GLB_HEADER_SIZE = 12;
+constexpr size_t GLB_CHUNK_HEADER_SIZE = 8;
+
+// Primitive modes equal the GL primitive types.
+constexpr int64_t MODE_TRIANGLES = GL_TRIANGLES;
+constexpr int64_t MODE_TRIANGLE_FAN = GL_TRIANGLE_FAN;
+
+// Attribute locations of the Vertex layout
+constexpr uint32_t POSITION_LOCATION = 0;
+constexpr uint32_t NORMAL_LOCATION = 1;
+constexpr uint32_t TEXCOORD_LOCATION = 2;
+constexpr uint32_t TANGENT_LOCATION = 3;
+
+// Progress milestones
+constexpr float PARSE_PROGRESS = 0.1f;
+constexpr float IMAGE_PROGRESS = 0.5f;
+constexpr float MESH_PROGRESS = 0.9f;
+
+struct Accessor {
+  int32_t bufferView{-1};  // -1: All zeros
+  size_t byteOffset{0};
+  uint32_t componentType{0};
+  int32_t componentCount{0};
+  size_t count{0};
+  bool normalized{false};
+  std::vector<double> min;
+  std::vector<double> max;
+
+  // Sparse substitution of elements
+  size_t sparseCount{0};
+  int32_t sparseIndexView{-1};
+  size_t sparseIndexOffset{0};
+  uint32_t sparseIndexType{0};
+  int32_t sparseValueView{-1};
+  size_t sparseValueOffset{0};
+};
+
+const JsonValue* GetMember(const JsonValue& object, const char* name) {
+  if (!object.IsObject()) return nullptr;
+  auto it = object.FindMember(name);
+  return it != object.MemberEnd() ? &it->value : nullptr;
+}
+
+const JsonValue* GetArray(const JsonValue& object, const char* name) {
+  const JsonValue* value = GetMember(object, name);
+  return value && value->IsArray() ? value : nullptr;
+}
+
+int64_t GetInt(const JsonValue& object, const char* name,
+               int64_t defaultValue) {
+  const JsonValue* value = GetMember(object, name);
+  return value && value->IsInt64() ? value->GetInt64() : defaultValue;
+}
+
+bool GetBool(const JsonValue& object, const char* name, bool defaultValue) {
+  const JsonValue* value = GetMember(object, name);
+  return value && value->IsBool() ? value->GetBool() : defaultValue;
+}
+
+std::string GetString(const JsonValue& object, const char* name) {
+  const JsonValue* value = GetMember(object, name);
+  if (!value || !value->IsString()) return "";
+  return std::string(value->GetString(), value->GetStringLength());
+}
+
+std::vector<double> GetNumbers(const JsonValue& object, const char* name) {
+  std::vector<double> numbers;
+  if (const JsonValue* array = GetArray(object, name)) {
+    for (auto it = array->Begin(); it != array->End(); ++it) {
+      numbers.push_back(it->IsNumber() ? it->GetDouble() : 0.0);
+    }
+  }
+  return numbers;
+}
+
+size_t GetComponentSize(uint32_t componentType) {
+  switch (componentType) {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+      return 1;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+      return 2;
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+int32_t GetComponentCount(const std::string& type) {
+  if (type == "SCALAR") return 1;
+  if (type == "VEC2") return 2;
+  if (type == "VEC3") return 3;
+  if (type == "VEC4" || type == "MAT2") return 4;
+  if (type == "MAT3") return 9;
+  if (type == "MAT4") return 16;
+  return 0;
+}
+
+// Normalized integers map to [0, 1] or [-1, 1].
+float ReadComponent(const uint8_t* data, uint32_t componentType,
+                    bool normalized) {
+  switch (componentType) {
+    case GL_BYTE: {
+      int8_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return normalized ? std::max(value / 127.0f, -1.0f) : value;
+    }
+    case GL_UNSIGNED_BYTE: {
+      uint8_t value = *data;
+      return normalized ? value / 255.0f : value;
+    }
+    case GL_SHORT: {
+      int16_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+    }
+    case GL_UNSIGNED_SHORT: {
+      uint16_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return normalized ? value / 65535.0f : value;
+    }
+    case GL_UNSIGNED_INT: {
+      uint32_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return static_cast<float>(value);
+    }
+    case GL_FLOAT: {
+      float value;
+      std::memcpy(&value, data, sizeof(value));
+      return value;
+    }
+    default:
+      return 0.0f;
+  }
+}
+
+uint32_t ReadIndex(const uint8_t* data, uint32_t componentType) {
+  switch (componentType) {
+    case GL_UNSIGNED_BYTE:
+      return *data;
+    case GL_UNSIGNED_SHORT: {
+      uint16_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return value;
+    }
+    case GL_UNSIGNED_INT: {
+      uint32_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return value;
+    }
+    default:
+      return 0;
+  }
+}
+
+bool IsIndexType(uint32_t componentType) {
+  return componentType == GL_UNSIGNED_BYTE ||
+         componentType == GL_UNSIGNED_SHORT ||
+         componentType == GL_UNSIGNED_INT;
+}
+
+// Decode "%20" and the like in relative URIs
+std::string DecodeUri(const std::string& uri) {
+  std::string decoded;
+  decoded.reserve(uri.size());
+  for (size_t i = 0; i < uri.size(); ++i) {
+    if (uri[i] == '%' && i + 2 < uri.size() &&
+        std::isxdigit(static_cast<unsigned char>(uri[i + 1])) &&
+        std::isxdigit(static_cast<unsigned char>(uri[i + 2]))) {
+      decoded += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr,
+                                             16));
+      i += 2;
+    } else {
+      decoded += uri[i];
+    }
+  }
+  return decoded;
+}
+
+class GltfLoader {
+ public:
+  GltfLoader(const std::string& fileName, const ImportOptions& options,
+             ImportProgress& progress, ImportScene& scene)
+      : m_FileName(fileName),
+        m_Directory(PathUtil::GetDirectory(fileName)),
+        m_Options(options),
+        m_Progress(progress),
+        m_Scene(scene) {}
+
+  bool Load(FileViewUPtr file) {
+    if (!file) {
+      file = FileView::New(m_FileName);
+    }
+    if (!file) {
+      return false;
+    }
+    if (!parseContainer(*file)) {
+      return false;
+    }
+    m_Scene.files.push_back(std::move(file));
+    m_Progress.progress = PARSE_PROGRESS;
+
+    if (!checkExtensions() || !loadBuffers() || !loadBufferViews() ||
+        !loadAccessors()) {
+      return false;
+    }
+    if (m_Progress.cancelled) return false;
+
+    loadImages();
+    loadMaterials();
+    m_Progress.progress = IMAGE_PROGRESS;
+    if (m_Progress.cancelled) return false;
+
+    if (!loadMeshes()) {
+      return false;
+    }
+    m_Progress.progress = MESH_PROGRESS;
+    if (m_Progress.cancelled) return false;
+
+    loadNodes();
+    return !m_Scene.meshes.empty();
+  }
+
+ private:
+  std::string m_FileName;
+  std::string m_Directory;
+  const ImportOptions& m_Options;
+  ImportProgress& m_Progress;
+  ImportScene& m_Scene;
+
+  JsonDocument m_Document;
+  BufferViewData m_BinChunk;
+  std::vector<BufferViewData> m_Buffers;
+  std::vector<size_t> m_ByteStrides;  // Per buffer view, 0 if not given
+  std::vector<Accessor> m_Accessors;
+  // First mesh of each glTF mesh. Mesh i covers [m_MeshRanges[i],
+  // m_MeshRanges[i + 1]).
+  std::vector<int32_t> m_MeshRanges;
+
+  bool parseContainer(const FileView& file) {
+    const uint8_t* data = file.GetData();
+    size_t size = file.GetSize();
+    const char* json = reinterpret_cast<const char*>(data);
+    size_t jsonSize = size;
+
+    uint32_t magic = 0;
+    if (size >= sizeof(magic)) {
+      std::memcpy(&magic, data, sizeof(magic));
+    }
+    if (magic == GLB_MAGIC) {
+      uint32_t header[3];
+      if (size < GLB_HEADER_SIZE) {
+        SPDLOG_ERROR("Invalid GLB header: {}", m_FileName);
+        return false;
+      }
+      std::memcpy(header, data, sizeof(header));
+      if (header[1] != 2) {
+        SPDLOG_ERROR("Unsupported GLB version ({}): {}", header[1],
+                     m_FileName);
+        return false;
+      }
+      size = std::min<size_t>(size, header[2]);
+
+      json = nullptr;
+      for (size_t offset = GLB_HEADER_SIZE;
+           offset + GLB_CHUNK_HEADER_SIZE <= size;) {
+        uint32_t chunk[2];
+        std::memcpy(chunk, data + offset, sizeof(chunk));
+        offset += GLB_CHUNK_HEADER_SIZE;
+        if (chunk[0] > size - offset) {
+          SPDLOG_ERROR("Truncated GLB chunk: {}", m_FileName);
+          return false;
+        }
+        if (chunk[1] == GLB_CHUNK_JSON && !json) {
+          json = reinterpret_cast<const char*>(data + offset);
+          jsonSize = chunk[0];
+        } else if (chunk[1] == GLB_CHUNK_BIN && !m_BinChunk.data) {
+          m_BinChunk = {data + offset, chunk[0]};
+        }
+        // Chunks are 4-byte aligned
+        offset += (size_t(chunk[0]) + 3) & ~size_t(3);
+      }
+      if (!json) {
+        SPDLOG_ERROR("No JSON chunk in {}", m_FileName);
+        return false;
+      }
+    }
+
+    m_Document.Parse(json, jsonSize);
+    if (m_Document.HasParseError()) {
+      SPDLOG_ERROR("Invalid glTF JSON at {}: {} ({})",
+                   m_Document.GetErrorOffset(),
+                   CEREAL_RAPIDJSON_NAMESPACE::GetParseError_En(
+                       m_Document.GetParseError()),
+                   m_FileName);
+      return false;
+    }
+    if (!m_Document.IsObject()) {
+      SPDLOG_ERROR("Invalid glTF JSON: {}", m_FileName);
+      return false;
+    }
+    return true;
+  }
+
+  // Extensions which change how the data is read cannot be ignored.
+  bool checkExtensions() const {
+    const JsonValue* required = GetArray(m_Document, "extensionsRequired");
+    if (!required) return true;
+
+    for (auto it = required->Begin(); it != required->End(); ++it) {
+      if (!it->IsString()) continue;
+      std::string extension = it->GetString();
+      // Quantized attributes are normalized integers GL reads directly.
+      if (extension != "KHR_mesh_quantization") {
+        SPDLOG_ERROR("Unsupported glTF extension {}: {}", extension,
+                     m_FileName);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool loadUri(const std::string& uri, BufferViewData& bytes) {
+    if (uri.compare(0, 5, "data:") == 0) {
+      size_t comma = uri.find(',');
+      if (comma == std::string::npos ||
+          uri.rfind(";base64", comma) == std::string::npos) {
+        SPDLOG_ERROR("Unsupported data URI in {}", m_FileName);
+        return false;
+      }
+      std::string decoded = cereal::base64::decode(uri.substr(comma + 1));
+      // Moving the outer vector keeps the inner buffers in place.
+      m_Scene.ownedBuffers.emplace_back(decoded.begin(), decoded.end());
+      bytes = {m_Scene.ownedBuffers.back().data(),
+               m_Scene.ownedBuffers.back().size()};
+      return true;
+    }
+
+    FileViewUPtr file = FileView::New(m_Directory + DecodeUri(uri));
+    if (!file) {
+      return false;
+    }
+    bytes = {file->GetData(), file->GetSize()};
+    m_Scene.files.push_back(std::move(file));
+    return true;
+  }
+
+  bool loadBuffers() {
+    const JsonValue* buffers = GetArray(m_Document, "buffers");
+    if (!buffers) return true;
+
+    for (auto it = buffers->Begin(); it != buffers->End(); ++it) {
+      std::string uri = GetString(*it, "uri");
+      int64_t byteLength = GetInt(*it, "byteLength", -1);
+      BufferViewData bytes;
+      if (uri.empty()) {
+        // The first buffer of a GLB file without a URI is the BIN chunk.
+        if (m_Buffers.empty()) {
+          bytes = m_BinChunk;
+        }
+      } else if (!loadUri(uri, bytes)) {
+        return false;
+      }
+      if (byteLength < 0 || static_cast<size_t>(byteLength) > bytes.size) {
+        SPDLOG_ERROR("Buffer {} is shorter than its byteLength: {}",
+                     m_Buffers.size(), m_FileName);
+        return false;
+      }
+      bytes.size = static_cast<size_t>(byteLength);
+      m_Buffers.push_back(bytes);
+    }
+    return true;
+  }
+
+  bool loadBufferViews() {
+    const JsonValue* bufferViews = GetArray(m_Document, "bufferViews");
+    if (!bufferViews) return true;
+
+    for (auto it = bufferViews->Begin(); it != bufferViews->End(); ++it) {
+      int64_t buffer = GetInt(*it, "buffer", -1);
+      int64_t byteOffset = GetInt(*it, "byteOffset", 0);
+      int64_t byteLength = GetInt(*it, "byteLength", -1);
+      int64_t byteStride = GetInt(*it, "byteStride", 0);
+      // Compared without adding, which could overflow
+      if (buffer < 0 || buffer >= static_cast<int64_t>(m_Buffers.size()) ||
+          byteOffset < 0 || byteLength < 0 || byteStride < 0 ||
+          static_cast<uint64_t>(byteOffset) > m_Buffers[buffer].size ||
+          static_cast<uint64_t>(byteLength) >
+              m_Buffers[buffer].size - byteOffset) {
+        SPDLOG_ERROR("Invalid buffer view {}: {}",
+                     m_Scene.bufferViews.size(), m_FileName);
+        return false;
+      }
+      m_Scene.bufferViews.push_back(
+          {m_Buffers[buffer].data + byteOffset,
+           static_cast<size_t>(byteLength)});
+      m_ByteStrides.push_back(static_cast<size_t>(byteStride));
+    }
+    return true;
+  }
+
+  // Check that count elements of elementSize at offset with stride fit in
+  // the buffer view. Divides instead of multiplying, so that a huge count
+  // cannot wrap around.
+  bool isInView(int32_t bufferView, size_t offset, size_t count,
+                size_t elementSize, size_t stride) const {
+    if (bufferView < 0 ||
+        bufferView >= static_cast<int32_t>(m_Scene.bufferViews.size())) {
+      return false;
+    }
+    if (count == 0) return true;
+    const size_t size = m_Scene.bufferViews[bufferView].size;
+    if (offset > size || elementSize > size - offset) return false;
+    return stride == 0 || count - 1 <= (size - offset - elementSize) / stride;
+  }
+
+  size_t getStride(const Accessor& accessor) const {
+    size_t elementSize =
+        GetComponentSize(accessor.componentType) * accessor.componentCount;
+    if (accessor.bufferView < 0) return elementSize;
+    size_t byteStride = m_ByteStrides[accessor.bufferView];
+    return byteStride ? byteStride : elementSize;
+  }
+
+  bool loadAccessors() {
+    const JsonValue* accessors = GetArray(m_Document, "accessors");
+    if (!accessors) return true;
+
+    for (auto it = accessors->Begin(); it != accessors->End(); ++it) {
+      Accessor accessor;
+      accessor.bufferView =
+          static_cast<int32_t>(GetInt(*it, "bufferView", -1));
+      accessor.byteOffset =
+          static_cast<size_t>(std::max<int64_t>(GetInt(*it, "byteOffset", 0),
+                                                0));
+      accessor.componentType =
+          static_cast<uint32_t>(GetInt(*it, "componentType", 0));
+      accessor.componentCount = GetComponentCount(GetString(*it, "type"));
+      accessor.count =
+          static_cast<size_t>(std::max<int64_t>(GetInt(*it, "count", 0), 0));
+      accessor.normalized = GetBool(*it, "normalized", false);
+      accessor.min = GetNumbers(*it, "min");
+      accessor.max = GetNumbers(*it, "max");
+
+      size_t index = m_Accessors.size();
+      size_t componentSize = GetComponentSize(accessor.componentType);
+      size_t elementSize = componentSize * accessor.componentCount;
+      if (elementSize == 0 || accessor.count == 0) {
+        SPDLOG_ERROR("Invalid accessor {}: {}", index, m_FileName);
+        return false;
+      }
+      // The view index is checked before getStride() looks it up
+      if (accessor.bufferView >= 0 &&
+          (accessor.bufferView >= static_cast<int32_t>(m_ByteStrides.size()) ||
+           !isInView(accessor.bufferView, accessor.byteOffset, accessor.count,
+                     elementSize, getStride(accessor)))) {
+        SPDLOG_ERROR("Accessor {} is out of its buffer view: {}", index,
+                     m_FileName);
+        return false;
+      }
+
+      if (const JsonValue* sparse = GetMember(*it, "sparse")) {
+        const JsonValue* indices = GetMember(*sparse, "indices");
+        const JsonValue* values = GetMember(*sparse, "values");
+        if (!indices || !values) {
+          SPDLOG_ERROR("Invalid sparse accessor {}: {}", index, m_FileName);
+          return false;
+        }
+        accessor.sparseCount = static_cast<size_t>(
+            std::max<int64_t>(GetInt(*sparse, "count", 0), 0));
+        accessor.sparseIndexView =
+            static_cast<int32_t>(GetInt(*indices, "bufferView", -1));
+        accessor.sparseIndexOffset = static_cast<size_t>(
+            std::max<int64_t>(GetInt(*indices, "byteOffset", 0), 0));
+        accessor.sparseIndexType =
+            static_cast<uint32_t>(GetInt(*indices, "componentType", 0));
+        accessor.sparseValueView =
+            static_cast<int32_t>(GetInt(*values, "bufferView", -1));
+        accessor.sparseValueOffset = static_cast<size_t>(
+            std::max<int64_t>(GetInt(*values, "byteOffset", 0), 0));
+
+        size_t indexSize = GetComponentSize(accessor.sparseIndexType);
+        if (!IsIndexType(accessor.sparseIndexType) ||
+            !isInView(accessor.sparseIndexView, accessor.sparseIndexOffset,
+                      accessor.sparseCount, indexSize, indexSize) ||
+            !isInView(accessor.sparseValueView, accessor.sparseValueOffset,
+                      accessor.sparseCount, elementSize, elementSize)) {
+          SPDLOG_ERROR("Invalid sparse accessor {}: {}", index, m_FileName);
+          return false;
+        }
+      }
+      m_Accessors.push_back(std::move(accessor));
+    }
+    return true;
+  }
+
+  const Accessor* getAccessor(int64_t index) const {
+    if (index < 0 || index >= static_cast<int64_t>(m_Accessors.size())) {
+      return nullptr;
+    }
+    return &m_Accessors[index];
+  }
+
+  // Read an accessor as floats, componentCount per element, with sparse
+  // elements substituted.
+  std::vector<float> readFloats(const Accessor& accessor) const {
+    const size_t componentCount = accessor.componentCount;
+    const size_t componentSize = GetComponentSize(accessor.componentType);
+    std::vector<float> values(accessor.count * componentCount, 0.0f);
+
+    auto readElement = [&](const uint8_t* data, size_t element) {
+      for (size_t c = 0; c < componentCount; ++c) {
+        values[element * componentCount + c] =
+            ReadComponent(data + c * componentSize, accessor.componentType,
+                          accessor.normalized);
+      }
+    };
+
+    if (accessor.bufferView >= 0) {
+      const uint8_t* data = m_Scene.bufferViews[accessor.bufferView].data +
+                            accessor.byteOffset;
+      const size_t stride = getStride(accessor);
+      for (size_t i = 0; i < accessor.count; ++i) {
+        readElement(data + i * stride, i);
+      }
+    }
+
+    if (accessor.sparseCount > 0) {
+      const uint8_t* indices =
+          m_Scene.bufferViews[accessor.sparseIndexView].data +
+          accessor.sparseIndexOffset;
+      const uint8_t* data = m_Scene.bufferViews[accessor.sparseValueView].data +
+                            accessor.sparseValueOffset;
+      const size_t indexSize = GetComponentSize(accessor.sparseIndexType);
+      const size_t elementSize = componentSize * componentCount;
+      for (size_t i = 0; i < accessor.sparseCount; ++i) {
+        uint32_t element =
+            ReadIndex(indices + i * indexSize, accessor.sparseIndexType);
+        if (element < accessor.count) {
+          readElement(data + i * elementSize, element);
+        }
+      }
+    }
+    return values;
+  }
+
+  std::vector<uint32_t> readIndices(const Accessor& accessor) const {
+    std::vector<float> values;
+    std::vector<uint32_t> indices(accessor.count);
+    if (accessor.sparseCount > 0 || accessor.bufferView < 0) {
+      // Rare enough that float precision (2^24) is accepted here
+      values = readFloats(accessor);
+      for (size_t i = 0; i < accessor.count; ++i) {
+        indices[i] = static_cast<uint32_t>(values[i]);
+      }
+      return indices;
+    }
+
+    const uint8_t* data =
+        m_Scene.bufferViews[accessor.bufferView].data + accessor.byteOffset;
+    const size_t stride = getStride(accessor);
+    for (size_t i = 0; i < accessor.count; ++i) {
+      indices[i] = ReadIndex(data + i * stride, accessor.componentType);
+    }
+    return indices;
+  }
+
+  // Images are decoded in parallel. Images which fail to decode stay empty
+  // and their materials fall back to the base color.
+  void loadImages() {
+    const JsonValue* images = GetArray(m_Document, "images");
+    if (!images) return;
+
+    std::vector<BufferViewData> sources;
+    for (auto it = images->Begin(); it != images->End(); ++it) {
+      BufferViewData bytes;
+      int64_t bufferView = GetInt(*it, "bufferView", -1);
+      std::string uri = GetString(*it, "uri");
+      if (bufferView >= 0 &&
+          bufferView < static_cast<int64_t>(m_Scene.bufferViews.size())) {
+        bytes = m_Scene.bufferViews[bufferView];
+      } else if (!uri.empty()) {
+        loadUri(uri, bytes);
+      }
+      sources.push_back(bytes);
+    }
+
+    // glTF texture coordinates start at the top-left, as stored.
+    m_Scene.images.resize(sources.size());
+    ThreadPool::Instance().ParallelFor(
+        sources.size(), 1, [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            if (!sources[i].data || m_Progress.cancelled) continue;
+            m_Scene.images[i] =
+                Image::New(sources[i].data, sources[i].size, false);
+            if (!m_Scene.images[i]) {
+              SPDLOG_WARN("Failed to decode image {} of {}", i, m_FileName);
+            }
+          }
+        });
+  }
+
+  void loadMaterials() {
+    const JsonValue* materials = GetArray(m_Document, "materials");
+    if (!materials) return;
+
+    const JsonValue* textures = GetArray(m_Document, "textures");
+    for (auto it = materials->Begin(); it != materials->End(); ++it) {
+      MaterialData material;
+      material.name = GetString(*it, "name");
+
+      const JsonValue* pbr = GetMember(*it, "pbrMetallicRoughness");
+      if (pbr) {
+        std::vector<double> factor = GetNumbers(*pbr, "baseColorFactor");
+        if (factor.size() == 4) {
+          material.baseColor = glm::vec4(factor[0], factor[1], factor[2],
+                                         factor[3]);
+        }
+        const JsonValue* textureInfo = GetMember(*pbr, "baseColorTexture");
+        int64_t texture = textureInfo ? GetInt(*textureInfo, "index", -1) : -1;
+        if (textures && texture >= 0 &&
+            texture < static_cast<int64_t>(textures->Size())) {
+          int64_t source = GetInt((*textures)[texture], "source", -1);
+          if (source >= 0 &&
+              source < static_cast<int64_t>(m_Scene.images.size())) {
+            material.image = static_cast<int32_t>(source);
+          }
+        }
+      }
+      m_Scene.materials.push_back(std::move(material));
+    }
+  }
+
+  // GL can read the accessor from its buffer view as it is.
+  bool isDirect(const Accessor& accessor) const {
+    return accessor.bufferView >= 0 && accessor.sparseCount == 0 &&
+           accessor.componentCount <= 4 &&
+           accessor.byteOffset % GetComponentSize(accessor.componentType) ==
+               0;
+  }
+
+  bool isDirectIndex(const Accessor& accessor) const {
+    return isDirect(accessor) && IsIndexType(accessor.componentType) &&
+           m_ByteStrides[accessor.bufferView] == 0;
+  }
+
+  // Every index of a direct index accessor is below vertexCount. Indices
+  // uploaded as they are would otherwise fetch out of range on the GPU.
+  bool isIndexInRange(const Accessor& accessor, size_t vertexCount) const {
+    const uint8_t* data =
+        m_Scene.bufferViews[accessor.bufferView].data + accessor.byteOffset;
+    const size_t stride = getStride(accessor);
+    for (size_t i = 0; i < accessor.count; ++i) {
+      if (ReadIndex(data + i * stride, accessor.componentType) >=
+          vertexCount) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void addAttribute(uint32_t location, const Accessor& accessor,
+                    MeshData& meshData) const {
+    AttributeData attribute;
+    attribute.location = location;
+    attribute.bufferView = accessor.bufferView;
+    attribute.componentCount = accessor.componentCount;
+    attribute.componentType = accessor.componentType;
+    attribute.normalized = accessor.normalized;
+    attribute.stride = m_ByteStrides[accessor.bufferView];
+    attribute.offset = accessor.byteOffset;
+    meshData.attributes.push_back(attribute);
+  }
+
+  void loadDirect(const Accessor& position, const Accessor* normal,
+                  const Accessor* texCoord, const Accessor* tangent,
+                  const Accessor* indices, MeshData& meshData) const {
+    addAttribute(POSITION_LOCATION, position, meshData);
+    if (normal) addAttribute(NORMAL_LOCATION, *normal, meshData);
+    if (texCoord) addAttribute(TEXCOORD_LOCATION, *texCoord, meshData);
+    if (tangent) addAttribute(TANGENT_LOCATION, *tangent, meshData);
+
+    if (indices) {
+      meshData.indexBufferView = indices->bufferView;
+      meshData.indexType = indices->componentType;
+      meshData.indexOffset = indices->byteOffset;
+      meshData.elementCount = indices->count;
+    } else {
+      meshData.elementCount = position.count;
+    }
+
+    // GL buffers are not read back, so a BVH is built from the source
+    std::vector<float> values;
+    if (m_Options.buildBvh && meshData.primitiveType == GL_TRIANGLES) {
+      values = readFloats(position);
+      meshData.bvhPositions.resize(position.count);
+      for (size_t i = 0; i < position.count; ++i) {
+        meshData.bvhPositions[i] = glm::make_vec3(&values[i * 3]);
+      }
+      if (indices) {
+        meshData.bvhIndices = readIndices(*indices);
+      } else {
+        meshData.bvhIndices.resize(position.count);
+        for (size_t i = 0; i < position.count; ++i) {
+          meshData.bvhIndices[i] = static_cast<uint32_t>(i);
+        }
+      }
+    }
+
+    // POSITION requires min and max, but they are not always written.
+    if (position.min.size() == 3 && position.max.size() == 3 &&
+        !position.normalized) {
+      meshData.boundsMin =
+          glm::vec3(position.min[0], position.min[1], position.min[2]);
+      meshData.boundsMax =
+          glm::vec3(position.max[0], position.max[1], position.max[2]);
+      return;
+    }
+    if (values.empty()) values = readFloats(position);
+    meshData.boundsMin = glm::vec3(FLT_MAX);
+    meshData.boundsMax = glm::vec3(-FLT_MAX);
+    for (size_t i = 0; i + 2 < values.size(); i += 3) {
+      glm::vec3 point(values[i], values[i + 1], values[i + 2]);
+      meshData.boundsMin = glm::min(meshData.boundsMin, point);
+      meshData.boundsMax = glm::max(meshData.boundsMax, point);
+    }
+  }
+
+  bool loadConverted(const Accessor& position, const Accessor* normal,
+                     const Accessor* texCoord, const Accessor* indices,
+                     int64_t mode, MeshData& meshData) const {
+    const size_t vertexCount = position.count;
+    std::vector<float> positions = readFloats(position);
+    std::vector<float> normals;
+    std::vector<float> texCoords;
+    if (normal) normals = readFloats(*normal);
+    if (texCoord) texCoords = readFloats(*texCoord);
+
+    std::vector<Vertex>& vertices = meshData.vertices;
+    vertices.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) {
+      Vertex& vertex = vertices[i];
+      vertex.position = glm::make_vec3(&positions[i * position.componentCount]);
+      vertex.normal = glm::vec3(0.0f);
+      if (normal) {
+        vertex.normal = glm::make_vec3(&normals[i * 3]);
+      }
+      vertex.texCoord = glm::vec2(0.0f);
+      if (texCoord) {
+        vertex.texCoord = glm::make_vec2(&texCoords[i * 2]);
+      }
+      vertex.tangent = glm::vec4(0.0f);
+    }
+
+    std::vector<uint32_t> sourceIndices;
+    if (indices) {
+      sourceIndices = readIndices(*indices);
+    } else {
+      sourceIndices.resize(vertexCount);
+      for (size_t i = 0; i < vertexCount; ++i) {
+        sourceIndices[i] = static_cast<uint32_t>(i);
+      }
+    }
+    for (uint32_t index : sourceIndices) {
+      if (index >= vertexCount) {
+        SPDLOG_ERROR("Index out of range in {}", m_FileName);
+        return false;
+      }
+    }
+
+    if (mode < MODE_TRIANGLES) {
+      meshData.indices = std::move(sourceIndices);
+      meshData.primitiveType = static_cast<uint32_t>(mode);
+      return true;
+    }
+
+    // Triangulate strips and fans
+    std::vector<uint32_t>& triangles = meshData.indices;
+    meshData.primitiveType = GL_TRIANGLES;
+    if (mode == MODE_TRIANGLES) {
+      triangles = std::move(sourceIndices);
+      triangles.resize(triangles.size() / 3 * 3);
+    } else {
+      for (size_t i = 2; i < sourceIndices.size(); ++i) {
+        if (mode == MODE_TRIANGLE_FAN) {
+          triangles.insert(triangles.end(), {sourceIndices[0],
+                                             sourceIndices[i - 1],
+                                             sourceIndices[i]});
+        } else if (i % 2 == 0) {
+          triangles.insert(triangles.end(), {sourceIndices[i - 2],
+                                             sourceIndices[i - 1],
+                                             sourceIndices[i]});
+        } else {
+          triangles.insert(triangles.end(), {sourceIndices[i - 1],
+                                             sourceIndices[i - 2],
+                                             sourceIndices[i]});
+        }
+      }
+    }
+    if (triangles.empty()) {
+      return false;
+    }
+
+    // Without normals, glTF asks for flat shading, so triangles do not share
+    // vertices.
+    if (!normal) {
+      std::vector<Vertex> flatVertices(triangles.size());
+      for (size_t i = 0; i < triangles.size(); i += 3) {
+        const Vertex* corners[3] = {&vertices[triangles[i]],
+                                    &vertices[triangles[i + 1]],
+                                    &vertices[triangles[i + 2]]};
+        const glm::vec3& p0 = corners[0]->position;
+        glm::vec3 cross = glm::cross(corners[1]->position - p0,
+                                     corners[2]->position - p0);
+        float length = glm::length(cross);
+        glm::vec3 faceNormal = length > 0.0f ? cross / length : glm::vec3(0.0f);
+        for (size_t corner = 0; corner < 3; ++corner) {
+          flatVertices[i + corner] = *corners[corner];
+          flatVertices[i + corner].normal = faceNormal;
+          triangles[i + corner] = static_cast<uint32_t>(i + corner);
+        }
+      }
+      vertices = std::move(flatVertices);
+    }
+    bool textured = texCoord && meshData.material >= 0 &&
+                    m_Scene.materials[meshData.material].image >= 0;
+    if (textured || !m_Options.skipUntexturedTangents) {
+      Mesh::ComputeTangents(vertices, triangles);
+    }
+    return true;
+  }
+
+  bool loadPrimitive(const JsonValue& primitive, MeshData& meshData) const {
+    const JsonValue* attributes = GetMember(primitive, "attributes");
+    const Accessor* position =
+        attributes ? getAccessor(GetInt(*attributes, "POSITION", -1)) : nullptr;
+    if (!position || position->componentCount != 3) {
+      SPDLOG_WARN("Primitive without positions is skipped: {}", m_FileName);
+      return false;
+    }
+    const Accessor* normal = getAccessor(GetInt(*attributes, "NORMAL", -1));
+    const Accessor* texCoord =
+        getAccessor(GetInt(*attributes, "TEXCOORD_0", -1));
+    const Accessor* tangent = getAccessor(GetInt(*attributes, "TANGENT", -1));
+    int64_t indexAccessor = GetInt(primitive, "indices", -1);
+    const Accessor* indices = getAccessor(indexAccessor);
+    if (indexAccessor >= 0 &&
+        (!indices || indices->componentCount != 1 ||
+         !IsIndexType(indices->componentType))) {
+      SPDLOG_WARN("Primitive with invalid indices is skipped: {}",
+                  m_FileName);
+      return false;
+    }
+    int64_t mode = GetInt(primitive, "mode", MODE_TRIANGLES);
+    if (mode < 0 || mode > MODE_TRIANGLE_FAN) {
+      SPDLOG_WARN("Primitive with invalid mode is skipped: {}", m_FileName);
+      return false;
+    }
+
+    // Attributes of the wrong type or shorter than the positions are
+    // dropped.
+    auto isValid = [position](const Accessor* accessor, int32_t count) {
+      return accessor && accessor->componentCount == count &&
+             accessor->count >= position->count;
+    };
+    if (!isValid(normal, 3)) normal = nullptr;
+    if (!isValid(texCoord, 2)) texCoord = nullptr;
+    if (!isValid(tangent, 4)) tangent = nullptr;
+
+    int64_t material = GetInt(primitive, "material", -1);
+    if (material >= 0 &&
+        material < static_cast<int64_t>(m_Scene.materials.size())) {
+      meshData.material = static_cast<int32_t>(material);
+    }
+
+    // Triangles without normals need flat normals generated.
+    bool direct = isDirect(*position) && (!normal || isDirect(*normal)) &&
+                  (!texCoord || isDirect(*texCoord)) &&
+                  (!tangent || isDirect(*tangent)) &&
+                  (!indices || isDirectIndex(*indices)) &&
+                  (normal || mode < MODE_TRIANGLES);
+    if (direct && indices && !isIndexInRange(*indices, position->count)) {
+      SPDLOG_ERROR("Index out of range in {}", m_FileName);
+      return false;
+    }
+    if (direct) {
+      meshData.primitiveType = static_cast<uint32_t>(mode);
+      loadDirect(*position, normal, texCoord, tangent, indices, meshData);
+      return true;
+    }
+    return loadConverted(*position, normal, texCoord, indices, mode,
+                         meshData);
+  }
+
+  bool loadMeshes() {
+    m_MeshRanges.push_back(0);
+    const JsonValue* meshes = GetArray(m_Document, "meshes");
+    if (!meshes) {
+      SPDLOG_ERROR("No mesh found in {}", m_FileName);
+      return false;
+    }
+
+    for (auto it = meshes->Begin(); it != meshes->End(); ++it) {
+      if (m_Progress.cancelled) return false;
+
+      std::string name = GetString(*it, "name");
+      if (name.empty()) {
+        name = "Mesh " + std::to_string(m_MeshRanges.size() - 1);
+      }
+      if (const JsonValue* primitives = GetArray(*it, "primitives")) {
+        size_t primitiveCount = primitives->Size();
+        for (size_t i = 0; i < primitiveCount; ++i) {
+          MeshData meshData;
+          meshData.name = primitiveCount > 1
+                              ? name + " (" + std::to_string(i) + ")"
+                              : name;
+          if (loadPrimitive((*primitives)[i], meshData)) {
+            m_Scene.meshes.push_back(std::move(meshData));
+          }
+        }
+      }
+      m_MeshRanges.push_back(static_cast<int32_t>(m_Scene.meshes.size()));
+    }
+    return true;
+  }
+
+  glm::mat4 getTransform(const JsonValue& node) const {
+    std::vector<double> matrix = GetNumbers(node, "matrix");
+    if (matrix.size() == 16) {
+      // Column-major, as glm
+      float values[16];
+      std::copy(matrix.begin(), matrix.end(), values);
+      return glm::make_mat4(values);
+    }
+
+    glm::mat4 transform(1.0f);
+    std::vector<double> translation = GetNumbers(node, "translation");
+    std::vector<double> rotation = GetNumbers(node, "rotation");
+    std::vector<double> scale = GetNumbers(node, "scale");
+    if (translation.size() == 3) {
+      transform = glm::translate(
+          transform, glm::vec3(translation[0], translation[1], translation[2]));
+    }
+    if (rotation.size() == 4) {
+      // glTF stores (x, y, z, w), glm::quat takes (w, x, y, z).
+      glm::quat quaternion(static_cast<float>(rotation[3]),
+                           static_cast<float>(rotation[0]),
+                           static_cast<float>(rotation[1]),
+                           static_cast<float>(rotation[2]));
+      transform = transform * glm::mat4_cast(glm::normalize(quaternion));
+    }
+    if (scale.size() == 3) {
+      transform =
+          glm::scale(transform, glm::vec3(scale[0], scale[1], scale[2]));
+    }
+    return transform;
+  }
+
+  // Depth-first from the roots of the default scene, so that parents always
+  // precede their children. A mesh with several primitives gets a child node
+  // per primitive.
+  void loadNodes() {
+    const JsonValue* nodes = GetArray(m_Document, "nodes");
+    if (!nodes) return;
+    const int64_t nodeCount = nodes->Size();
+
+    std::vector<int64_t> roots;
+    const JsonValue* scenes = GetArray(m_Document, "scenes");
+    int64_t sceneIndex = GetInt(m_Document, "scene", 0);
+    if (scenes && sceneIndex >= 0 &&
+        sceneIndex < static_cast<int64_t>(scenes->Size())) {
+      for (double root : GetNumbers((*scenes)[sceneIndex], "nodes")) {
+        roots.push_back(static_cast<int64_t>(root));
+      }
+    } else {
+      // Without scenes, every node which is no child is a root.
+      std::vector<bool> isChild(nodeCount, false);
+      for (int64_t i = 0; i < nodeCount; ++i) {
+        for (double child : GetNumbers((*nodes)[i], "children")) {
+          if (child >= 0 && child < nodeCount) isChild[size_t(child)] = true;
+        }
+      }
+      for (int64_t i = 0; i < nodeCount; ++i) {
+        if (!isChild[i]) roots.push_back(i);
+      }
+    }
+
+    // (glTF node, parent in m_Scene.nodes)
+    std::vector<std::pair<int64_t, int32_t>> stack;
+    for (auto it = roots.rbegin(); it != roots.rend(); ++it) {
+      stack.emplace_back(*it, -1);
+    }
+    std::vector<bool> visited(nodeCount, false);
+    while (!stack.empty()) {
+      auto [index, parent] = stack.back();
+      stack.pop_back();
+      // Cycles and shared nodes are invalid glTF
+      if (index < 0 || index >= nodeCount || visited[index]) continue;
+      visited[index] = true;
+
+      const JsonValue& node = (*nodes)[index];
+      NodeData nodeData;
+      nodeData.name = GetString(node, "name");
+      if (nodeData.name.empty()) {
+        nodeData.name = "Node " + std::to_string(index);
+      }
+      nodeData.parent = parent;
+      nodeData.transform = getTransform(node);
+      int64_t mesh = GetInt(node, "mesh", -1);
+      if (mesh >= 0 && mesh + 1 < static_cast<int64_t>(m_MeshRanges.size())) {
+        for (int32_t i = m_MeshRanges[mesh]; i < m_MeshRanges[mesh + 1]; ++i) {
+          nodeData.meshes.push_back(i);
+        }
+      }
+
+      int32_t nodeId = static_cast<int32_t>(m_Scene.nodes.size());
+      m_Scene.nodes.push_back(std::move(nodeData));
+      std::vector<double> children = GetNumbers(node, "children");
+      for (auto it = children.rbegin(); it != children.rend(); ++it) {
+        stack.emplace_back(static_cast<int64_t>(*it), nodeId);
+      }
+    }
+  }
+};
+
+}  // namespace
+
+bool GltfReader::Read(const std::string& fileName,
+                      const ImportOptions& options, ImportProgress& progress,
+                      ImportScene& scene, FileViewUPtr source) {
+  GltfLoader loader(fileName, options, progress, scene);
+  if (!loader.Load(std::move(source))) {
+    return false;
+  }
+
+  size_t directCount = 0;
+  for (const auto& meshData : scene.meshes) {
+    directCount += !meshData.attributes.empty();
+  }
+  SPDLOG_INFO("Read {} meshes ({} uploaded from buffer views), {} nodes, "
+              "{} materials from {}",
+              scene.meshes.size(), directCount, scene.nodes.size(),
+              scene.materials.size(), fileName);
+  return true;
+}
\ No newline at end of file
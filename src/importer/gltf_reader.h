@@ -0,0 +1,28 @@
+#pragma once
+
+#include "mesh_importer.h"
+
+// Standard library
+#include <string>
+
+// glTF 2.0 reader for .gltf (external or data URI buffers) and .glb files
+// - Buffers are mapped or decoded once and kept in the scene. Primitives
+//   whose accessors GL can read as they are keep pointing at their buffer
+//   views, so the file bytes are uploaded without conversion.
+// - Other primitives (sparse accessors, missing normals) are converted to
+//   Vertex. Strips and fans are triangulated and flat normals are generated.
+// - Attributes: POSITION, NORMAL, TEXCOORD_0 and TANGENT
+// - Materials: baseColorFactor and baseColorTexture. Images are decoded on
+//   the thread pool.
+// - Nodes of the default scene keep their hierarchy and local transforms.
+//   Cameras, skins, animations and morph targets are ignored.
+namespace GltfReader {
+
+// source: The file already in memory. If null, fileName is mapped. External
+// buffers and images are resolved relative to fileName either way.
+// Return false if the file is not a supported glTF file or is cancelled.
+bool Read(const std::string& fileName, const ImportOptions& options,
+          ImportProgress& progress, ImportScene& scene,
+          FileViewUPtr source = nullptr);
+
+}  // namespace GltfReader
\ No newline at end of file
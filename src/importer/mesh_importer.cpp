@@ -0,0 +1,616 @@
+#include "mesh_importer.h"
+
+#include "../config/log_config.h"
+#include "../gl_state.h"
+#include "../mesh_optimizer.h"
+#include "../meshlet_builder.h"
+#include "../render_material.h"
+#include "../texture.h"
+#include "../util/file_view.h"
+#include "../util/path_util.h"
+#include "chunk_builder.h"
+#include "gltf_reader.h"
+#include "obj_parser.h"
+#include "ply_reader.h"
+#include "stl_reader.h"
+#include "vertex_welder.h"
+
+// Standard library
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <functional>
+#include <map>
+
+namespace {
+
+// Each block of a mapped OBJ file is split into chunks which are parsed in
+// parallel. Progress and cancellation are checked between blocks.
+constexpr size_t READ_CHUNK_SIZE = 32 * 1024 * 1024;  // 32 MB
+// Triangles (faces for PLY) of a paged file read between progress updates
+constexpr size_t READ_TRIANGLE_BLOCK = 1024 * 1024;
+
+// Progress milestones
+constexpr float PARSE_PROGRESS = 0.7f;
+constexpr float WELD_PROGRESS = 0.8f;
+constexpr float TANGENT_PROGRESS = 0.9f;
+constexpr float OPTIMIZE_PROGRESS = 0.95f;
+
+std::string GetLowerExtension(const std::string& fileName) {
+  std::string ext = PathUtil::GetExtension(fileName);
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  return ext;
+}
+
+// Spill file of a ChunkBuilder, unique to the import so that concurrent
+// imports of one file do not share it
+std::string GetSpillPath(const std::string& fileName) {
+  return PathUtil::GetUniquePath(PagedMesh::GetPagePath(fileName)) + ".spill";
+}
+
+// Stride which keeps the preview of triangleCount triangles within budget
+size_t GetPreviewStride(size_t triangleCount) {
+  return std::max<size_t>(
+      (triangleCount + ImportProgress::PREVIEW_TRIANGLE_COUNT - 1) /
+          ImportProgress::PREVIEW_TRIANGLE_COUNT,
+      1);
+}
+
+void AddPreviewTriangle(const glm::vec3& p0, const glm::vec3& p1,
+                        const glm::vec3& p2, std::vector<Vertex>& corners) {
+  glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+  float length = glm::length(normal);
+  normal = length > 0.0f ? normal / length : glm::vec3(0.0f);
+  for (const glm::vec3* position : {&p0, &p1, &p2}) {
+    corners.push_back(
+        Vertex{*position, normal, glm::vec2(0.0f), glm::vec4(0.0f)});
+  }
+}
+
+// Publish the triangles of [begin, end) whose index is a multiple of stride,
+// with flat normals
+void PublishPreview(const std::vector<Vertex>& vertices,
+                    const std::vector<uint32_t>& indices, size_t begin,
+                    size_t end, size_t stride, ImportProgress& progress) {
+  std::vector<Vertex> corners;
+  for (size_t i = (begin + stride - 1) / stride * stride; i < end;
+       i += stride) {
+    AddPreviewTriangle(vertices[indices[i * 3]].position,
+                       vertices[indices[i * 3 + 1]].position,
+                       vertices[indices[i * 3 + 2]].position, corners);
+  }
+  if (!corners.empty()) {
+    progress.PublishPreview(std::move(corners));
+  }
+}
+
+// Parse the mapped OBJ file block by block. Pages of parsed blocks are
+// released, so only the parsed attributes and the output vertices grow with
+// the file size. The triangle count is estimated from the first block, and
+// large files publish a preview after each block.
+bool ParseObj(const FileView& fileView, ImportProgress& progress,
+              MeshData& meshData) {
+  ObjParser parser;
+  const char* data = fileView.GetString().data();
+  size_t fileSize = fileView.GetSize();
+  size_t previewStride = 0;  // 0: Not decided yet
+  size_t previewEnd = 0;
+  for (size_t offset = 0; offset < fileSize; offset += READ_CHUNK_SIZE) {
+    if (progress.cancelled) return false;
+
+    size_t size = std::min(READ_CHUNK_SIZE, fileSize - offset);
+    parser.Feed(data + offset, size);
+    fileView.ReleasePages(offset, size);
+    progress.progress = PARSE_PROGRESS * (offset + size) / fileSize;
+
+    size_t triangleCount = parser.GetIndices().size() / 3;
+    if (previewStride == 0 && triangleCount > 0) {
+      size_t estimatedCount = static_cast<size_t>(
+          double(triangleCount) * fileSize / (offset + size));
+      bool large =
+          estimatedCount >= ImportProgress::PREVIEW_MIN_TRIANGLE_COUNT;
+      previewStride = large ? GetPreviewStride(estimatedCount) : SIZE_MAX;
+    }
+    if (previewStride != SIZE_MAX && offset + size < fileSize) {
+      PublishPreview(parser.GetVertices(), parser.GetIndices(), previewEnd,
+                     triangleCount, previewStride, progress);
+      previewEnd = triangleCount;
+    }
+  }
+
+  if (!parser.Finish(meshData.vertices, meshData.indices)) {
+    SPDLOG_ERROR("No triangle found in {}", fileView.GetPath());
+    return false;
+  }
+  return true;
+}
+
+// Write the chunks of builder to the page file next to the source and open it
+bool BuildPagedMesh(const std::string& fileName, ChunkBuilder& builder,
+                    const ImportOptions& options, bool weld,
+                    bool computeNormals, float progressBegin,
+                    ImportProgress& progress, MeshData& meshData) {
+  std::string pagePath = PagedMesh::GetPagePath(fileName);
+  PagedMesh::Writer writer;
+  bool built =
+      writer.Open(pagePath) &&
+      builder.Finish(writer, weld, options.weldTolerance, computeNormals,
+                     !options.skipUntexturedTangents, options.optimizeMeshes,
+                     [&](float value) {
+                       progress.progress =
+                           progressBegin + (1.0f - progressBegin) * value;
+                       return !progress.cancelled;
+                     }) &&
+      writer.Close(fileName, options.GetHash());
+  if (!built) return false;
+
+  meshData.paged = PagedMesh::New(pagePath);
+  return meshData.paged != nullptr;
+}
+
+// Split a large binary STL into a page file straight from the mapped file.
+// Only the chunk being built is held in memory.
+bool PageStl(const std::string& fileName, const FileView& fileView,
+             const ImportOptions& options, ImportProgress& progress,
+             MeshData& meshData) {
+  const size_t triangleCount = StlReader::GetTriangleCount(fileView);
+  auto forEachBlock = [&](float progressBegin, float progressEnd,
+                          const std::function<void(const glm::vec3*)>& func) {
+    for (size_t i = 0; i < triangleCount; i += READ_TRIANGLE_BLOCK) {
+      if (progress.cancelled) return false;
+      size_t end = std::min(i + READ_TRIANGLE_BLOCK, triangleCount);
+      StlReader::ForEachTriangle(fileView, i, end, func);
+      progress.progress = progressBegin + (progressEnd - progressBegin) *
+                                              end / triangleCount;
+    }
+    return true;
+  };
+
+  glm::vec3 boundsMin(FLT_MAX);
+  glm::vec3 boundsMax(-FLT_MAX);
+  bool read = forEachBlock(0.0f, 0.1f, [&](const glm::vec3* positions) {
+    for (int i = 0; i < 3; ++i) {
+      boundsMin = glm::min(boundsMin, positions[i]);
+      boundsMax = glm::max(boundsMax, positions[i]);
+    }
+  });
+  if (!read) return false;
+
+  // Facet normals are recomputed from the corners in each chunk.
+  ChunkBuilder builder(boundsMin, boundsMax, triangleCount, false);
+  if (!builder.Open(GetSpillPath(fileName))) {
+    return false;
+  }
+  // Every stride-th triangle goes to the preview while binning.
+  const size_t previewStride = GetPreviewStride(triangleCount);
+  size_t triangle = 0;
+  std::vector<Vertex> preview;
+  Vertex corners[3] = {};
+  read = forEachBlock(0.1f, PARSE_PROGRESS, [&](const glm::vec3* positions) {
+    for (int i = 0; i < 3; ++i) {
+      corners[i].position = positions[i];
+    }
+    builder.AddTriangle(corners);
+
+    if (triangle++ % previewStride == 0) {
+      AddPreviewTriangle(positions[0], positions[1], positions[2], preview);
+    }
+    bool blockEnd =
+        triangle % READ_TRIANGLE_BLOCK == 0 || triangle == triangleCount;
+    if (blockEnd && !preview.empty()) {
+      progress.PublishPreview(std::move(preview));
+      preview = std::vector<Vertex>();
+    }
+  });
+  if (!read) return false;
+
+  SPDLOG_INFO("Paging {} triangles of {}", triangleCount, fileName);
+  return BuildPagedMesh(fileName, builder, options, options.weldVertices,
+                        true, PARSE_PROGRESS, progress, meshData);
+}
+
+// Split a large binary PLY into a page file straight from the mapped file.
+// Corners keep their attributes and are welded again in each chunk, so that
+// only the chunk being built is held in memory.
+bool PagePly(const std::string& fileName, const FileView& fileView,
+             const ImportOptions& options, ImportProgress& progress,
+             MeshData& meshData) {
+  glm::vec3 boundsMin;
+  glm::vec3 boundsMax;
+  bool hasNormals = false;
+  if (!PlyReader::GetBounds(fileView, boundsMin, boundsMax, hasNormals)) {
+    return false;
+  }
+  progress.progress = 0.1f;
+
+  const size_t faceCount = PlyReader::GetFaceCount(fileView);
+  ChunkBuilder builder(boundsMin, boundsMax, faceCount, true);
+  if (!builder.Open(GetSpillPath(fileName))) {
+    return false;
+  }
+  // Every stride-th triangle goes to the preview while binning.
+  const size_t previewStride = GetPreviewStride(faceCount);
+  size_t triangle = 0;
+  std::vector<Vertex> preview;
+  bool read = PlyReader::ForEachTriangle(
+      fileView, READ_TRIANGLE_BLOCK,
+      [&](size_t faces) {
+        if (!preview.empty()) {
+          progress.PublishPreview(std::move(preview));
+          preview = std::vector<Vertex>();
+        }
+        progress.progress =
+            0.1f + (PARSE_PROGRESS - 0.1f) * faces / faceCount;
+        return !progress.cancelled;
+      },
+      [&](const Vertex* corners) {
+        builder.AddTriangle(corners);
+        if (triangle++ % previewStride == 0) {
+          AddPreviewTriangle(corners[0].position, corners[1].position,
+                             corners[2].position, preview);
+        }
+      });
+  if (!read) return false;
+
+  // Shared corners are only merged again by welding
+  SPDLOG_INFO("Paging {} triangles of {}", triangle, fileName);
+  return BuildPagedMesh(fileName, builder, options, true, !hasNormals,
+                        PARSE_PROGRESS, progress, meshData);
+}
+
+// Split an imported mesh into a page file. The vertices are already welded
+// and have normals, so chunks only weld their exact duplicates again.
+bool PageMeshData(const std::string& fileName, const ImportOptions& options,
+                  ImportProgress& progress, MeshData& meshData) {
+  glm::vec3 boundsMin = meshData.vertices.front().position;
+  glm::vec3 boundsMax = boundsMin;
+  for (const auto& vertex : meshData.vertices) {
+    boundsMin = glm::min(boundsMin, vertex.position);
+    boundsMax = glm::max(boundsMax, vertex.position);
+  }
+
+  const size_t triangleCount = meshData.indices.size() / 3;
+  ChunkBuilder builder(boundsMin, boundsMax, triangleCount, true);
+  if (!builder.Open(GetSpillPath(fileName))) {
+    return false;
+  }
+  for (size_t i = 0; i < triangleCount; ++i) {
+    const uint32_t* triangle = &meshData.indices[i * 3];
+    Vertex corners[3] = {meshData.vertices[triangle[0]],
+                         meshData.vertices[triangle[1]],
+                         meshData.vertices[triangle[2]]};
+    builder.AddTriangle(corners);
+  }
+  meshData.vertices = std::vector<Vertex>();
+  meshData.indices = std::vector<uint32_t>();
+
+  SPDLOG_INFO("Paging {} triangles of {}", triangleCount, fileName);
+  return BuildPagedMesh(fileName, builder, options, true, false,
+                        WELD_PROGRESS, progress, meshData);
+}
+
+// Parse a source file, then weld, fill missing normals and compute tangents.
+bool ImportSource(const std::string& fileName, const std::string& ext,
+                  const ImportOptions& options, bool useCache,
+                  ImportProgress& progress, MeshData& meshData,
+                  FileViewUPtr fileView) {
+  std::string cachePath = MeshCache::GetCachePath(fileName);
+  bool page = useCache && options.pageLargeMeshes;
+  if (page) {
+    meshData.paged = PagedMesh::New(PagedMesh::GetPagePath(fileName),
+                                    fileName, options.GetHash());
+    if (meshData.paged) {
+      SPDLOG_INFO("Loading {} from page file", fileName);
+      return true;
+    }
+  }
+  if (useCache) {
+    meshData.cache = MeshCache::New(cachePath, fileName, options.GetHash());
+    if (meshData.cache) {
+      SPDLOG_INFO("Loading {} from mesh cache", fileName);
+      meshData.cachePath = cachePath;
+      return true;
+    }
+  }
+
+  if (!fileView) {
+    fileView = FileView::New(fileName, true);
+  }
+  if (!fileView) {
+    return false;
+  }
+  if (page && ext == ".stl" &&
+      StlReader::GetTriangleCount(*fileView) >=
+          ImportOptions::PAGED_TRIANGLE_COUNT) {
+    return PageStl(fileName, *fileView, options, progress, meshData);
+  }
+  if (page && ext == ".ply" &&
+      PlyReader::GetFaceCount(*fileView) >=
+          ImportOptions::PAGED_TRIANGLE_COUNT) {
+    return PagePly(fileName, *fileView, options, progress, meshData);
+  }
+
+  // STL and PLY vertices without normals get smooth normals after welding.
+  // Without welding, STL keeps the flat facet normals.
+  bool hasNormals = true;
+  bool parsed = false;
+  if (ext == ".obj") {
+    parsed = ParseObj(*fileView, progress, meshData);
+  } else if (ext == ".stl") {
+    hasNormals = !options.weldVertices;
+    parsed = StlReader::Read(*fileView, hasNormals, meshData.vertices,
+                             meshData.indices);
+  } else if (ext == ".ply") {
+    parsed = PlyReader::Read(*fileView, meshData.vertices, meshData.indices,
+                             hasNormals);
+  }
+  if (!parsed || progress.cancelled) return false;
+  SPDLOG_INFO("Read {} vertices, {} triangles from {}",
+              meshData.vertices.size(), meshData.indices.size() / 3, fileName);
+  progress.progress = PARSE_PROGRESS;
+
+  // OBJ files publish their preview while parsing.
+  size_t triangleCount = meshData.indices.size() / 3;
+  if (ext != ".obj" &&
+      triangleCount >= ImportProgress::PREVIEW_MIN_TRIANGLE_COUNT) {
+    PublishPreview(meshData.vertices, meshData.indices, 0, triangleCount,
+                   GetPreviewStride(triangleCount), progress);
+  }
+
+  if (options.weldVertices) {
+    size_t vertexCount = meshData.vertices.size();
+    VertexWelder::Weld(meshData.vertices, meshData.indices,
+                       options.weldTolerance);
+    SPDLOG_INFO("Welded {} vertices into {}", vertexCount,
+                meshData.vertices.size());
+  }
+  if (!hasNormals) {
+    Mesh::ComputeNormals(meshData.vertices, meshData.indices);
+  }
+  progress.progress = WELD_PROGRESS;
+  if (progress.cancelled) return false;
+
+  if (page &&
+      meshData.indices.size() / 3 >= ImportOptions::PAGED_TRIANGLE_COUNT) {
+    return PageMeshData(fileName, options, progress, meshData);
+  }
+
+  // Tangents are computed here so that they are stored in the cache. These
+  // formats have no materials, so their meshes are untextured.
+  if (!options.skipUntexturedTangents) {
+    Mesh::ComputeTangents(meshData.vertices, meshData.indices);
+  }
+  progress.progress = TANGENT_PROGRESS;
+  if (progress.cancelled) return false;
+
+  if (options.optimizeMeshes) {
+    size_t vertexCount = meshData.vertices.size();
+    MeshOptimizer::Statistics before =
+        MeshOptimizer::Analyze(meshData.indices, vertexCount);
+    MeshOptimizer::Optimize(meshData.vertices, meshData.indices);
+    MeshOptimizer::Statistics after =
+        MeshOptimizer::Analyze(meshData.indices, meshData.vertices.size());
+    SPDLOG_INFO("Optimized {}: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+                fileName, before.acmr, after.acmr, before.atvr, after.atvr);
+  }
+  if (options.buildMeshlets) {
+    meshData.meshlets =
+        MeshletBuilder::Build(meshData.vertices, meshData.indices);
+    SPDLOG_INFO("Split {} into {} meshlets", fileName,
+                meshData.meshlets.size());
+  }
+  progress.progress = OPTIMIZE_PROGRESS;
+  if (progress.cancelled) return false;
+
+  if (useCache &&
+      MeshCache::Write(cachePath, fileName, meshData.vertices,
+                       meshData.indices, GL_TRIANGLES, options.GetHash(),
+                       meshData.meshlets)) {
+    meshData.cachePath = cachePath;
+  }
+  return true;
+}
+
+bool ImportPagedMesh(const std::string& fileName, MeshData& meshData) {
+  meshData.paged = PagedMesh::New(fileName);
+  if (!meshData.paged) {
+    SPDLOG_ERROR("Failed to open page file: {}", fileName);
+    return false;
+  }
+  return true;
+}
+
+bool ImportMeshCache(const std::string& fileName, MeshData& meshData,
+                     FileViewUPtr fileView) {
+  if (fileView) {
+    meshData.cache = MeshCache::New(std::move(fileView));
+  } else {
+    meshData.cache = MeshCache::New(fileName);
+    meshData.cachePath = fileName;
+  }
+  if (!meshData.cache) {
+    SPDLOG_ERROR("Failed to open mesh cache: {}", fileName);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+void ImportProgress::PublishPreview(std::vector<Vertex>&& corners) {
+  std::lock_guard<std::mutex> lock(m_PreviewMutex);
+  m_PreviewBatches.push_back(std::move(corners));
+}
+
+std::vector<std::vector<Vertex>> ImportProgress::TakePreview() {
+  std::vector<std::vector<Vertex>> batches;
+  std::lock_guard<std::mutex> lock(m_PreviewMutex);
+  batches.swap(m_PreviewBatches);
+  return batches;
+}
+
+uint64_t ImportOptions::GetHash() const {
+  // FNV-1a over the options that change the imported geometry
+  uint64_t hash = 0xcbf29ce484222325ull;
+  auto combine = [&hash](uint64_t value) {
+    hash = (hash ^ value) * 0x100000001b3ull;
+  };
+
+  combine(weldVertices);
+  for (float tolerance : {weldTolerance.position, weldTolerance.normal,
+                          weldTolerance.texCoord}) {
+    uint32_t toleranceBits = 0;
+    if (weldVertices) {
+      std::memcpy(&toleranceBits, &tolerance, sizeof(toleranceBits));
+    }
+    combine(toleranceBits);
+  }
+  combine(optimizeMeshes);
+  combine(skipUntexturedTangents);
+  combine(buildMeshlets);
+  return hash;
+}
+
+std::vector<MeshPtr> ImportScene::CreateMeshes(const ImportOptions& options) {
+  // Buffer views are uploaded once per target, however many meshes use them.
+  std::map<std::pair<int32_t, uint32_t>, BufferPtr> buffers;
+  auto getBuffer = [this, &buffers](int32_t bufferView, uint32_t target) {
+    BufferPtr& buffer = buffers[{bufferView, target}];
+    if (!buffer) {
+      // The element buffer binding is stored in the bound vertex layout, so
+      // no layout may be bound while shared buffers are created.
+      GLState::Instance().BindVertexArray(0);
+      const BufferViewData& bytes = bufferViews[bufferView];
+      buffer = Buffer::New(target, GL_STATIC_DRAW, bytes.data, 1, bytes.size);
+    }
+    return buffer;
+  };
+
+  std::vector<MeshPtr> result;
+  for (auto& meshData : meshes) {
+    VertexFormat format = options.vertexFormat;
+    bool textured = meshData.material >= 0 &&
+                    materials[meshData.material].image >= 0;
+    if (options.omitUnusedTexCoords && !textured) {
+      format.texCoords = false;
+    }
+
+    MeshPtr mesh;
+    if (meshData.paged) {
+      meshData.paged->SetVertexFormat(format);
+      mesh = Mesh::New(std::move(meshData.paged));
+    } else if (meshData.cache) {
+      mesh = meshData.cache->CreateMesh(format);
+    } else if (!meshData.attributes.empty()) {
+      std::vector<MeshAttribute> attributes;
+      for (const auto& attribute : meshData.attributes) {
+        attributes.push_back(
+            {attribute.location,
+             getBuffer(attribute.bufferView, GL_ARRAY_BUFFER),
+             attribute.componentCount, attribute.componentType,
+             attribute.normalized, attribute.stride, attribute.offset});
+      }
+      BufferPtr indexBuffer;
+      if (meshData.indexBufferView >= 0) {
+        indexBuffer =
+            getBuffer(meshData.indexBufferView, GL_ELEMENT_ARRAY_BUFFER);
+      }
+      GLState::Instance().BindVertexArray(0);
+      mesh = Mesh::New(attributes, indexBuffer, meshData.indexType,
+                       meshData.indexOffset, meshData.elementCount,
+                       meshData.primitiveType, meshData.boundsMin,
+                       meshData.boundsMax);
+    } else {
+      // Tangents are computed by the importer
+      mesh = Mesh::New(std::move(meshData.vertices),
+                       std::move(meshData.indices), meshData.primitiveType,
+                       false, format);
+      if (mesh) {
+        mesh->SetMeshlets(meshData.meshlets.data(), meshData.meshlets.size());
+      }
+    }
+    if (mesh) {
+      mesh->SetCachePath(meshData.cachePath);
+      mesh->SetResidency(options.residency);
+      if (options.generateLods) {
+        mesh->BuildLods();
+      }
+      if (options.buildBvh && !meshData.attributes.empty()) {
+        mesh->BuildBvh(std::move(meshData.bvhPositions),
+                       std::move(meshData.bvhIndices));
+      } else if (options.buildBvh) {
+        mesh->BuildBvh();
+      }
+    }
+    result.push_back(mesh);
+  }
+  GLState::Instance().BindVertexArray(0);
+  return result;
+}
+
+std::vector<RenderMaterialPtr> ImportScene::CreateMaterials() {
+  std::vector<TexturePtr> textures(images.size());
+  for (size_t i = 0; i < images.size(); ++i) {
+    if (images[i]) {
+      textures[i] = Texture::New(images[i].get());
+    }
+  }
+
+  std::vector<RenderMaterialPtr> result;
+  for (const auto& material : materials) {
+    TexturePtr texture;
+    if (material.image >= 0) {
+      texture = textures[material.image];
+    }
+    RenderMaterialPtr renderMaterial = RenderMaterial::New(texture, nullptr);
+    renderMaterial->SetDiffuseColor(glm::vec3(material.baseColor));
+    renderMaterial->SetUseDiffuseTexture(texture != nullptr);
+    result.push_back(renderMaterial);
+  }
+  return result;
+}
+
+bool MeshImporter::IsSupported(const std::string& fileName) {
+  std::string ext = GetLowerExtension(fileName);
+  return ext == ".obj" || ext == ".stl" || ext == ".ply" ||
+         ext == ".gltf" || ext == ".glb" || ext == ".cmesh" ||
+         ext == ".cpage";
+}
+
+bool MeshImporter::Import(const std::string& fileName,
+                          const ImportOptions& options, bool useCache,
+                          ImportProgress& progress, ImportScene& scene,
+                          FileViewUPtr source) {
+  scene.name = PathUtil::GetFileName(fileName);
+
+  bool imported = false;
+  std::string ext = GetLowerExtension(fileName);
+  if (ext == ".gltf" || ext == ".glb") {
+    // glTF buffer views are uploaded as they are, so there is no cache.
+    imported = GltfReader::Read(fileName, options, progress, scene,
+                                std::move(source));
+  } else if (ext == ".cpage") {
+    // Chunks are read from the file while drawing, so it must be mapped.
+    scene.meshes.resize(1);
+    scene.meshes.front().name = scene.name;
+    imported = !source && ImportPagedMesh(fileName, scene.meshes.front());
+  } else if (ext == ".obj" || ext == ".stl" || ext == ".ply" ||
+             ext == ".cmesh") {
+    scene.meshes.resize(1);
+    MeshData& meshData = scene.meshes.front();
+    meshData.name = scene.name;
+    imported = ext == ".cmesh"
+                   ? ImportMeshCache(fileName, meshData, std::move(source))
+                   : ImportSource(fileName, ext, options, useCache, progress,
+                                  meshData, std::move(source));
+  } else {
+    SPDLOG_ERROR("Unsupported file format: {}", fileName);
+  }
+
+  if (progress.cancelled) {
+    SPDLOG_INFO("Import cancelled: {}", fileName);
+    return false;
+  }
+  progress.progress = 1.0f;
+  return imported;
+}
\ No newline at end of file
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "../image.h"
+#include "../mesh.h"
+#include "../mesh_cache.h"
+#include "../paged_mesh.h"
+#include "../util/file_view.h"
+#include "vertex_welder.h"
+
+// Standard library
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// User options applied to every import
+struct ImportOptions {
+  // Meshes with at least this many triangles are paged when caching is on
+  static constexpr size_t PAGED_TRIANGLE_COUNT = 16 * 1024 * 1024;
+
+  bool weldVertices{true};
+  // Normals and UVs are welded exactly unless set
+  VertexWelder::Tolerance weldTolerance;
+  bool pageLargeMeshes{true};
+  // Reorder triangles and vertices for the vertex cache, overdraw and vertex
+  // fetch (MeshOptimizer)
+  bool optimizeMeshes{true};
+  // Tangents are only used with textures. Other meshes keep zero tangents.
+  bool skipUntexturedTangents{true};
+  // Split meshes into meshlets culled per frame (MeshletBuilder)
+  bool buildMeshlets{true};
+
+  // Encoding of the vertex buffers. Applied on upload, so caches are shared
+  // by all formats.
+  VertexFormat vertexFormat;
+  bool omitUnusedTexCoords{false};  // For meshes without a texture
+  // CPU-side copy kept by each mesh after upload. Not part of the hash.
+  MeshResidency residency{MeshResidency::POSITIONS};
+  // Simplified levels built in the background after upload (LodChain). Not
+  // part of the hash.
+  bool generateLods{true};
+  // Ray picking BVH built in the background after upload (TriangleBvh). Not
+  // part of the hash.
+  bool buildBvh{true};
+
+  // Stored in mesh caches. A cache written with other options is rebuilt.
+  uint64_t GetHash() const;
+};
+
+// Progress of one import, shared between the worker and the UI
+// Large files also publish a preview: a subset of the triangles read so far,
+// drawn flat-shaded until the import finishes.
+struct ImportProgress {
+  // Files with fewer triangles have no preview
+  static constexpr size_t PREVIEW_MIN_TRIANGLE_COUNT = 1024 * 1024;
+  // Most triangles in the preview of one file. Larger files are subsampled.
+  static constexpr size_t PREVIEW_TRIANGLE_COUNT = 1024 * 1024;
+
+  std::atomic<float> progress{0.0f};  // 0 ~ 1
+  std::atomic<bool> cancelled{false};
+
+  // Worker: Add triangles (three corners each) to the preview
+  void PublishPreview(std::vector<Vertex>&& corners);
+  // Main thread: Take the batches published since the last call
+  std::vector<std::vector<Vertex>> TakePreview();
+
+ private:
+  std::mutex m_PreviewMutex;
+  std::vector<std::vector<Vertex>> m_PreviewBatches;
+};
+
+// Vertex attribute read by the GPU straight from a buffer view of the source
+// file (glTF)
+struct AttributeData {
+  uint32_t location{0};
+  int32_t bufferView{-1};
+  int32_t componentCount{3};
+  uint32_t componentType{GL_FLOAT};
+  bool normalized{false};
+  size_t stride{0};  // 0: Tightly packed
+  size_t offset{0};
+};
+
+// CPU-side geometry produced on a worker thread. GL objects are created from
+// it on the main thread. The source is, by priority:
+// - paged: Mapped .cpage file, uploaded chunk by chunk while drawing
+// - cache: Mapped .cmesh file
+// - attributes: Buffer views of the source file, uploaded unchanged
+// - vertices and indices
+struct MeshData {
+  std::string name;
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+  std::vector<Meshlet> meshlets;  // Ranges of indices
+  uint32_t primitiveType{GL_TRIANGLES};
+  MeshCacheUPtr cache;
+  PagedMeshUPtr paged;
+  std::string cachePath;  // Mesh cache holding the geometry, if any
+  int32_t material{-1};   // Index into ImportScene::materials
+
+  std::vector<AttributeData> attributes;
+  // attributes: Triangles for the picking BVH, decoded while the buffer
+  // views are still mapped
+  std::vector<glm::vec3> bvhPositions;
+  std::vector<uint32_t> bvhIndices;
+  int32_t indexBufferView{-1};  // -1: Not indexed
+  uint32_t indexType{GL_UNSIGNED_INT};
+  size_t indexOffset{0};
+  size_t elementCount{0};  // Index count, or vertex count if not indexed
+  glm::vec3 boundsMin{0.0f};
+  glm::vec3 boundsMax{0.0f};
+};
+
+struct MaterialData {
+  std::string name;
+  glm::vec4 baseColor{1.0f};
+  int32_t image{-1};  // Index into ImportScene::images
+};
+
+struct NodeData {
+  std::string name;
+  int32_t parent{-1};  // Index of a preceding node, -1 for a root node
+  glm::mat4 transform{1.0f};
+  std::vector<int32_t> meshes;  // Indices into ImportScene::meshes
+};
+
+// Bytes of a source file which are uploaded without a copy
+struct BufferViewData {
+  const uint8_t* data{nullptr};
+  size_t size{0};
+};
+
+// Everything read from one file. Without nodes, each mesh is added as its
+// own root node.
+struct ImportScene {
+  std::string name;
+  std::vector<MeshData> meshes;
+  std::vector<MaterialData> materials;
+  std::vector<ImageUPtr> images;
+  std::vector<NodeData> nodes;
+
+  // Storage behind the buffer views: mapped files and decoded data URIs
+  std::vector<BufferViewData> bufferViews;
+  std::vector<FileViewUPtr> files;
+  std::vector<std::vector<uint8_t>> ownedBuffers;
+
+  // GL objects, created on the main thread. Buffer views shared by several
+  // meshes are uploaded once. glTF buffer views keep their own formats.
+  std::vector<MeshPtr> CreateMeshes(const ImportOptions& options);
+  std::vector<RenderMaterialPtr> CreateMaterials();
+};
+
+// Format dispatch for mesh files. Everything here runs off the main thread
+// and does not touch GL.
+// - .obj, .stl, .ply: Welded, tangents computed and cached. Large meshes
+//   are cached as .cpage files instead, and binary STL and PLY files are
+//   split into chunks without being read into memory.
+// - .gltf, .glb: Buffer views are uploaded as is where GL can read them
+// - .cmesh: Mapped and uploaded as is
+// - .cpage: Mapped and paged in while drawing
+namespace MeshImporter {
+
+bool IsSupported(const std::string& fileName);
+
+// useCache: Load from the .cpage or .cmesh cache next to the file if it is
+// up to date, otherwise write it after parsing.
+// source: The file already in memory. If null, fileName is mapped.
+// Return false on failure or cancellation.
+bool Import(const std::string& fileName, const ImportOptions& options,
+            bool useCache, ImportProgress& progress, ImportScene& scene,
+            FileViewUPtr source = nullptr);
+
+}  // namespace MeshImporter
\ No newline at end of file
@@ -0,0 +1,408 @@
+#include "obj_parser.h"
+
+#include "../config/log_config.h"
+#include "../thread_pool.h"
+
+// Standard library
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Blocks smaller than this are parsed by a single chunk
+constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+// A negative OBJ index is relative to the attribute count at its line. That
+// count is only known within the chunk until all preceding chunks are
+// merged, so such indices are stored as chunk-local values offset by this
+// flag and rebased later.
+constexpr int64_t CHUNK_RELATIVE = int64_t(1) << 62;
+constexpr int64_t MISSING_INDEX = -1;
+
+bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+const char* SkipSpaces(const char* p, const char* end) {
+  while (p < end && IsSpace(*p)) ++p;
+  return p;
+}
+
+// Locale independent float parser. strtof() is too slow for multi-GB files.
+const char* ParseFloat(const char* p, const char* end, float& value) {
+  p = SkipSpaces(p, end);
+
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    ++p;
+  }
+
+  double number = 0.0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    number = number * 10.0 + (*p - '0');
+    ++p;
+  }
+  if (p < end && *p == '.') {
+    ++p;
+    double scale = 0.1;
+    while (p < end && *p >= '0' && *p <= '9') {
+      number += (*p - '0') * scale;
+      scale *= 0.1;
+      ++p;
+    }
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negativeExp = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      negativeExp = (*p == '-');
+      ++p;
+    }
+    int32_t exponent = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+      exponent = exponent * 10 + (*p - '0');
+      ++p;
+    }
+    number *= std::pow(10.0, negativeExp ? -exponent : exponent);
+  }
+
+  value = static_cast<float>(negative ? -number : number);
+  return p;
+}
+
+const char* ParseInt(const char* p, const char* end, int64_t& value) {
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    ++p;
+  }
+  int64_t number = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    number = number * 10 + (*p - '0');
+    ++p;
+  }
+  value = negative ? -number : number;
+  return p;
+}
+
+// OBJ indices are 1-based. Positive indices are absolute in the file.
+int64_t EncodeIndex(int64_t index, size_t localCount) {
+  if (index > 0) return index - 1;
+  if (index < 0) return CHUNK_RELATIVE + static_cast<int64_t>(localCount) + index;
+  return MISSING_INDEX;
+}
+
+// Return the absolute index, or MISSING_INDEX if it is out of range.
+int64_t DecodeIndex(int64_t index, size_t base, size_t count) {
+  if (index == MISSING_INDEX) return MISSING_INDEX;
+  if (index >= CHUNK_RELATIVE / 2) {
+    index = index - CHUNK_RELATIVE + static_cast<int64_t>(base);
+  }
+  return (index >= 0 && index < static_cast<int64_t>(count)) ? index
+                                                              : MISSING_INDEX;
+}
+
+// Face corner whose indices may still be chunk-relative
+struct RawCorner {
+  int64_t position{MISSING_INDEX};
+  int64_t texCoord{MISSING_INDEX};
+  int64_t normal{MISSING_INDEX};
+};
+
+// Result of parsing a newline-aligned part of a block
+struct ObjChunk {
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> normals;
+  std::vector<glm::vec2> texCoords;
+  std::vector<RawCorner> corners;  // 3 corners per triangle
+  size_t invalidFaceCount{0};
+  size_t validTriangleCount{0};
+
+  void parse(const char* begin, const char* end);
+  void parseLine(const char* begin, const char* end);
+  void parseFace(const char* begin, const char* end);
+
+  // Rebase indices to the whole file and mark triangles with an out of range
+  // corner as invalid.
+  void resolve(size_t positionBase, size_t texCoordBase, size_t normalBase,
+               size_t positionCount, size_t texCoordCount,
+               size_t normalCount);
+};
+
+void ObjChunk::parse(const char* begin, const char* end) {
+  const char* p = begin;
+  while (p < end) {
+    const char* newline =
+        static_cast<const char*>(std::memchr(p, '\n', end - p));
+    const char* lineEnd = newline ? newline : end;
+    parseLine(p, lineEnd);
+    p = lineEnd + 1;
+  }
+}
+
+void ObjChunk::parseLine(const char* begin, const char* end) {
+  const char* p = SkipSpaces(begin, end);
+  if (p + 1 >= end) return;
+
+  if (p[0] == 'v') {
+    if (IsSpace(p[1])) {
+      glm::vec3 position;
+      p = ParseFloat(p + 2, end, position.x);
+      p = ParseFloat(p, end, position.y);
+      ParseFloat(p, end, position.z);
+      positions.push_back(position);
+    } else if (p[1] == 'n' && p + 2 < end && IsSpace(p[2])) {
+      glm::vec3 normal;
+      p = ParseFloat(p + 3, end, normal.x);
+      p = ParseFloat(p, end, normal.y);
+      ParseFloat(p, end, normal.z);
+      normals.push_back(normal);
+    } else if (p[1] == 't' && p + 2 < end && IsSpace(p[2])) {
+      glm::vec2 texCoord;
+      p = ParseFloat(p + 3, end, texCoord.x);
+      ParseFloat(p, end, texCoord.y);
+      texCoords.push_back(texCoord);
+    }
+  } else if (p[0] == 'f' && IsSpace(p[1])) {
+    parseFace(p + 2, end);
+  }
+  // Other records (o, g, s, usemtl, mtllib, comments) are ignored.
+}
+
+void ObjChunk::parseFace(const char* begin, const char* end) {
+  // Corners are "p", "p/t", "p//n" or "p/t/n"
+  RawCorner first, previous;
+  int32_t cornerCount = 0;
+  size_t cornerStart = corners.size();
+  bool valid = true;
+
+  const char* p = SkipSpaces(begin, end);
+  while (p < end) {
+    int64_t index = 0;
+    RawCorner corner;
+
+    p = ParseInt(p, end, index);
+    corner.position = EncodeIndex(index, positions.size());
+    if (p < end && *p == '/') {
+      ++p;
+      if (p < end && *p != '/') {
+        p = ParseInt(p, end, index);
+        corner.texCoord = EncodeIndex(index, texCoords.size());
+      }
+      if (p < end && *p == '/') {
+        ++p;
+        p = ParseInt(p, end, index);
+        corner.normal = EncodeIndex(index, normals.size());
+      }
+    }
+    if (corner.position == MISSING_INDEX) valid = false;
+
+    // Fan triangulation: (first, previous, current)
+    if (cornerCount == 0) {
+      first = corner;
+    } else if (cornerCount >= 2) {
+      corners.push_back(first);
+      corners.push_back(previous);
+      corners.push_back(corner);
+    }
+    previous = corner;
+    ++cornerCount;
+
+    // Skip to the next corner
+    while (p < end && !IsSpace(*p)) ++p;
+    p = SkipSpaces(p, end);
+  }
+
+  if (!valid || cornerCount < 3) {
+    corners.resize(cornerStart);
+    ++invalidFaceCount;
+  }
+}
+
+void ObjChunk::resolve(size_t positionBase, size_t texCoordBase,
+                       size_t normalBase, size_t positionCount,
+                       size_t texCoordCount, size_t normalCount) {
+  validTriangleCount = 0;
+  for (size_t i = 0; i < corners.size(); i += 3) {
+    bool valid = true;
+    for (size_t j = i; j < i + 3; ++j) {
+      RawCorner& corner = corners[j];
+      corner.position =
+          DecodeIndex(corner.position, positionBase, positionCount);
+      corner.texCoord =
+          DecodeIndex(corner.texCoord, texCoordBase, texCoordCount);
+      corner.normal = DecodeIndex(corner.normal, normalBase, normalCount);
+      if (corner.position == MISSING_INDEX) valid = false;
+    }
+    if (valid) {
+      ++validTriangleCount;
+    } else {
+      corners[i].position = MISSING_INDEX;
+      ++invalidFaceCount;
+    }
+  }
+}
+
+}  // namespace
+
+void ObjParser::Feed(const char* data, size_t size) {
+  const char* p = data;
+  const char* end = data + size;
+
+  // Complete the line carried over from the previous chunk
+  if (!m_Carry.empty()) {
+    const char* newline =
+        static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (!newline) {
+      m_Carry.append(p, end);
+      return;
+    }
+    m_Carry.append(p, newline + 1);
+    parseBlock(m_Carry.data(), m_Carry.data() + m_Carry.size());
+    m_Carry.clear();
+    p = newline + 1;
+  }
+
+  // Parse all complete lines and keep the tail for the next call
+  const char* lastNewline = p;
+  for (const char* q = end; q > p; --q) {
+    if (q[-1] == '\n') {
+      lastNewline = q;
+      break;
+    }
+  }
+  if (lastNewline > p) {
+    parseBlock(p, lastNewline);
+  }
+  m_Carry.assign(lastNewline, end);
+}
+
+bool ObjParser::Finish(std::vector<Vertex>& vertices,
+                       std::vector<uint32_t>& indices) {
+  if (!m_Carry.empty()) {
+    parseBlock(m_Carry.data(), m_Carry.data() + m_Carry.size());
+    m_Carry.clear();
+  }
+
+  if (m_SkippedFaceCount > 0) {
+    SPDLOG_WARN("Skipped {} faces with invalid indices", m_SkippedFaceCount);
+  }
+  SPDLOG_DEBUG("OBJ parsed: {} positions, {} normals, {} texcoords",
+               m_Positions.size(), m_Normals.size(), m_TexCoords.size());
+
+  // Attributes are not needed anymore. Release them before the caller
+  // uploads the vertices.
+  std::vector<glm::vec3>().swap(m_Positions);
+  std::vector<glm::vec3>().swap(m_Normals);
+  std::vector<glm::vec2>().swap(m_TexCoords);
+
+  if (m_Indices.empty()) {
+    return false;
+  }
+
+  vertices = std::move(m_Vertices);
+  indices = std::move(m_Indices);
+  return true;
+}
+
+void ObjParser::parseBlock(const char* begin, const char* end) {
+  ThreadPool& threadPool = ThreadPool::Instance();
+  size_t size = static_cast<size_t>(end - begin);
+
+  // Split the block into chunks which start right after a newline
+  size_t maxChunkCount = std::max<size_t>(threadPool.GetThreadCount() * 4, 1);
+  size_t chunkCount =
+      std::clamp<size_t>(size / MIN_CHUNK_SIZE, 1, maxChunkCount);
+  std::vector<const char*> bounds{begin};
+  for (size_t i = 1; i < chunkCount; ++i) {
+    const char* p = std::max(begin + size * i / chunkCount, bounds.back());
+    const char* newline =
+        static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (!newline) break;
+    bounds.push_back(newline + 1);
+  }
+  bounds.push_back(end);
+  chunkCount = bounds.size() - 1;
+
+  // 1. Parse chunks in parallel
+  std::vector<ObjChunk> chunks(chunkCount);
+  threadPool.ParallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      chunks[i].parse(bounds[i], bounds[i + 1]);
+    }
+  });
+
+  // 2. Append the chunk attributes in file order
+  std::vector<size_t> positionBases(chunkCount);
+  std::vector<size_t> normalBases(chunkCount);
+  std::vector<size_t> texCoordBases(chunkCount);
+  size_t positionCount = m_Positions.size();
+  size_t normalCount = m_Normals.size();
+  size_t texCoordCount = m_TexCoords.size();
+  for (size_t i = 0; i < chunkCount; ++i) {
+    positionBases[i] = positionCount;
+    normalBases[i] = normalCount;
+    texCoordBases[i] = texCoordCount;
+    positionCount += chunks[i].positions.size();
+    normalCount += chunks[i].normals.size();
+    texCoordCount += chunks[i].texCoords.size();
+  }
+  m_Positions.resize(positionCount);
+  m_Normals.resize(normalCount);
+  m_TexCoords.resize(texCoordCount);
+  threadPool.ParallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      ObjChunk& chunk = chunks[i];
+      std::copy(chunk.positions.begin(), chunk.positions.end(),
+                m_Positions.begin() + positionBases[i]);
+      std::copy(chunk.normals.begin(), chunk.normals.end(),
+                m_Normals.begin() + normalBases[i]);
+      std::copy(chunk.texCoords.begin(), chunk.texCoords.end(),
+                m_TexCoords.begin() + texCoordBases[i]);
+      std::vector<glm::vec3>().swap(chunk.positions);
+      std::vector<glm::vec3>().swap(chunk.normals);
+      std::vector<glm::vec2>().swap(chunk.texCoords);
+      chunk.resolve(positionBases[i], texCoordBases[i], normalBases[i],
+                    positionCount, texCoordCount, normalCount);
+    }
+  });
+
+  // 3. Emit vertices of the valid triangles. Each chunk writes its own range
+  // of the output, so the indices are rebased by the chunk vertex offset.
+  std::vector<size_t> vertexOffsets(chunkCount);
+  size_t vertexCount = m_Vertices.size();
+  for (size_t i = 0; i < chunkCount; ++i) {
+    vertexOffsets[i] = vertexCount;
+    vertexCount += chunks[i].validTriangleCount * 3;
+    m_SkippedFaceCount += chunks[i].invalidFaceCount;
+  }
+  m_Vertices.resize(vertexCount);
+  m_Indices.resize(vertexCount);
+  threadPool.ParallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      const std::vector<RawCorner>& corners = chunks[i].corners;
+      size_t out = vertexOffsets[i];
+      for (size_t j = 0; j < corners.size(); j += 3) {
+        if (corners[j].position == MISSING_INDEX) continue;
+
+        const glm::vec3& p0 = m_Positions[corners[j].position];
+        const glm::vec3& p1 = m_Positions[corners[j + 1].position];
+        const glm::vec3& p2 = m_Positions[corners[j + 2].position];
+        glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(faceNormal);
+        faceNormal = length > 0.0f ? faceNormal / length : glm::vec3(0.0f);
+
+        for (size_t k = j; k < j + 3; ++k) {
+          const RawCorner& c = corners[k];
+          m_Vertices[out] = Vertex{
+              m_Positions[c.position],
+              c.normal >= 0 ? m_Normals[c.normal] : faceNormal,
+              c.texCoord >= 0 ? m_TexCoords[c.texCoord] : glm::vec2(0.0f),
+              glm::vec4(0.0f)};
+          m_Indices[out] = static_cast<uint32_t>(out);
+          ++out;
+        }
+      }
+    }
+  });
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../mesh.h"
+
+// Standard library
+#include <string>
+#include <vector>
+
+// Streaming Wavefront OBJ parser
+// - Feed() accepts the file in chunks of any size. A line split between two
+//   chunks is carried over to the next call.
+// - Each fed block is split at newline boundaries and parsed on the thread
+//   pool. Per-chunk attributes are appended in file order, then face corners
+//   are resolved against the global attribute lists in parallel.
+// - Only "v", "vn", "vt" and "f" records are read. Polygons are triangulated
+//   as fans. Faces without normals get the flat normal of their triangle.
+class ObjParser {
+ public:
+  void Feed(const char* data, size_t size);
+
+  // Triangles resolved so far, e.g. for a preview while parsing
+  const std::vector<Vertex>& GetVertices() const { return m_Vertices; }
+  const std::vector<uint32_t>& GetIndices() const { return m_Indices; }
+
+  // Flush the last line and move the result out of the parser.
+  // Return false if no triangle was parsed.
+  bool Finish(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+ private:
+  std::vector<glm::vec3> m_Positions;
+  std::vector<glm::vec3> m_Normals;
+  std::vector<glm::vec2> m_TexCoords;
+
+  std::vector<Vertex> m_Vertices;
+  std::vector<uint32_t> m_Indices;
+
+  std::string m_Carry;  // Incomplete line from the previous chunk
+  size_t m_SkippedFaceCount{0};
+
+  void parseBlock(const char* begin, const char* end);
+};
\ No newline at end of file
@@ -0,0 +1,554 @@
+#include "ply_reader.h"
+
+#include "../config/log_config.h"
+#include "../thread_pool.h"
+
+// Standard library
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+namespace {
+
+constexpr size_t GRAIN_SIZE = 16 * 1024;
+constexpr std::string_view END_HEADER = "end_header";
+
+enum class PlyType : uint8_t {
+  NONE,
+  INT8,
+  UINT8,
+  INT16,
+  UINT16,
+  INT32,
+  UINT32,
+  FLOAT32,
+  FLOAT64,
+};
+
+struct PlyProperty {
+  std::string name;
+  PlyType type{PlyType::NONE};
+  PlyType countType{PlyType::NONE};  // Set for list properties
+  size_t offset{0};                  // Offset in a fixed-size item
+};
+
+struct PlyElement {
+  std::string name;
+  size_t count{0};
+  std::vector<PlyProperty> properties;
+  size_t stride{0};  // Size of one item, 0 if the element has lists
+};
+
+PlyType ParseType(const std::string& name) {
+  if (name == "char" || name == "int8") return PlyType::INT8;
+  if (name == "uchar" || name == "uint8") return PlyType::UINT8;
+  if (name == "short" || name == "int16") return PlyType::INT16;
+  if (name == "ushort" || name == "uint16") return PlyType::UINT16;
+  if (name == "int" || name == "int32") return PlyType::INT32;
+  if (name == "uint" || name == "uint32") return PlyType::UINT32;
+  if (name == "float" || name == "float32") return PlyType::FLOAT32;
+  if (name == "double" || name == "float64") return PlyType::FLOAT64;
+  return PlyType::NONE;
+}
+
+size_t GetTypeSize(PlyType type) {
+  switch (type) {
+    case PlyType::INT8:
+    case PlyType::UINT8:
+      return 1;
+    case PlyType::INT16:
+    case PlyType::UINT16:
+      return 2;
+    case PlyType::INT32:
+    case PlyType::UINT32:
+    case PlyType::FLOAT32:
+      return 4;
+    case PlyType::FLOAT64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+template <class T>
+T Load(const uint8_t* data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+float ReadFloat(const uint8_t* data, PlyType type) {
+  switch (type) {
+    case PlyType::INT8:
+      return Load<int8_t>(data);
+    case PlyType::UINT8:
+      return Load<uint8_t>(data);
+    case PlyType::INT16:
+      return Load<int16_t>(data);
+    case PlyType::UINT16:
+      return Load<uint16_t>(data);
+    case PlyType::INT32:
+      return static_cast<float>(Load<int32_t>(data));
+    case PlyType::UINT32:
+      return static_cast<float>(Load<uint32_t>(data));
+    case PlyType::FLOAT32:
+      return Load<float>(data);
+    case PlyType::FLOAT64:
+      return static_cast<float>(Load<double>(data));
+    default:
+      return 0.0f;
+  }
+}
+
+// Negative and fractional values are returned as -1.
+int64_t ReadInteger(const uint8_t* data, PlyType type) {
+  switch (type) {
+    case PlyType::INT8:
+      return Load<int8_t>(data);
+    case PlyType::UINT8:
+      return Load<uint8_t>(data);
+    case PlyType::INT16:
+      return Load<int16_t>(data);
+    case PlyType::UINT16:
+      return Load<uint16_t>(data);
+    case PlyType::INT32:
+      return Load<int32_t>(data);
+    case PlyType::UINT32:
+      return Load<uint32_t>(data);
+    default:
+      return -1;
+  }
+}
+
+bool ParseHeader(std::string_view text, std::vector<PlyElement>& elements,
+                 size_t& dataOffset, std::string& error) {
+  size_t endHeader = text.find(END_HEADER);
+  if (text.substr(0, 3) != "ply" || endHeader == std::string_view::npos) {
+    error = "Not a PLY file";
+    return false;
+  }
+  dataOffset = text.find('\n', endHeader);
+  if (dataOffset == std::string_view::npos) {
+    error = "Missing data";
+    return false;
+  }
+  ++dataOffset;
+
+  std::istringstream header(std::string(text.substr(0, endHeader)));
+  std::string line;
+  bool binaryLittleEndian = false;
+  while (std::getline(header, line)) {
+    std::istringstream tokens(line);
+    std::string keyword;
+    tokens >> keyword;
+    if (keyword == "format") {
+      std::string format;
+      tokens >> format;
+      binaryLittleEndian = format == "binary_little_endian";
+    } else if (keyword == "element") {
+      PlyElement element;
+      tokens >> element.name >> element.count;
+      elements.push_back(std::move(element));
+    } else if (keyword == "property") {
+      if (elements.empty()) {
+        error = "Property without element";
+        return false;
+      }
+      PlyProperty property;
+      std::string type;
+      tokens >> type;
+      if (type == "list") {
+        std::string countType;
+        tokens >> countType >> type;
+        property.countType = ParseType(countType);
+        if (property.countType == PlyType::NONE) {
+          error = "Unknown type: " + countType;
+          return false;
+        }
+      }
+      tokens >> property.name;
+      property.type = ParseType(type);
+      if (property.type == PlyType::NONE) {
+        error = "Unknown type: " + type;
+        return false;
+      }
+      elements.back().properties.push_back(std::move(property));
+    }
+  }
+  if (!binaryLittleEndian) {
+    error = "Only binary little-endian PLY is supported";
+    return false;
+  }
+
+  for (auto& element : elements) {
+    size_t offset = 0;
+    for (auto& property : element.properties) {
+      if (property.countType != PlyType::NONE) {
+        offset = 0;
+        break;
+      }
+      property.offset = offset;
+      offset += GetTypeSize(property.type);
+    }
+    element.stride = offset;
+  }
+  return true;
+}
+
+const PlyProperty* FindProperty(const PlyElement& element,
+                                std::initializer_list<const char*> names) {
+  for (const char* name : names) {
+    for (const auto& property : element.properties) {
+      if (property.countType == PlyType::NONE && property.name == name) {
+        return &property;
+      }
+    }
+  }
+  return nullptr;
+}
+
+// Walk one item of an element with lists. Return nullptr if the item runs
+// past the end of the file.
+const uint8_t* SkipItem(const PlyElement& element, const uint8_t* data,
+                        const uint8_t* end) {
+  for (const auto& property : element.properties) {
+    size_t typeSize = GetTypeSize(property.type);
+    if (property.countType == PlyType::NONE) {
+      data += typeSize;
+    } else {
+      size_t countSize = GetTypeSize(property.countType);
+      if (size_t(end - data) < countSize) return nullptr;
+      int64_t count = ReadInteger(data, property.countType);
+      if (count < 0) return nullptr;
+      data += countSize;
+      if (size_t(end - data) / typeSize < size_t(count)) return nullptr;
+      data += count * typeSize;
+    }
+    if (data > end) return nullptr;
+  }
+  return data;
+}
+
+// Vertex properties of the "vertex" element
+struct VertexProperties {
+  const PlyProperty* position[3]{};
+  const PlyProperty* normal[3]{};
+  const PlyProperty* texCoord[2]{};
+  bool packedPosition{false};  // x, y, z as consecutive floats
+  bool hasNormals{false};
+  bool hasTexCoords{false};
+};
+
+bool FindVertexProperties(const PlyElement& element,
+                          VertexProperties& properties) {
+  const char* names[] = {"x", "y", "z", "nx", "ny", "nz"};
+  for (int i = 0; i < 3; ++i) {
+    properties.position[i] = FindProperty(element, {names[i]});
+    properties.normal[i] = FindProperty(element, {names[i + 3]});
+  }
+  properties.texCoord[0] =
+      FindProperty(element, {"u", "s", "texture_u", "texture_s"});
+  properties.texCoord[1] =
+      FindProperty(element, {"v", "t", "texture_v", "texture_t"});
+  const PlyProperty* const* position = properties.position;
+  if (!position[0] || !position[1] || !position[2]) {
+    return false;
+  }
+  properties.hasNormals =
+      properties.normal[0] && properties.normal[1] && properties.normal[2];
+  properties.hasTexCoords = properties.texCoord[0] && properties.texCoord[1];
+  properties.packedPosition = position[0]->type == PlyType::FLOAT32 &&
+                              position[1]->type == PlyType::FLOAT32 &&
+                              position[2]->type == PlyType::FLOAT32 &&
+                              position[1]->offset == position[0]->offset + 4 &&
+                              position[2]->offset == position[0]->offset + 8;
+  return true;
+}
+
+Vertex ReadVertex(const VertexProperties& properties, const uint8_t* item) {
+  auto read = [item](const PlyProperty* property) {
+    return ReadFloat(item + property->offset, property->type);
+  };
+  Vertex vertex;
+  if (properties.packedPosition) {
+    std::memcpy(&vertex.position, item + properties.position[0]->offset,
+                sizeof(glm::vec3));
+  } else {
+    vertex.position = glm::vec3(read(properties.position[0]),
+                                read(properties.position[1]),
+                                read(properties.position[2]));
+  }
+  vertex.normal = properties.hasNormals
+                      ? glm::vec3(read(properties.normal[0]),
+                                  read(properties.normal[1]),
+                                  read(properties.normal[2]))
+                      : glm::vec3(0.0f);
+  vertex.texCoord = properties.hasTexCoords
+                        ? glm::vec2(read(properties.texCoord[0]),
+                                    read(properties.texCoord[1]))
+                        : glm::vec2(0.0f);
+  vertex.tangent = glm::vec4(0.0f);
+  return vertex;
+}
+
+bool ReadVertices(const PlyElement& element, const uint8_t* data,
+                  std::vector<Vertex>& vertices, bool& hasNormals) {
+  VertexProperties properties;
+  if (!FindVertexProperties(element, properties)) {
+    return false;
+  }
+  hasNormals = properties.hasNormals;
+
+  vertices.resize(element.count);
+  ThreadPool::Instance().ParallelFor(
+      element.count, GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          vertices[i] = ReadVertex(properties, data + i * element.stride);
+        }
+      });
+  return true;
+}
+
+// Walk faceCount faces of the "face" element from data, calling func with
+// the three corner indices of each triangle of their fans. Return the end
+// of the faces, nullptr if the data is truncated.
+template <class Func>
+const uint8_t* ForEachFace(const PlyElement& element, const uint8_t* data,
+                           const uint8_t* end, size_t faceCount,
+                           size_t vertexCount, size_t& skippedFaceCount,
+                           Func&& func) {
+  const PlyProperty* indexProperty = nullptr;
+  for (const auto& property : element.properties) {
+    if (property.countType != PlyType::NONE &&
+        (property.name == "vertex_indices" || property.name == "vertex_index")) {
+      indexProperty = &property;
+    }
+  }
+
+  for (size_t i = 0; i < faceCount; ++i) {
+    for (const auto& property : element.properties) {
+      size_t typeSize = GetTypeSize(property.type);
+      if (property.countType == PlyType::NONE) {
+        if (size_t(end - data) < typeSize) return nullptr;
+        data += typeSize;
+        continue;
+      }
+
+      size_t countSize = GetTypeSize(property.countType);
+      if (size_t(end - data) < countSize) return nullptr;
+      int64_t count = ReadInteger(data, property.countType);
+      data += countSize;
+      if (count < 0 || size_t(end - data) / typeSize < size_t(count)) {
+        return nullptr;
+      }
+
+      if (&property == indexProperty) {
+        bool valid = count >= 3;
+        for (int64_t j = 0; valid && j < count; ++j) {
+          int64_t index = ReadInteger(data + j * typeSize, property.type);
+          valid = index >= 0 && size_t(index) < vertexCount;
+        }
+        if (valid) {
+          auto readIndex = [&](int64_t j) {
+            return uint32_t(ReadInteger(data + j * typeSize, property.type));
+          };
+          for (int64_t j = 2; j < count; ++j) {
+            func(readIndex(0), readIndex(j - 1), readIndex(j));
+          }
+        } else {
+          ++skippedFaceCount;
+        }
+      }
+      data += count * typeSize;
+    }
+  }
+  return data;
+}
+
+// Header and element data of a file
+struct PlyFile {
+  std::vector<PlyElement> elements;
+  const PlyElement* vertex{nullptr};
+  const uint8_t* vertexData{nullptr};
+  const PlyElement* face{nullptr};
+  const uint8_t* faceData{nullptr};
+  const uint8_t* end{nullptr};
+};
+
+// Parse the header and find the vertex and face data. Elements with lists
+// before them are walked.
+bool OpenFile(const FileView& fileView, PlyFile& file) {
+  const std::string& path = fileView.GetPath();
+  size_t dataOffset = 0;
+  std::string error;
+  if (!ParseHeader(fileView.GetString(), file.elements, dataOffset, error)) {
+    SPDLOG_ERROR("{}: {}", error, path);
+    return false;
+  }
+
+  const uint8_t* data = fileView.GetData() + dataOffset;
+  file.end = fileView.GetData() + fileView.GetSize();
+  for (const auto& element : file.elements) {
+    if (element.name == "vertex" && element.stride > 0) {
+      file.vertex = &element;
+      file.vertexData = data;
+    } else if (element.name == "face" && element.stride == 0) {
+      file.face = &element;
+      file.faceData = data;
+    }
+    if (file.vertex && file.face) break;
+
+    if (element.stride > 0) {
+      if (size_t(file.end - data) / element.stride < element.count) {
+        data = nullptr;
+      } else {
+        data += element.stride * element.count;
+      }
+    } else {
+      for (size_t i = 0; data && i < element.count; ++i) {
+        data = SkipItem(element, data, file.end);
+      }
+    }
+    if (!data) {
+      SPDLOG_ERROR("Truncated element \"{}\": {}", element.name, path);
+      return false;
+    }
+  }
+
+  size_t vertexCount = file.vertex ? file.vertex->count : 0;
+  if (vertexCount == 0 || vertexCount > UINT32_MAX ||
+      size_t(file.end - file.vertexData) / file.vertex->stride < vertexCount) {
+    SPDLOG_ERROR("Invalid vertex count ({}): {}", vertexCount, path);
+    return false;
+  }
+  if (!file.face || file.face->count == 0) {
+    SPDLOG_ERROR("No triangle found in {}", path);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool PlyReader::Read(const FileView& fileView, std::vector<Vertex>& vertices,
+                     std::vector<uint32_t>& indices, bool& hasNormals) {
+  const std::string& path = fileView.GetPath();
+  PlyFile file;
+  if (!OpenFile(fileView, file)) return false;
+  if (!ReadVertices(*file.vertex, file.vertexData, vertices, hasNormals)) {
+    SPDLOG_ERROR("Vertices without positions: {}", path);
+    return false;
+  }
+
+  size_t skippedFaceCount = 0;
+  indices.reserve(file.face->count * 3);
+  const uint8_t* facesEnd = ForEachFace(
+      *file.face, file.faceData, file.end, file.face->count, vertices.size(),
+      skippedFaceCount,
+      [&indices](uint32_t i0, uint32_t i1, uint32_t i2) {
+        indices.insert(indices.end(), {i0, i1, i2});
+      });
+  if (!facesEnd) {
+    SPDLOG_ERROR("Truncated element \"face\": {}", path);
+    return false;
+  }
+
+  if (skippedFaceCount > 0) {
+    SPDLOG_WARN("Skipped {} invalid faces in {}", skippedFaceCount, path);
+  }
+  if (indices.empty()) {
+    SPDLOG_ERROR("No triangle found in {}", path);
+    return false;
+  }
+  return true;
+}
+
+size_t PlyReader::GetFaceCount(const FileView& fileView) {
+  PlyFile file;
+  return OpenFile(fileView, file) ? file.face->count : 0;
+}
+
+bool PlyReader::GetBounds(const FileView& fileView, glm::vec3& boundsMin,
+                          glm::vec3& boundsMax, bool& hasNormals) {
+  PlyFile file;
+  VertexProperties properties;
+  if (!OpenFile(fileView, file) ||
+      !FindVertexProperties(*file.vertex, properties)) {
+    return false;
+  }
+  hasNormals = properties.hasNormals;
+
+  const PlyElement& element = *file.vertex;
+  std::mutex mutex;
+  boundsMin = glm::vec3(FLT_MAX);
+  boundsMax = glm::vec3(-FLT_MAX);
+  ThreadPool::Instance().ParallelFor(
+      element.count, GRAIN_SIZE, [&](size_t begin, size_t end) {
+        glm::vec3 localMin(FLT_MAX);
+        glm::vec3 localMax(-FLT_MAX);
+        for (size_t i = begin; i < end; ++i) {
+          glm::vec3 position =
+              ReadVertex(properties, file.vertexData + i * element.stride)
+                  .position;
+          localMin = glm::min(localMin, position);
+          localMax = glm::max(localMax, position);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        boundsMin = glm::min(boundsMin, localMin);
+        boundsMax = glm::max(boundsMax, localMax);
+      });
+  return true;
+}
+
+bool PlyReader::ForEachTriangle(
+    const FileView& fileView, size_t blockSize,
+    const std::function<bool(size_t)>& progress,
+    const std::function<void(const Vertex*)>& func) {
+  const std::string& path = fileView.GetPath();
+  PlyFile file;
+  VertexProperties properties;
+  if (!OpenFile(fileView, file) ||
+      !FindVertexProperties(*file.vertex, properties)) {
+    return false;
+  }
+
+  const PlyElement& element = *file.vertex;
+  const size_t faceCount = file.face->count;
+  const uint8_t* data = file.faceData;
+  size_t skippedFaceCount = 0;
+  size_t triangleCount = 0;
+  Vertex corners[3];
+  for (size_t first = 0; first < faceCount; first += blockSize) {
+    size_t last = std::min(first + blockSize, faceCount);
+    const uint8_t* blockData = data;
+    data = ForEachFace(
+        *file.face, data, file.end, last - first, element.count,
+        skippedFaceCount, [&](uint32_t i0, uint32_t i1, uint32_t i2) {
+          uint32_t triangle[3] = {i0, i1, i2};
+          for (int i = 0; i < 3; ++i) {
+            corners[i] = ReadVertex(
+                properties, file.vertexData + triangle[i] * element.stride);
+          }
+          func(corners);
+          ++triangleCount;
+        });
+    if (!data) {
+      SPDLOG_ERROR("Truncated element \"face\": {}", path);
+      return false;
+    }
+    fileView.ReleasePages(blockData - fileView.GetData(), data - blockData);
+    if (!progress(last)) return false;
+  }
+
+  if (skippedFaceCount > 0) {
+    SPDLOG_WARN("Skipped {} invalid faces in {}", skippedFaceCount, path);
+  }
+  if (triangleCount == 0) {
+    SPDLOG_ERROR("No triangle found in {}", path);
+    return false;
+  }
+  return true;
+}
\ No newline at end of file
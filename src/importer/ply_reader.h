@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../mesh.h"
+#include "../util/file_view.h"
+
+// Standard library
+#include <functional>
+#include <vector>
+
+// Binary little-endian PLY reader
+// - "vertex" element: x, y, z and, if present, nx, ny, nz and u, v (also s, t
+//   and texture_u, texture_v) of any scalar type. Vertices have a fixed size
+//   and are converted in place on the thread pool.
+// - "face" element: "vertex_indices" (or "vertex_index") lists, triangulated
+//   as fans. Faces with out-of-range indices are skipped.
+// - Other elements are skipped.
+// Files too large to read at once are streamed face by face, with the
+// corners read in place from the fixed-size vertices.
+namespace PlyReader {
+
+// hasNormals: Set to true if the vertices carry normals
+// Return false if the file is not a supported PLY file.
+bool Read(const FileView& fileView, std::vector<Vertex>& vertices,
+          std::vector<uint32_t>& indices, bool& hasNormals);
+
+// Return the face count of a supported PLY file, otherwise 0. Faces are
+// triangles in most large files.
+size_t GetFaceCount(const FileView& fileView);
+
+// Bounds of the vertices. hasNormals as in Read().
+bool GetBounds(const FileView& fileView, glm::vec3& boundsMin,
+               glm::vec3& boundsMax, bool& hasNormals);
+
+// Call func with the three corners of each triangle, in file order, then
+// release the pages of the faces read. progress is called with the faces
+// read so far after each blockSize faces. Return false if it returns
+// false, or if the file is not supported.
+bool ForEachTriangle(const FileView& fileView, size_t blockSize,
+                     const std::function<bool(size_t)>& progress,
+                     const std::function<void(const Vertex*)>& func);
+
+}  // namespace PlyReader
\ No newline at end of file
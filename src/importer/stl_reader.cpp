@@ -0,0 +1,123 @@
+#include "stl_reader.h"
+
+#include "../config/log_config.h"
+#include "../thread_pool.h"
+
+// Standard library
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// 80-byte header + uint32 triangle count, then 50-byte triangle records:
+// normal (3 floats), 3 corners (9 floats), attribute byte count (uint16).
+// All values are little-endian.
+constexpr size_t HEADER_SIZE = 80 + sizeof(uint32_t);
+constexpr size_t TRIANGLE_SIZE = 50;
+constexpr size_t TRIANGLE_FLOAT_COUNT = 12;
+constexpr size_t GRAIN_SIZE = 16 * 1024;
+
+glm::vec3 GetFacetNormal(const glm::vec3& normal, const glm::vec3& p0,
+                         const glm::vec3& p1, const glm::vec3& p2) {
+  float length = glm::length(normal);
+  if (length > 0.0f && std::isfinite(length)) {
+    return normal / length;
+  }
+  // Many exporters write zero normals
+  glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+  length = glm::length(cross);
+  return length > 0.0f ? cross / length : glm::vec3(0.0f);
+}
+
+// The file size must match the triangle count in the header
+bool IsBinaryStl(const uint8_t* data, size_t size, uint32_t& triangleCount) {
+  triangleCount = 0;
+  if (size >= HEADER_SIZE) {
+    std::memcpy(&triangleCount, data + 80, sizeof(triangleCount));
+  }
+  return size >= HEADER_SIZE &&
+         HEADER_SIZE + uint64_t(triangleCount) * TRIANGLE_SIZE == size;
+}
+
+}  // namespace
+
+bool StlReader::Read(const FileView& fileView, bool facetNormals,
+                     std::vector<Vertex>& vertices,
+                     std::vector<uint32_t>& indices) {
+  const uint8_t* data = fileView.GetData();
+  const size_t size = fileView.GetSize();
+
+  // ASCII files may also start with "solid", so the size decides.
+  uint32_t triangleCount = 0;
+  if (!IsBinaryStl(data, size, triangleCount)) {
+    if (size >= 5 && std::memcmp(data, "solid", 5) == 0) {
+      SPDLOG_ERROR("ASCII STL is not supported: {}", fileView.GetPath());
+    } else {
+      SPDLOG_ERROR("Invalid binary STL: {}", fileView.GetPath());
+    }
+    return false;
+  }
+  if (triangleCount == 0 || uint64_t(triangleCount) * 3 > UINT32_MAX) {
+    SPDLOG_ERROR("Invalid triangle count ({}): {}", triangleCount,
+                 fileView.GetPath());
+    return false;
+  }
+
+  vertices.resize(size_t(triangleCount) * 3);
+  indices.resize(size_t(triangleCount) * 3);
+  const uint8_t* records = data + HEADER_SIZE;
+
+  ThreadPool::Instance().ParallelFor(
+      triangleCount, GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          // Records are not 4-byte aligned, so the floats are copied out
+          // as one block.
+          float values[TRIANGLE_FLOAT_COUNT];
+          std::memcpy(values, records + i * TRIANGLE_SIZE, sizeof(values));
+
+          glm::vec3 positions[3] = {
+              glm::vec3(values[3], values[4], values[5]),
+              glm::vec3(values[6], values[7], values[8]),
+              glm::vec3(values[9], values[10], values[11])};
+          glm::vec3 normal(0.0f);
+          if (facetNormals) {
+            normal = GetFacetNormal(glm::vec3(values[0], values[1], values[2]),
+                                    positions[0], positions[1], positions[2]);
+          }
+
+          for (size_t corner = 0; corner < 3; ++corner) {
+            Vertex& vertex = vertices[i * 3 + corner];
+            vertex.position = positions[corner];
+            vertex.normal = normal;
+            vertex.texCoord = glm::vec2(0.0f);
+            vertex.tangent = glm::vec4(0.0f);
+            indices[i * 3 + corner] = static_cast<uint32_t>(i * 3 + corner);
+          }
+        }
+      });
+
+  return true;
+}
+
+uint32_t StlReader::GetTriangleCount(const FileView& fileView) {
+  uint32_t triangleCount = 0;
+  return IsBinaryStl(fileView.GetData(), fileView.GetSize(), triangleCount)
+             ? triangleCount
+             : 0;
+}
+
+void StlReader::ForEachTriangle(
+    const FileView& fileView, size_t begin, size_t end,
+    const std::function<void(const glm::vec3*)>& func) {
+  const uint8_t* records = fileView.GetData() + HEADER_SIZE;
+  for (size_t i = begin; i < end; ++i) {
+    float values[TRIANGLE_FLOAT_COUNT];
+    std::memcpy(values, records + i * TRIANGLE_SIZE, sizeof(values));
+    glm::vec3 positions[3] = {glm::vec3(values[3], values[4], values[5]),
+                              glm::vec3(values[6], values[7], values[8]),
+                              glm::vec3(values[9], values[10], values[11])};
+    func(positions);
+  }
+  fileView.ReleasePages(HEADER_SIZE + begin * TRIANGLE_SIZE,
+                        (end - begin) * TRIANGLE_SIZE);
+}
\ No newline at end of file
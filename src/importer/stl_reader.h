@@ -0,0 +1,30 @@
+#pragma once
+
+#include "../mesh.h"
+#include "../util/file_view.h"
+
+// Standard library
+#include <functional>
+#include <vector>
+
+// Binary STL reader
+// Triangle records are read in place from the mapped file on the thread
+// pool. Every triangle gets its own three vertices; shared corners are left
+// to the vertex welder.
+namespace StlReader {
+
+// facetNormals: Give each vertex the normal of its triangle. Otherwise the
+// normals are left zero, so that welding merges corners by position only.
+// Return false if the file is not a valid binary STL.
+bool Read(const FileView& fileView, bool facetNormals,
+          std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// Return the triangle count of a valid binary STL, otherwise 0
+uint32_t GetTriangleCount(const FileView& fileView);
+
+// Call func with the three corners of each triangle in [begin, end), in file
+// order, then release the pages read. For files too large to read at once.
+void ForEachTriangle(const FileView& fileView, size_t begin, size_t end,
+                     const std::function<void(const glm::vec3*)>& func);
+
+}  // namespace StlReader
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "vertex_welder.h"
+
+#include "../thread_pool.h"
+
+// Standard library
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr size_t GRAIN_SIZE = 64 * 1024;
+constexpr size_t MIN_PARALLEL_COUNT = 256 * 1024;
+
+// position (3) + normal (3) + texCoord (2)
+using WeldKey = std::array<int64_t, 8>;
+
+// Inverse tolerance of each attribute, 0 for a bitwise comparison
+struct InvTolerance {
+  float position;
+  float normal;
+  float texCoord;
+};
+
+float Invert(float tolerance) {
+  return tolerance > 0.0f ? 1.0f / tolerance : 0.0f;
+}
+
+int64_t QuantizeComponent(float value, float invTolerance) {
+  if (invTolerance == 0.0f) {
+    value += 0.0f;  // -0 -> +0
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+  }
+  return static_cast<int64_t>(std::floor(value * invTolerance + 0.5f));
+}
+
+WeldKey MakeKey(const Vertex& vertex, const InvTolerance& invTolerance) {
+  return {QuantizeComponent(vertex.position.x, invTolerance.position),
+          QuantizeComponent(vertex.position.y, invTolerance.position),
+          QuantizeComponent(vertex.position.z, invTolerance.position),
+          QuantizeComponent(vertex.normal.x, invTolerance.normal),
+          QuantizeComponent(vertex.normal.y, invTolerance.normal),
+          QuantizeComponent(vertex.normal.z, invTolerance.normal),
+          QuantizeComponent(vertex.texCoord.x, invTolerance.texCoord),
+          QuantizeComponent(vertex.texCoord.y, invTolerance.texCoord)};
+}
+
+uint32_t HashKey(const WeldKey& key) {
+  uint64_t hash = 0;
+  for (int64_t component : key) {
+    hash = (hash ^ static_cast<uint64_t>(component)) * 0x9e3779b97f4a7c15ull;
+    hash ^= hash >> 32;
+  }
+  // Finalizer of splitmix64, so that linear probing sees well-mixed low bits
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+  hash ^= hash >> 31;
+  return static_cast<uint32_t>(hash);
+}
+
+// Open-addressing table of first occurrences. An entry packs the hash
+// (high 32 bits) and the vertex index (low 32 bits), so probing and growing
+// never touch the vertices themselves.
+class WeldTable {
+ public:
+  // Tables start from an estimate of the unique count instead of the worst
+  // case. A sparse table costs more in cache and TLB misses than the few
+  // rehashes of growing it 4x at a time.
+  explicit WeldTable(size_t vertexCount) {
+    resize(std::max<size_t>(vertexCount / ESTIMATED_SHARE, MIN_CAPACITY));
+  }
+
+  // Return the first vertex equal to vertex i, or i itself if it is new.
+  uint32_t Insert(const std::vector<Vertex>& vertices, uint32_t i,
+                  uint32_t hash, const InvTolerance& invTolerance) {
+    const WeldKey key = MakeKey(vertices[i], invTolerance);
+    for (size_t slot = hash & m_Mask;; slot = (slot + 1) & m_Mask) {
+      uint64_t entry = m_Entries[slot];
+      if (entry == EMPTY_ENTRY) {
+        m_Entries[slot] = (uint64_t(hash) << 32) | i;
+        if (++m_Count * 4 > m_Entries.size() * 3) {
+          resize(m_Entries.size() * GROWTH_FACTOR);
+        }
+        return i;
+      }
+      uint32_t first = static_cast<uint32_t>(entry);
+      if (static_cast<uint32_t>(entry >> 32) == hash &&
+          MakeKey(vertices[first], invTolerance) == key) {
+        return first;
+      }
+    }
+  }
+
+ private:
+  static constexpr uint64_t EMPTY_ENTRY = UINT64_MAX;
+  static constexpr size_t ESTIMATED_SHARE = 4;
+  static constexpr size_t GROWTH_FACTOR = 4;
+  static constexpr size_t MIN_CAPACITY = 1024;
+
+  std::vector<uint64_t> m_Entries;
+  size_t m_Mask{0};
+  size_t m_Count{0};
+
+  void resize(size_t minCapacity) {
+    size_t capacity = MIN_CAPACITY;
+    while (capacity < minCapacity) {
+      capacity <<= 1;
+    }
+
+    std::vector<uint64_t> entries(capacity, EMPTY_ENTRY);
+    m_Mask = capacity - 1;
+    for (uint64_t entry : m_Entries) {
+      if (entry == EMPTY_ENTRY) continue;
+      size_t slot = (entry >> 32) & m_Mask;
+      while (entries[slot] != EMPTY_ENTRY) {
+        slot = (slot + 1) & m_Mask;
+      }
+      entries[slot] = entry;
+    }
+    m_Entries = std::move(entries);
+  }
+};
+
+// Partition of a hash. The high bits pick the partition, the low bits the
+// slot in its table.
+size_t GetPartition(uint32_t hash, size_t partitionCount) {
+  return static_cast<size_t>((uint64_t(hash) * partitionCount) >> 32);
+}
+
+}  // namespace
+
+size_t VertexWelder::Weld(std::vector<Vertex>& vertices,
+                          std::vector<uint32_t>& indices,
+                          const Tolerance& tolerance) {
+  const size_t vertexCount = vertices.size();
+  if (vertexCount == 0) return 0;
+
+  const InvTolerance invTolerance = {Invert(tolerance.position),
+                                     Invert(tolerance.normal),
+                                     Invert(tolerance.texCoord)};
+  ThreadPool& threadPool = ThreadPool::Instance();
+
+  std::vector<uint32_t> hashes(vertexCount);
+  threadPool.ParallelFor(vertexCount, GRAIN_SIZE, [&](size_t begin,
+                                                       size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      hashes[i] = HashKey(MakeKey(vertices[i], invTolerance));
+    }
+  });
+
+  // Equal vertices have equal hashes, so each partition is welded
+  // independently with its own table. Within a partition, vertices are
+  // visited in order, so every vertex is mapped to the first vertex equal to
+  // it, whatever the thread count.
+  std::vector<uint32_t> remap(vertexCount);
+  const size_t partitionCount =
+      vertexCount < MIN_PARALLEL_COUNT ? 1 : threadPool.GetThreadCount() + 1;
+  threadPool.ParallelFor(partitionCount, 1, [&](size_t begin, size_t end) {
+    for (size_t partition = begin; partition < end; ++partition) {
+      size_t count = 0;
+      for (size_t i = 0; i < vertexCount; ++i) {
+        count += GetPartition(hashes[i], partitionCount) == partition;
+      }
+
+      WeldTable table(count);
+      for (size_t i = 0; i < vertexCount; ++i) {
+        const uint32_t hash = hashes[i];
+        if (GetPartition(hash, partitionCount) == partition) {
+          remap[i] = table.Insert(vertices, static_cast<uint32_t>(i), hash,
+                                  invTolerance);
+        }
+      }
+    }
+  });
+
+  // Number the unique vertices in order of first appearance and compact
+  // them to the front. remap[i] never points past i, so the mapping and the
+  // vertices can be rewritten in place.
+  uint32_t uniqueCount = 0;
+  for (size_t i = 0; i < vertexCount; ++i) {
+    if (remap[i] == i) {
+      vertices[uniqueCount] = vertices[i];
+      remap[i] = uniqueCount++;
+    } else {
+      remap[i] = remap[remap[i]];
+    }
+  }
+
+  threadPool.ParallelFor(indices.size(), GRAIN_SIZE, [&](size_t begin,
+                                                         size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      indices[i] = remap[indices[i]];
+    }
+  });
+
+  vertices.resize(uniqueCount);
+  vertices.shrink_to_fit();
+  return uniqueCount;
+}
\ No newline at end of file
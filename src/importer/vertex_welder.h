@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../mesh.h"
+
+// Standard library
+#include <vector>
+
+// Merges vertices with the same position, normal and texCoord, and rewrites
+// the indices to refer to the merged vertices.
+// Each attribute has its own tolerance, as positions, unit normals and UVs
+// have unrelated scales.
+// - tolerance == 0: Components are compared bitwise (-0 equals +0).
+// - tolerance > 0: Components are snapped to a grid of the tolerance before
+//   comparison. The first vertex of each cell is kept.
+// Hashes are computed on the thread pool. Vertices are split by hash into
+// one partition per thread, and each partition finds its unique vertices
+// with an open-addressing table. Tables are sized from an estimate and grow
+// 4x at a time, so even tens of millions of vertices take only a few
+// rehashes. The result does not depend on the thread count. Tangents are
+// ignored and should be computed after welding.
+namespace VertexWelder {
+
+struct Tolerance {
+  float position{0.0f};
+  float normal{0.0f};
+  float texCoord{0.0f};
+};
+
+// Return the number of unique vertices
+size_t Weld(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+            const Tolerance& tolerance = Tolerance());
+
+}  // namespace VertexWelder
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "lod_chain.h"
+
+#include "config/gl_config.h"
+#include "config/log_config.h"
+#include "gl_state.h"
+#include "mesh_simplifier.h"
+#include "thread_pool.h"
+
+// Standard library
+#include <algorithm>
+#include <cfloat>
+
+LodChainUPtr LodChain::New(std::vector<glm::vec3>&& positions,
+                           std::vector<uint32_t>&& indices, uint32_t indexType,
+                           const glm::vec3& boundsMin,
+                           const glm::vec3& boundsMax) {
+  auto lodChain = LodChainUPtr(new LodChain());
+  if (indices.size() / 3 < MIN_TRIANGLE_COUNT) return nullptr;
+
+  lodChain->m_IndexType = indexType;
+  lodChain->m_BoundsMin = boundsMin;
+  lodChain->m_BoundsMax = boundsMax;
+  auto build = std::make_shared<Build>();
+  build->positions = std::move(positions);
+  build->indices = std::move(indices);
+  lodChain->m_Build = build;
+  ThreadPool::Instance().Submit([build]() { LodChain::build(*build); });
+  return std::move(lodChain);
+}
+
+LodChain::~LodChain() {
+  if (m_Build) {
+    m_Build->cancelled = true;
+  }
+}
+
+void LodChain::build(Build& build) {
+  const std::vector<uint32_t>* source = &build.indices;
+  float error = 0.0f;
+  while (build.levels.size() + 1 < MAX_LEVEL_COUNT && !build.cancelled) {
+    size_t targetCount =
+        static_cast<size_t>(source->size() / 3 * LEVEL_RATIO) * 3;
+    float levelError = 0.0f;
+    std::vector<uint32_t> level = MeshSimplifier::Simplify(
+        build.positions, *source, targetCount, FLT_MAX, levelError);
+    if (level.empty() ||
+        level.size() > source->size() * (1.0f - MIN_REDUCTION)) {
+      break;
+    }
+    // Each level is simplified from the previous one, so the errors add up
+    error += levelError;
+    build.levels.push_back(std::move(level));
+    build.errors.push_back(error);
+    source = &build.levels.back();
+  }
+  std::vector<glm::vec3>().swap(build.positions);
+  std::vector<uint32_t>().swap(build.indices);
+  build.done.store(true, std::memory_order_release);
+}
+
+void LodChain::upload() {
+  const size_t indexSize =
+      m_IndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+  size_t indexCount = 0;
+  for (const auto& level : m_Build->levels) {
+    m_Levels.push_back({indexCount * indexSize, level.size(),
+                        m_Build->errors[m_Levels.size()]});
+    indexCount += level.size();
+  }
+
+  if (indexCount > 0) {
+    // Keep the element buffer of the bound vertex layout
+    GLState::Instance().BindVertexArray(0);
+    if (m_IndexType == GL_UNSIGNED_SHORT) {
+      std::vector<uint16_t> shortIndices;
+      shortIndices.reserve(indexCount);
+      for (const auto& level : m_Build->levels) {
+        shortIndices.insert(shortIndices.end(), level.begin(), level.end());
+      }
+      m_IndexBuffer = Buffer::New(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW,
+                                  shortIndices.data(), sizeof(uint16_t),
+                                  indexCount);
+    } else {
+      std::vector<uint32_t> indices;
+      indices.reserve(indexCount);
+      for (const auto& level : m_Build->levels) {
+        indices.insert(indices.end(), level.begin(), level.end());
+      }
+      m_IndexBuffer = Buffer::New(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW,
+                                  indices.data(), sizeof(uint32_t),
+                                  indexCount);
+    }
+    if (!m_IndexBuffer) {
+      m_Levels.clear();
+    }
+  }
+  SPDLOG_INFO("Built {} levels of detail", m_Levels.size() + 1);
+  m_Build.reset();
+}
+
+void LodChain::Update(const glm::mat4& localToClip, float viewportHeight) {
+  if (m_Build && m_Build->done.load(std::memory_order_acquire)) {
+    upload();
+  }
+  m_Level = 0;
+  if (m_Levels.empty()) return;
+
+  // Nearest clip w of the bounds. An error e in model units moves a point by
+  // at most e * |row y| / w in NDC.
+  float minW = FLT_MAX;
+  for (int i = 0; i < 8; ++i) {
+    glm::vec3 corner((i & 1) ? m_BoundsMax.x : m_BoundsMin.x,
+                     (i & 2) ? m_BoundsMax.y : m_BoundsMin.y,
+                     (i & 4) ? m_BoundsMax.z : m_BoundsMin.z);
+    minW = std::min(minW, (localToClip * glm::vec4(corner, 1.0f)).w);
+  }
+  if (minW <= 0.0f) return;  // Bounds reach behind the camera
+
+  glm::vec3 rowY(localToClip[0][1], localToClip[1][1], localToClip[2][1]);
+  float pixelsPerUnit = glm::length(rowY) / minW * viewportHeight * 0.5f;
+  for (size_t i = 0; i < m_Levels.size(); ++i) {
+    if (m_Levels[i].error * pixelsPerUnit > PIXEL_ERROR) break;
+    m_Level = static_cast<uint32_t>(i + 1);
+  }
+}
+
+bool LodChain::Draw(uint32_t primitiveType) const {
+  if (m_Level == 0) return false;
+
+  const Level& level = m_Levels[m_Level - 1];
+  m_IndexBuffer->Bind();
+  glDrawElements(primitiveType, static_cast<GLsizei>(level.elementCount),
+                 m_IndexType, reinterpret_cast<const void*>(level.indexOffset));
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "buffer.h"
+#include "macro/ptr_macro.h"
+
+// Standard library
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// Levels of detail of a triangle mesh as simplified index buffers over its
+// vertex buffer (MeshSimplifier). Level 0 is the mesh itself. Each level
+// halves the triangles of the previous one, and the chain ends when a level
+// saves less than MIN_REDUCTION. The chain is built on the thread pool and
+// uploaded as one index buffer once it is complete. Each frame the coarsest
+// level whose error projects under PIXEL_ERROR is drawn.
+DECLARE_PTR(LodChain)
+class LodChain {
+ public:
+  static constexpr size_t MIN_TRIANGLE_COUNT = 16 * 1024;  // Smaller: no LOD
+  static constexpr size_t MAX_LEVEL_COUNT = 8;             // Level 0 included
+  static constexpr float LEVEL_RATIO = 0.5f;
+  static constexpr float MIN_REDUCTION = 0.1f;
+  static constexpr float PIXEL_ERROR = 1.0f;
+
+  // Start building from the positions and triangles of a mesh. indexType is
+  // the index type of the mesh, used for the levels as well.
+  static LodChainUPtr New(std::vector<glm::vec3>&& positions,
+                          std::vector<uint32_t>&& indices, uint32_t indexType,
+                          const glm::vec3& boundsMin,
+                          const glm::vec3& boundsMax);
+
+  // Cancels the build
+  ~LodChain();
+
+  // Main thread only
+  // Upload the chain if it has been built, and select the level for
+  // localToClip (projection * view * model) and a viewport height in
+  // pixels.
+  void Update(const glm::mat4& localToClip, float viewportHeight);
+  // Levels uploaded so far, level 0 included
+  size_t GetLevelCount() const { return m_Levels.size() + 1; }
+  uint32_t GetLevel() const { return m_Level; }
+  // Draw the selected level with the layout of the mesh bound. Return false
+  // for level 0, which the mesh draws itself.
+  bool Draw(uint32_t primitiveType) const;
+
+ private:
+  LodChain() = default;
+
+  struct Level {
+    uint64_t indexOffset{0};  // Bytes
+    size_t elementCount{0};
+    float error{0.0f};  // Distance from the mesh in model units
+  };
+
+  // Shared with the worker, which may outlive the chain
+  struct Build {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    std::vector<std::vector<uint32_t>> levels;
+    std::vector<float> errors;
+    std::atomic<bool> done{false};
+    std::atomic<bool> cancelled{false};
+  };
+
+  std::shared_ptr<Build> m_Build;
+  BufferUPtr m_IndexBuffer;
+  uint32_t m_IndexType{0};
+  std::vector<Level> m_Levels;  // From level 1
+  uint32_t m_Level{0};
+  glm::vec3 m_BoundsMin{0.0f};
+  glm::vec3 m_BoundsMax{0.0f};
+
+  static void build(Build& build);
+  void upload();
+};
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "config/size_config.h"
 #include "file_loader.h"
 #include "font_manager.h"
+#include "framebuffer.h"
+#include "gl_state.h"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
@@ -97,7 +99,7 @@ void OnMouseMoveEvent(GLFWwindow* window, double xpos, double ypos) {
   ImGui_ImplGlfw_CursorPosCallback(window, xpos, ypos);
 }
 
-int main() {
+int main(int argc, char** argv) {
   SPDLOG_DEBUG("Start program");
 
   // Initialize application
@@ -145,6 +147,9 @@ int main() {
   auto glVersion = reinterpret_cast<const char*>(glGetString(GL_VERSION));
   SPDLOG_DEBUG("OpenGL context version: {}", glVersion);
 
+  // Created before any GL object, so that it outlives their destructors
+  GLState& glState = GLState::Instance();
+
   // Setup ImGui context
   IMGUI_CHECKVERSION();
   ImGui::CreateContext();
@@ -214,6 +219,14 @@ int main() {
   glfwSetMouseButtonCallback(window, OnMouseButtonEvent);
   glfwSetScrollCallback(window, OnScrollEvent);
 
+#ifndef __EMSCRIPTEN__
+  // Files and folders given on the command line are imported like the ones
+  // picked in the dialogs.
+  for (int32_t i = 1; i < argc; ++i) {
+    FileLoader::Instance().LoadPath(argv[i]);
+  }
+#endif
+
   // Main loop
   SPDLOG_DEBUG("Start main loop");
 #ifdef __EMSCRIPTEN__
@@ -233,13 +246,19 @@ int main() {
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
+    // The ImGui backend and GLFW callbacks set GL state directly
+    glState.Invalidate();
+
+    // Upload meshes parsed by the import workers
+    FileLoader::Instance().ProcessImports();
+
     // Render all ImGui-based windows
     app.Render();
 
     ImGui::Render();
 
     // Clear default framebuffer to black
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    Framebuffer::BindToDefault();
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
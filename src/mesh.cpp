@@ -1,105 +1,573 @@
 #include "mesh.h"
 
 #include "config/log_config.h"
+#include "gl_state.h"
+#include "lod_chain.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+#include "meshlet_set.h"
+#include "paged_mesh.h"
 #include "shader_program.h"
+#include "thread_pool.h"
+#include "triangle_bvh.h"
+
+// Standard library
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <memory>
 
 MeshUPtr Mesh::New(std::vector<Vertex>&& vertices,
-                   std::vector<uint32_t>&& indices, uint32_t primitiveType) {
+                   std::vector<uint32_t>&& indices, uint32_t primitiveType,
+                   bool computeTangents, const VertexFormat& format) {
   auto mesh = MeshUPtr(new Mesh());
   if (vertices.empty() || indices.empty()) {
     SPDLOG_ERROR("Vertices or indices are empty");
     return nullptr;
   }
-  mesh->init(std::move(vertices), std::move(indices), primitiveType);
+  mesh->init(std::move(vertices), std::move(indices), primitiveType,
+             computeTangents, format);
+  return std::move(mesh);
+}
+
+MeshUPtr Mesh::New(const Vertex* vertices, size_t vertexCount,
+                   const uint32_t* indices, size_t indexCount,
+                   uint32_t primitiveType, const glm::vec3& boundsMin,
+                   const glm::vec3& boundsMax, const VertexFormat& format) {
+  auto mesh = MeshUPtr(new Mesh());
+  if (vertexCount == 0 || indexCount == 0) {
+    SPDLOG_ERROR("Vertices or indices are empty");
+    return nullptr;
+  }
+  mesh->m_PrimitiveType = primitiveType;
+  mesh->m_VertexFormat = format;
+  mesh->m_BoundsMin = boundsMin;
+  mesh->m_BoundsMax = boundsMax;
+  mesh->upload(vertices, vertexCount, indices, indexCount);
+  return std::move(mesh);
+}
+
+MeshUPtr Mesh::New(const std::vector<MeshAttribute>& attributes,
+                   BufferPtr indexBuffer, uint32_t indexType,
+                   uint64_t indexOffset, size_t elementCount,
+                   uint32_t primitiveType, const glm::vec3& boundsMin,
+                   const glm::vec3& boundsMax) {
+  auto mesh = MeshUPtr(new Mesh());
+  if (attributes.empty() || elementCount == 0) {
+    SPDLOG_ERROR("Attributes or elements are empty");
+    return nullptr;
+  }
+  mesh->m_PrimitiveType = primitiveType;
+  mesh->m_BoundsMin = boundsMin;
+  mesh->m_BoundsMax = boundsMax;
+  mesh->m_IndexType = indexType;
+  mesh->m_IndexOffset = indexOffset;
+  mesh->m_ElementCount = elementCount;
+
+  // The index buffer binding is stored in the vertex layout, so it is bound
+  // after the layout.
+  mesh->m_VertexLayout = VertexLayout::New();
+  for (const auto& attribute : attributes) {
+    attribute.buffer->Bind();
+    mesh->m_VertexLayout->SetAttrib(
+        attribute.location, attribute.componentCount, attribute.componentType,
+        attribute.normalized, attribute.stride, attribute.offset);
+    mesh->m_AttributeBuffers.push_back(attribute.buffer);
+  }
+  mesh->m_IndexBuffer = indexBuffer;
+  if (mesh->m_IndexBuffer) {
+    mesh->m_IndexBuffer->Bind();
+  }
   return std::move(mesh);
 }
 
 Mesh::~Mesh() {}
 
 void Mesh::init(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices,
-                uint32_t primitiveType) {
+                uint32_t primitiveType, bool computeTangents,
+                const VertexFormat& format) {
+  m_Residency = MeshResidency::MIRROR;
   m_Vertices = std::move(vertices);
-  m_Indices = std::move(indices);
+  m_Indices =
+      std::make_shared<const std::vector<uint32_t>>(std::move(indices));
   m_PrimitiveType = primitiveType;
+  m_VertexFormat = format;
 
-  if (m_PrimitiveType == GL_TRIANGLES) {
-    ComputeTangents(m_Vertices, m_Indices);
+  m_BoundsMin = m_BoundsMax = m_Vertices.front().position;
+  for (const auto& vertex : m_Vertices) {
+    m_BoundsMin = glm::min(m_BoundsMin, vertex.position);
+    m_BoundsMax = glm::max(m_BoundsMax, vertex.position);
   }
 
+  if (computeTangents && m_PrimitiveType == GL_TRIANGLES) {
+    ComputeTangents(m_Vertices, *m_Indices);
+  }
+
+  upload(m_Vertices.data(), m_Vertices.size(), m_Indices->data(),
+         m_Indices->size());
+}
+
+void Mesh::upload(const Vertex* vertices, size_t vertexCount,
+                  const uint32_t* indices, size_t indexCount) {
   // NOTE: The order should be as follows:
   // 1. Vertex layout binding
   // 2. Vertex buffer binding
   // 3. Vertex attribute setting
   m_VertexLayout = VertexLayout::New();
-  m_VertexBuffer =
-      Buffer::New(GL_ARRAY_BUFFER, GL_STATIC_DRAW, m_Vertices.data(),
-                  sizeof(Vertex), m_Vertices.size());
-  m_IndexBuffer =
-      Buffer::New(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW, m_Indices.data(),
-                  sizeof(uint32_t), m_Indices.size());
-  m_VertexLayout->SetAttrib(0, 3, GL_FLOAT, false, sizeof(Vertex), 0);
-  m_VertexLayout->SetAttrib(1, 3, GL_FLOAT, false, sizeof(Vertex),
-                            offsetof(Vertex, normal));
-  m_VertexLayout->SetAttrib(2, 2, GL_FLOAT, false, sizeof(Vertex),
-                            offsetof(Vertex, texCoord));
-  m_VertexLayout->SetAttrib(3, 3, GL_FLOAT, false, sizeof(Vertex),
-                            offsetof(Vertex, tangent));
+  if (m_VertexFormat.IsInterleavedVertex()) {
+    m_VertexBuffer = Buffer::New(GL_ARRAY_BUFFER, GL_STATIC_DRAW, vertices,
+                                 sizeof(Vertex), vertexCount);
+  } else {
+    std::vector<uint8_t> positionStream;
+    std::vector<uint8_t> attributeStream;
+    m_VertexFormat.Encode(vertices, vertexCount, m_BoundsMin, m_BoundsMax,
+                          positionStream, attributeStream);
+    BufferPtr positionBuffer =
+        Buffer::New(GL_ARRAY_BUFFER, GL_STATIC_DRAW, positionStream.data(),
+                    m_VertexFormat.GetPositionStreamStride(), vertexCount);
+    if (m_VertexFormat.splitPositions) {
+      m_PositionBuffer = positionBuffer;
+      m_VertexBuffer =
+          Buffer::New(GL_ARRAY_BUFFER, GL_STATIC_DRAW, attributeStream.data(),
+                      m_VertexFormat.GetAttributeStreamStride(), vertexCount);
+    } else {
+      m_VertexBuffer = positionBuffer;
+    }
+  }
+
+  // 0xFFFF is left unused: WebGL 2 always restarts primitives on it
+  if (vertexCount <= UINT16_MAX) {
+    std::vector<uint16_t> shortIndices(indices, indices + indexCount);
+    m_IndexBuffer = Buffer::New(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW,
+                                shortIndices.data(), sizeof(uint16_t),
+                                indexCount);
+    m_IndexType = GL_UNSIGNED_SHORT;
+  } else {
+    m_IndexBuffer = Buffer::New(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW,
+                                indices, sizeof(uint32_t), indexCount);
+    m_IndexType = GL_UNSIGNED_INT;
+  }
+  m_ElementCount = indexCount;
+  setVertexAttribs();
+}
+
+bool Mesh::SetResidency(MeshResidency residency) {
+  if (residency == m_Residency) return true;
+
+  if (residency == MeshResidency::RELEASED) {
+    std::vector<Vertex>().swap(m_Vertices);
+    m_Positions.reset();
+    m_Indices.reset();
+  } else if (residency == MeshResidency::POSITIONS) {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    if (!ReadPositions(positions, indices)) return false;
+    std::vector<Vertex>().swap(m_Vertices);
+    m_Positions =
+        std::make_shared<const std::vector<glm::vec3>>(std::move(positions));
+    m_Indices =
+        std::make_shared<const std::vector<uint32_t>>(std::move(indices));
+  } else {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    if (!ReadGeometry(vertices, indices)) return false;
+    m_Positions.reset();
+    m_Vertices.swap(vertices);
+    m_Indices =
+        std::make_shared<const std::vector<uint32_t>>(std::move(indices));
+  }
+  m_Residency = residency;
+  return true;
+}
+
+bool Mesh::ReadGeometry(std::vector<Vertex>& vertices,
+                        std::vector<uint32_t>& indices) const {
+  if (m_Residency == MeshResidency::MIRROR) {
+    vertices = m_Vertices;
+    indices = *m_Indices;
+    return true;
+  }
+  return readCache(vertices, indices) || readBack(vertices, indices);
+}
+
+bool Mesh::ReadPositions(std::vector<glm::vec3>& positions,
+                         std::vector<uint32_t>& indices) const {
+  if (m_Residency == MeshResidency::POSITIONS) {
+    positions = *m_Positions;
+    indices = *m_Indices;
+    return true;
+  }
+
+  std::vector<Vertex> readVertices;
+  const std::vector<Vertex>* vertices = &m_Vertices;
+  if (m_Residency == MeshResidency::MIRROR) {
+    indices = *m_Indices;
+  } else if (ReadGeometry(readVertices, indices)) {
+    vertices = &readVertices;
+  } else {
+    return false;
+  }
+  positions.resize(vertices->size());
+  for (size_t i = 0; i < vertices->size(); ++i) {
+    positions[i] = (*vertices)[i].position;
+  }
+  return true;
+}
+
+bool Mesh::readCache(std::vector<Vertex>& vertices,
+                     std::vector<uint32_t>& indices) const {
+  if (m_CachePath.empty() || !m_VertexBuffer) return false;
+
+  // The cache may have been rewritten since the upload.
+  MeshCacheUPtr cache = MeshCache::New(m_CachePath);
+  if (!cache || cache->GetVertexCount() != m_VertexBuffer->GetCount() ||
+      cache->GetIndexCount() != m_ElementCount) {
+    SPDLOG_WARN("Mesh cache does not match the mesh: {}", m_CachePath);
+    return false;
+  }
+  vertices.assign(cache->GetVertices(),
+                  cache->GetVertices() + cache->GetVertexCount());
+  indices.assign(cache->GetIndices(),
+                 cache->GetIndices() + cache->GetIndexCount());
+  return true;
+}
+
+bool Mesh::readBack(std::vector<Vertex>& vertices,
+                    std::vector<uint32_t>& indices) const {
+  if (m_PagedMesh || !m_AttributeBuffers.empty() || !m_IndexBuffer) {
+    return false;
+  }
+
+  const size_t vertexCount = m_VertexBuffer->GetCount();
+  const Buffer& positionBuffer =
+      m_PositionBuffer ? *m_PositionBuffer : *m_VertexBuffer;
+  std::vector<uint8_t> positionStream(positionBuffer.GetStride() *
+                                      vertexCount);
+  positionBuffer.GetSubData(0, positionStream.data(), vertexCount);
+  std::vector<uint8_t> attributeStream;
+  if (m_PositionBuffer) {
+    attributeStream.resize(m_VertexBuffer->GetStride() * vertexCount);
+    m_VertexBuffer->GetSubData(0, attributeStream.data(), vertexCount);
+  }
+  vertices.resize(vertexCount);
+  m_VertexFormat.Decode(positionStream.data(), attributeStream.data(),
+                        vertexCount, m_BoundsMin, m_BoundsMax,
+                        vertices.data());
+
+  if (m_IndexType == GL_UNSIGNED_SHORT) {
+    std::vector<uint16_t> shortIndices(m_ElementCount);
+    m_IndexBuffer->GetSubData(0, shortIndices.data(), m_ElementCount);
+    indices.assign(shortIndices.begin(), shortIndices.end());
+  } else {
+    indices.resize(m_ElementCount);
+    m_IndexBuffer->GetSubData(0, indices.data(), m_ElementCount);
+  }
+  return true;
+}
+
+void Mesh::setVertexAttribs() {
+  const Buffer& positionStream =
+      m_PositionBuffer ? *m_PositionBuffer : *m_VertexBuffer;
+  m_VertexFormat.SetAttribs(*m_VertexLayout, positionStream, *m_VertexBuffer);
 }
 
 void Mesh::ComputeTangents(std::vector<Vertex>& vertices,
                            const std::vector<uint32_t>& indices) {
-  auto compute = [](const glm::vec3& pos1, const glm::vec3& pos2,
-                    const glm::vec3& pos3, const glm::vec2& uv1,
-                    const glm::vec2& uv2, const glm::vec2& uv3) -> glm::vec3 {
-    auto edge1 = pos2 - pos1;
-    auto edge2 = pos3 - pos1;
-    auto deltaUV1 = uv2 - uv1;
-    auto deltaUV2 = uv3 - uv1;
-    float det = (deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x);
-    if (det != 0.0f) {
-      auto invDet = 1.0f / det;
-      return invDet * (deltaUV2.y * edge1 - deltaUV1.y * edge2);
-    } else {
-      return glm::vec3(0.0f, 0.0f, 0.0f);
-    }
-  };
+  const size_t vertexCount = vertices.size();
+  const size_t cornerCount = indices.size() / 3 * 3;
+  ThreadPool& threadPool = ThreadPool::Instance();
+
+  // Derivatives of the position along u and v on each triangle
+  std::vector<glm::vec3> triangleTangents(cornerCount / 3);
+  std::vector<glm::vec3> triangleBitangents(cornerCount / 3);
+  threadPool.ParallelFor(
+      cornerCount / 3, TANGENT_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const Vertex& v1 = vertices[indices[i * 3]];
+          const Vertex& v2 = vertices[indices[i * 3 + 1]];
+          const Vertex& v3 = vertices[indices[i * 3 + 2]];
+          glm::vec3 edge1 = v2.position - v1.position;
+          glm::vec3 edge2 = v3.position - v1.position;
+          glm::vec2 deltaUV1 = v2.texCoord - v1.texCoord;
+          glm::vec2 deltaUV2 = v3.texCoord - v1.texCoord;
+          float det = deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x;
+          if (det == 0.0f) {
+            triangleTangents[i] = triangleBitangents[i] = glm::vec3(0.0f);
+            continue;
+          }
+          float invDet = 1.0f / det;
+          triangleTangents[i] =
+              (edge1 * deltaUV2.y - edge2 * deltaUV1.y) * invDet;
+          triangleBitangents[i] =
+              (edge2 * deltaUV1.x - edge1 * deltaUV2.x) * invDet;
+        }
+      });
 
-  // Initialize
-  std::vector<glm::vec3> tangents(vertices.size(), glm::vec3(0.0f, 0.0f, 0.0f));
+  // Triangles around each vertex. Lists are sorted after filling, so the
+  // sums below do not depend on the thread count or scheduling.
+  std::unique_ptr<std::atomic<uint32_t>[]> cursors(
+      new std::atomic<uint32_t>[vertexCount]());
+  threadPool.ParallelFor(cornerCount, TANGENT_GRAIN_SIZE,
+                         [&](size_t begin, size_t end) {
+                           for (size_t i = begin; i < end; ++i) {
+                             cursors[indices[i]].fetch_add(
+                                 1, std::memory_order_relaxed);
+                           }
+                         });
+  std::vector<uint32_t> offsets(vertexCount + 1, 0);
+  for (size_t i = 0; i < vertexCount; ++i) {
+    offsets[i + 1] = offsets[i] + cursors[i].load(std::memory_order_relaxed);
+    cursors[i].store(offsets[i], std::memory_order_relaxed);
+  }
+  std::vector<uint32_t> adjacency(cornerCount);
+  threadPool.ParallelFor(
+      cornerCount, TANGENT_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          uint32_t slot =
+              cursors[indices[i]].fetch_add(1, std::memory_order_relaxed);
+          adjacency[slot] = static_cast<uint32_t>(i / 3);
+        }
+      });
+  cursors.reset();
+
+  // Sum per vertex, then Gram-Schmidt against the normal. w is the sign of
+  // the bitangent relative to cross(normal, tangent), i.e. the handedness.
+  threadPool.ParallelFor(
+      vertexCount, TANGENT_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          auto first = adjacency.begin() + offsets[i];
+          auto last = adjacency.begin() + offsets[i + 1];
+          std::sort(first, last);
+          glm::vec3 tangent(0.0f);
+          glm::vec3 bitangent(0.0f);
+          for (auto it = first; it != last; ++it) {
+            tangent += triangleTangents[*it];
+            bitangent += triangleBitangents[*it];
+          }
+
+          const glm::vec3& normal = vertices[i].normal;
+          tangent -= normal * glm::dot(normal, tangent);
+          float length = glm::length(tangent);
+          if (length <= FLT_MIN) {
+            // No texture gradient: Any direction perpendicular to the normal
+            glm::vec3 axis = std::abs(normal.x) < 0.9f
+                                 ? glm::vec3(1.0f, 0.0f, 0.0f)
+                                 : glm::vec3(0.0f, 1.0f, 0.0f);
+            tangent = glm::cross(normal, axis);
+            length = glm::length(tangent);
+            if (length <= FLT_MIN) {
+              tangent = axis;
+              length = 1.0f;
+            }
+          }
+          float handedness =
+              glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? -1.0f
+                                                                      : 1.0f;
+          vertices[i].tangent = glm::vec4(tangent / length, handedness);
+        }
+      });
+}
 
-  // accumulate triangle tangents to each vertex
-  for (size_t i = 0; i < indices.size(); i += 3) {
+void Mesh::ComputeNormals(std::vector<Vertex>& vertices,
+                          const std::vector<uint32_t>& indices) {
+  std::vector<glm::vec3> normals(vertices.size(), glm::vec3(0.0f, 0.0f, 0.0f));
+
+  // Accumulate area-weighted triangle normals to each vertex
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
     auto v1 = indices[i];
     auto v2 = indices[i + 1];
     auto v3 = indices[i + 2];
+    auto normal = glm::cross(vertices[v2].position - vertices[v1].position,
+                             vertices[v3].position - vertices[v1].position);
+    normals[v1] += normal;
+    normals[v2] += normal;
+    normals[v3] += normal;
+  }
+
+  // Normalize
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    float length = glm::length(normals[i]);
+    vertices[i].normal =
+        length > 0.0f ? normals[i] / length : glm::vec3(0.0f, 0.0f, 1.0f);
+  }
+}
 
-    tangents[v1] += compute(vertices[v1].position, vertices[v2].position,
-                            vertices[v3].position, vertices[v1].texCoord,
-                            vertices[v2].texCoord, vertices[v3].texCoord);
+void Mesh::BuildLods() {
+  if (m_Lods || m_PagedMesh || !m_AttributeBuffers.empty() ||
+      !m_IndexBuffer || m_PrimitiveType != GL_TRIANGLES ||
+      m_ElementCount / 3 < LodChain::MIN_TRIANGLE_COUNT) {
+    return;
+  }
+  std::vector<glm::vec3> positions;
+  std::vector<uint32_t> indices;
+  if (!ReadPositions(positions, indices)) return;
+  m_Lods = LodChain::New(std::move(positions), std::move(indices), m_IndexType,
+                         m_BoundsMin, m_BoundsMax);
+}
 
-    tangents[v2] = compute(vertices[v2].position, vertices[v3].position,
-                           vertices[v1].position, vertices[v2].texCoord,
-                           vertices[v3].texCoord, vertices[v1].texCoord);
+void Mesh::BuildBvh() {
+  if (m_Bvh || m_PagedMesh || !m_AttributeBuffers.empty() || !m_IndexBuffer ||
+      m_PrimitiveType != GL_TRIANGLES) {
+    return;
+  }
+  std::shared_ptr<const std::vector<glm::vec3>> positions = m_Positions;
+  std::shared_ptr<const std::vector<uint32_t>> indices = m_Indices;
+  if (!positions || !indices) {
+    std::vector<glm::vec3> readPositions;
+    std::vector<uint32_t> readIndices;
+    if (!ReadPositions(readPositions, readIndices)) return;
+    if (!positions) {
+      positions = std::make_shared<const std::vector<glm::vec3>>(
+          std::move(readPositions));
+    }
+    if (!indices) {
+      indices = std::make_shared<const std::vector<uint32_t>>(
+          std::move(readIndices));
+    }
+  }
+  m_Bvh = TriangleBvh::New(std::move(positions), std::move(indices));
+}
 
-    tangents[v3] = compute(vertices[v3].position, vertices[v1].position,
-                           vertices[v2].position, vertices[v3].texCoord,
-                           vertices[v1].texCoord, vertices[v2].texCoord);
+void Mesh::BuildBvh(std::vector<glm::vec3>&& positions,
+                    std::vector<uint32_t>&& indices) {
+  if (m_Bvh || m_AttributeBuffers.empty() ||
+      m_PrimitiveType != GL_TRIANGLES) {
+    return;
+  }
+  for (uint32_t index : indices) {
+    if (index >= positions.size()) {
+      SPDLOG_WARN("Indices exceed the positions, no BVH is built");
+      return;
+    }
   }
+  m_Bvh = TriangleBvh::New(
+      std::make_shared<const std::vector<glm::vec3>>(std::move(positions)),
+      std::make_shared<const std::vector<uint32_t>>(std::move(indices)));
+}
 
-  // Normalize
-  for (size_t i = 0; i < vertices.size(); ++i) {
-    vertices[i].tangent = glm::normalize(tangents[i]);
+void Mesh::SetMeshlets(const Meshlet* meshlets, size_t count) {
+  m_Meshlets.reset();
+  if (count == 0 || m_PagedMesh || !m_AttributeBuffers.empty() ||
+      !m_IndexBuffer || m_PrimitiveType != GL_TRIANGLES) {
+    return;
   }
+  for (size_t i = 0; i < count; ++i) {
+    if (size_t(meshlets[i].indexOffset) + meshlets[i].indexCount >
+        m_ElementCount) {
+      SPDLOG_WARN("Meshlets exceed the index buffer");
+      return;
+    }
+  }
+  m_Meshlets = MeshletSet::New(meshlets, count, m_IndexType);
 }
 
-void Mesh::Draw(const ShaderProgram* program) const {
-  m_VertexLayout->Bind();
+void Mesh::UpdateResidency(const glm::mat4& localToClip,
+                           float viewportHeight) const {
+  if (m_PagedMesh) {
+    m_PagedMesh->Update(localToClip);
+    return;
+  }
+  if (m_Lods) {
+    m_Lods->Update(localToClip, viewportHeight);
+  }
+  if (m_Meshlets && (!m_Lods || m_Lods->GetLevel() == 0)) {
+    m_Meshlets->Cull(localToClip);
+  }
+}
+
+void Mesh::Draw(const ShaderProgram* program, bool primitiveIds) const {
   if (m_Material) {
     m_Material->SetToProgram(program);
   }
+  if (m_PagedMesh) {
+    m_PagedMesh->Draw(program);
+    return;
+  }
+  if (m_ElementCount == 0) return;
+
+  setVertexFormatUniforms(program);
+  m_VertexLayout->Bind();
+  drawElements(program, primitiveIds);
+}
+
+void Mesh::setVertexFormatUniforms(const ShaderProgram* program) const {
+  glm::vec3 positionOffset;
+  glm::vec3 positionScale;
+  m_VertexFormat.GetPositionDecode(m_BoundsMin, m_BoundsMax, positionOffset,
+                                   positionScale);
+  const ShaderProgram::DrawUniforms& uniforms = program->GetDrawUniforms();
+  program->SetUniform(uniforms.positionOffset, positionOffset);
+  program->SetUniform(uniforms.positionScale, positionScale);
+  program->SetUniform(uniforms.octahedralNormal,
+                      m_VertexFormat.octahedralNormals ? 1 : 0);
+}
+
+void Mesh::drawElements(const ShaderProgram* program,
+                        bool primitiveIds) const {
+  // Coarser levels have triangles of their own
+  bool coarserLevel = m_Lods && m_Lods->GetLevel() > 0;
+  program->SetUniform(program->GetDrawUniforms().primitiveBase,
+                      primitiveIds && !coarserLevel ? 0 : -1);
+  if (m_Lods && m_Lods->Draw(m_PrimitiveType)) {
+    m_IndexBuffer->Bind();
+  } else if (m_Meshlets) {
+    m_Meshlets->Draw(m_PrimitiveType, primitiveIds ? program : nullptr);
+  } else if (m_IndexBuffer) {
+    glDrawElements(m_PrimitiveType, static_cast<GLsizei>(m_ElementCount),
+                   m_IndexType, reinterpret_cast<const void*>(m_IndexOffset));
+  } else {
+    glDrawArrays(m_PrimitiveType, 0, static_cast<GLsizei>(m_ElementCount));
+  }
+}
+
+MeshUPtr Mesh::New(PagedMeshUPtr pagedMesh) {
+  auto mesh = MeshUPtr(new Mesh());
+  if (!pagedMesh) {
+    SPDLOG_ERROR("Paged mesh is null");
+    return nullptr;
+  }
+  mesh->m_BoundsMin = pagedMesh->GetBoundsMin();
+  mesh->m_BoundsMax = pagedMesh->GetBoundsMax();
+  mesh->m_PagedMesh = std::move(pagedMesh);
+  return std::move(mesh);
+}
+
+MeshUPtr Mesh::CreateGrowing() {
+  auto mesh = MeshUPtr(new Mesh());
+  mesh->m_VertexFormat.splitPositions = false;
+  mesh->m_BoundsMin = glm::vec3(FLT_MAX);
+  mesh->m_BoundsMax = glm::vec3(-FLT_MAX);
+  return std::move(mesh);
+}
+
+void Mesh::Append(const std::vector<Vertex>& corners) {
+  if (corners.empty() || m_IndexBuffer) return;
+
+  size_t capacity = m_VertexBuffer ? m_VertexBuffer->GetCount() : 0;
+  size_t count = m_ElementCount + corners.size();
+  if (count > capacity) {
+    capacity = std::max({capacity * 2, count, GROWING_MIN_CAPACITY});
+    BufferPtr buffer = Buffer::New(GL_ARRAY_BUFFER, GL_STATIC_DRAW, nullptr,
+                                   sizeof(Vertex), capacity);
+    if (m_ElementCount > 0) {
+      GLState& state = GLState::Instance();
+      state.BindBuffer(GL_COPY_READ_BUFFER, m_VertexBuffer->Get());
+      state.BindBuffer(GL_COPY_WRITE_BUFFER, buffer->Get());
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                          m_ElementCount * sizeof(Vertex));
+    }
+    m_VertexBuffer = buffer;
+    m_VertexLayout = VertexLayout::New();
+    setVertexAttribs();
+  }
 
-  glDrawElements(m_PrimitiveType, m_IndexBuffer->GetCount(), GL_UNSIGNED_INT,
-                 0);
+  m_VertexBuffer->SetSubData(m_ElementCount, corners.data(), corners.size());
+  m_ElementCount = count;
+  for (const auto& corner : corners) {
+    m_BoundsMin = glm::min(m_BoundsMin, corner.position);
+    m_BoundsMax = glm::max(m_BoundsMax, corner.position);
+  }
 }
 
 MeshUPtr Mesh::CreateBox() {
@@ -187,7 +655,7 @@ MeshUPtr Mesh::CreateSphere(uint32_t latiSegmentCount,
       auto point = glm::vec3(cosPhi * cosTheta, sinPhi, -cosPhi * sinTheta);
 
       vertices[i * circleVertCount + j] =
-          Vertex{point * 0.5f, point, glm::vec2(u, v), glm::vec3(0.0f)};
+          Vertex{point * 0.5f, point, glm::vec2(u, v), glm::vec4(0.0f)};
     }
   }
 
@@ -205,5 +673,6 @@ MeshUPtr Mesh::CreateSphere(uint32_t latiSegmentCount,
     }
   }
 
+  MeshOptimizer::Optimize(vertices, indices);
   return New(std::move(vertices), std::move(indices), GL_TRIANGLES);
 }
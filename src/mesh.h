@@ -1,28 +1,81 @@
 #pragma once
 
 #include "buffer.h"
+#include "enum/mesh_enums.h"
 #include "macro/ptr_macro.h"
 #include "render_material.h"
+#include "vertex_format.h"
 #include "vertex_layout.h"
 
 // Standard library
+#include <string>
 #include <vector>
 
 class ShaderProgram;
+DECLARE_PTR(LodChain)
+DECLARE_PTR(MeshletSet)
+DECLARE_PTR(PagedMesh)
+DECLARE_PTR(TriangleBvh)
 
 struct Vertex {
   glm::vec3 position;
   glm::vec3 normal;
   glm::vec2 texCoord;
-  glm::vec3 tangent;
+  glm::vec4 tangent;  // w: Handedness of the bitangent (1 or -1)
+};
+
+// Cluster of triangles drawn as one range of the index buffer, with bounds
+// for culling (MeshletBuilder). Plain floats, so that it is stored raw in
+// mesh caches.
+struct Meshlet {
+  float center[3]{};  // Bounding sphere
+  float radius{0.0f};
+  float coneAxis[3]{};  // Average normal of the triangles
+  float coneSin{1.0f};  // Sine of the cone half angle, 1: Never back-facing
+  uint32_t indexOffset{0};
+  uint32_t indexCount{0};
+};
+
+// Vertex attribute sourced from a buffer which may be shared by several
+// meshes, e.g. a glTF buffer view
+struct MeshAttribute {
+  uint32_t location{0};
+  BufferPtr buffer;
+  int32_t componentCount{3};
+  uint32_t componentType{GL_FLOAT};
+  bool normalized{false};
+  size_t stride{0};
+  uint64_t offset{0};
 };
 
 DECLARE_PTR(Mesh)
 class Mesh {
  public:
+  // computeTangents: false if the vertices already carry tangents
+  // format: Encoding in the vertex buffer. Indices are stored as uint16
+  // whenever the vertex count allows it.
   static MeshUPtr New(std::vector<Vertex>&& vertices,
-                      std::vector<uint32_t>&& indices,
-                      uint32_t primitiveType);
+                      std::vector<uint32_t>&& indices, uint32_t primitiveType,
+                      bool computeTangents = true,
+                      const VertexFormat& format = VertexFormat());
+  // Upload complete geometry (tangents included) as is, e.g. from a mapped
+  // mesh cache. No CPU-side copy of the vertices and indices is kept.
+  static MeshUPtr New(const Vertex* vertices, size_t vertexCount,
+                      const uint32_t* indices, size_t indexCount,
+                      uint32_t primitiveType, const glm::vec3& boundsMin,
+                      const glm::vec3& boundsMax,
+                      const VertexFormat& format = VertexFormat());
+  // Draw from existing buffers. If indexBuffer is nullptr, the vertices are
+  // drawn in order and elementCount is the vertex count.
+  static MeshUPtr New(const std::vector<MeshAttribute>& attributes,
+                      BufferPtr indexBuffer, uint32_t indexType,
+                      uint64_t indexOffset, size_t elementCount,
+                      uint32_t primitiveType, const glm::vec3& boundsMin,
+                      const glm::vec3& boundsMax);
+  // Draw the resident chunks of a paged mesh
+  static MeshUPtr New(PagedMeshUPtr pagedMesh);
+  // Empty mesh which grows with Append(), drawn without indices
+  static MeshUPtr CreateGrowing();
   static MeshUPtr CreateBox();
   static MeshUPtr CreateSphere(uint32_t latiSegmentCount = 16,
                                uint32_t longiSegmentCount = 32);
@@ -30,30 +83,130 @@ class Mesh {
   ~Mesh();
 
   const VertexLayout* GetVertexLayout() const { return m_VertexLayout.get(); }
+  // Vertex array object, 0 if the mesh has none
+  uint32_t GetVertexArray() const {
+    return m_VertexLayout ? m_VertexLayout->Get() : 0;
+  }
   BufferPtr GetVertexBuffer() const { return m_VertexBuffer; }
+  // Position stream, or nullptr if positions are interleaved
+  BufferPtr GetPositionBuffer() const { return m_PositionBuffer; }
   BufferPtr GetIndexBuffer() const { return m_IndexBuffer; }
   RenderMaterialPtr GetMaterial() const { return m_Material; }
+  const VertexFormat& GetVertexFormat() const { return m_VertexFormat; }
+  const glm::vec3& GetBoundsMin() const { return m_BoundsMin; }
+  const glm::vec3& GetBoundsMax() const { return m_BoundsMax; }
 
   void SetMaterial(RenderMaterialPtr material) { m_Material = material; }
 
-  void Draw(const ShaderProgram* program) const;
+  // Meshes from New(vertices, indices) start as MIRROR, others as RELEASED.
+  MeshResidency GetResidency() const { return m_Residency; }
+  // Keep, shrink or drop the CPU-side copy. A fuller copy than the current
+  // one is read back with ReadGeometry(). Return false if it cannot be.
+  bool SetResidency(MeshResidency residency);
+  // Mesh cache holding the uploaded geometry, read instead of the GPU
+  void SetCachePath(const std::string& cachePath) { m_CachePath = cachePath; }
+  // Copy the geometry from the CPU-side copy, the mesh cache or the GPU, in
+  // that order. Compact vertex formats read back from the GPU keep their
+  // quantization error. Meshes drawn from shared attribute buffers or pages
+  // cannot be read. Main thread only.
+  bool ReadGeometry(std::vector<Vertex>& vertices,
+                    std::vector<uint32_t>& indices) const;
+  // Like ReadGeometry(), but a POSITIONS copy is enough.
+  bool ReadPositions(std::vector<glm::vec3>& positions,
+                     std::vector<uint32_t>& indices) const;
+
+  // Add triangles (three corners each) to a mesh from CreateGrowing(). The
+  // vertex buffer doubles when full, so appends are amortized.
+  void Append(const std::vector<Vertex>& corners);
 
+  // Start building levels of detail in the background (LodChain). Only
+  // triangle meshes with their own buffers and at least
+  // LodChain::MIN_TRIANGLE_COUNT triangles get them. Main thread only.
+  void BuildLods();
+  const LodChain* GetLods() const { return m_Lods.get(); }
+  // Cull and draw the triangles by meshlet (MeshletSet). The meshlets must
+  // be ranges of the index buffer. Ignored for meshes without their own
+  // index buffer.
+  void SetMeshlets(const Meshlet* meshlets, size_t count);
+  const MeshletSet* GetMeshlets() const { return m_Meshlets.get(); }
+  // Start building a picking BVH in the background (TriangleBvh). Only for
+  // triangle meshes with their own buffers. It shares the CPU-side
+  // positions and indices if they are kept. Main thread only.
+  void BuildBvh();
+  // Same for triangle meshes drawn from shared attribute buffers, which
+  // cannot be read back, from the positions and indices of the source
+  void BuildBvh(std::vector<glm::vec3>&& positions,
+                std::vector<uint32_t>&& indices);
+  const TriangleBvh* GetBvh() const { return m_Bvh.get(); }
+
+  bool IsPaged() const { return m_PagedMesh != nullptr; }
+  // Page the chunks inside the view in and others out, select the level of
+  // detail and cull the meshlets. localToClip is projection * view * model,
+  // and viewportHeight is in pixels.
+  void UpdateResidency(const glm::mat4& localToClip,
+                       float viewportHeight) const;
+  // primitiveIds: Set u_primitiveBase, so that gl_PrimitiveID +
+  // u_primitiveBase is the triangle index for every draw. Meshlets are then
+  // drawn range by range. Without it, or where triangles are not those of
+  // the index buffer (paged meshes and coarser LODs), it is -1.
+  void Draw(const ShaderProgram* program, bool primitiveIds = false) const;
+
+  // Smooth vertex normals from the triangles around each vertex
+  static void ComputeNormals(std::vector<Vertex>& vertices,
+                             const std::vector<uint32_t>& indices);
+  // Tangents along the u direction of the texture coordinates, summed over
+  // the triangles around each vertex and orthogonalized against its normal.
+  // Runs on the thread pool with results independent of the thread count.
   static void ComputeTangents(std::vector<Vertex>& vertices,
                               const std::vector<uint32_t>& indices);
 
  private:
+  static constexpr size_t GROWING_MIN_CAPACITY = 64 * 1024;  // Vertices
+  static constexpr size_t TANGENT_GRAIN_SIZE = 64 * 1024;
+
   Mesh() = default;
 
   uint32_t m_PrimitiveType{GL_TRIANGLES};
   VertexLayoutUPtr m_VertexLayout;
-  BufferPtr m_VertexBuffer;
+  BufferPtr m_VertexBuffer;  // Interleaved, or all but positions
+  BufferPtr m_PositionBuffer;
   BufferPtr m_IndexBuffer;
+  std::vector<BufferPtr> m_AttributeBuffers;  // Shared attribute buffers
+  VertexFormat m_VertexFormat;
+  uint32_t m_IndexType{GL_UNSIGNED_INT};
+  uint64_t m_IndexOffset{0};
+  size_t m_ElementCount{0};
+  PagedMeshUPtr m_PagedMesh;  // Chunks instead of own buffers
+  LodChainUPtr m_Lods;
+  MeshletSetUPtr m_Meshlets;
+  TriangleBvhUPtr m_Bvh;
 
   RenderMaterialPtr m_Material;
 
+  // Axis-aligned bounding box in model space
+  glm::vec3 m_BoundsMin{0.0f};
+  glm::vec3 m_BoundsMax{0.0f};
+
+  // CPU-side copy (see MeshResidency). m_Indices is kept by MIRROR and
+  // POSITIONS. Positions and indices are shared with m_Bvh.
+  MeshResidency m_Residency{MeshResidency::RELEASED};
   std::vector<Vertex> m_Vertices;
-  std::vector<uint32_t> m_Indices;
+  std::shared_ptr<const std::vector<glm::vec3>> m_Positions;
+  std::shared_ptr<const std::vector<uint32_t>> m_Indices;
+  std::string m_CachePath;
 
-  void init(std::vector<Vertex>&& vertices,
-            std::vector<uint32_t>&& indices, uint32_t primitiveType);
+  void init(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices,
+            uint32_t primitiveType, bool computeTangents,
+            const VertexFormat& format);
+  void upload(const Vertex* vertices, size_t vertexCount,
+              const uint32_t* indices, size_t indexCount);
+  bool readCache(std::vector<Vertex>& vertices,
+                 std::vector<uint32_t>& indices) const;
+  bool readBack(std::vector<Vertex>& vertices,
+                std::vector<uint32_t>& indices) const;
+  // Point the attributes of m_VertexLayout at the vertex streams, encoded
+  // with m_VertexFormat
+  void setVertexAttribs();
+  void setVertexFormatUniforms(const ShaderProgram* program) const;
+  void drawElements(const ShaderProgram* program, bool primitiveIds) const;
 };
\ No newline at end of file
@@ -0,0 +1,281 @@
+#include "mesh_cache.h"
+
+#include "config/log_config.h"
+#include "util/memory_stream_buffer.h"
+#include "util/path_util.h"
+
+// Standard library
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+// cereal
+#include <cereal/archives/binary.hpp>
+#include <cereal/cereal.hpp>
+
+CEREAL_CLASS_VERSION(MeshCache::Header, 3);
+
+namespace {
+
+constexpr char MAGIC[8] = {'C', 'M', 'E', 'S', 'H', '\0', '\0', '\0'};
+constexpr size_t PREFIX_SIZE = sizeof(MAGIC) + 2 * sizeof(uint32_t);
+
+size_t AlignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+std::string SerializeHeader(const MeshCache::Header& header) {
+  std::ostringstream stream(std::ios::binary);
+  {
+    cereal::BinaryOutputArchive archive(stream);
+    archive(header);
+  }
+  return stream.str();
+}
+
+}  // namespace
+
+bool MeshCache::GetSourceStamp(const std::string& sourcePath, uint64_t& size,
+                               int64_t& time) {
+  std::error_code error;
+  size = std::filesystem::file_size(sourcePath, error);
+  if (error) return false;
+  auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+  if (error) return false;
+  time = static_cast<int64_t>(writeTime.time_since_epoch().count());
+  return true;
+}
+
+std::string MeshCache::GetCachePath(const std::string& sourcePath) {
+  return sourcePath + ".cmesh";
+}
+
+MeshCacheUPtr MeshCache::New(const std::string& cachePath,
+                             const std::string& sourcePath,
+                             uint64_t optionsHash) {
+  auto cache = MeshCacheUPtr(new MeshCache());
+  if (!cache->open(cachePath, sourcePath, optionsHash)) {
+    return nullptr;
+  }
+  return std::move(cache);
+}
+
+MeshCacheUPtr MeshCache::New(FileViewUPtr fileView) {
+  auto cache = MeshCacheUPtr(new MeshCache());
+  cache->m_FileView = std::move(fileView);
+  if (!cache->m_FileView || !cache->read()) {
+    return nullptr;
+  }
+  return std::move(cache);
+}
+
+bool MeshCache::Write(const std::string& cachePath,
+                      const std::string& sourcePath,
+                      const std::vector<Vertex>& vertices,
+                      const std::vector<uint32_t>& indices,
+                      uint32_t primitiveType, uint64_t optionsHash,
+                      const std::vector<Meshlet>& meshlets) {
+  if (vertices.empty() || indices.empty()) {
+    return false;
+  }
+
+  Header header;
+  GetSourceStamp(sourcePath, header.sourceSize, header.sourceTime);
+  header.primitiveType = primitiveType;
+  glm::vec3 boundsMin = vertices.front().position;
+  glm::vec3 boundsMax = vertices.front().position;
+  for (const auto& vertex : vertices) {
+    boundsMin = glm::min(boundsMin, vertex.position);
+    boundsMax = glm::max(boundsMax, vertex.position);
+  }
+  std::memcpy(header.boundsMin, &boundsMin, sizeof(header.boundsMin));
+  std::memcpy(header.boundsMax, &boundsMax, sizeof(header.boundsMax));
+  header.vertexStride = sizeof(Vertex);
+  header.vertexCount = vertices.size();
+  header.indexCount = indices.size();
+  header.optionsHash = optionsHash;
+  header.meshletCount = meshlets.size();
+
+  // The serialized header has a fixed size, so the offsets can be computed
+  // from a first pass and written in the second.
+  size_t headerSize = SerializeHeader(header).size();
+  header.vertexOffset = AlignUp(PREFIX_SIZE + headerSize, BLOCK_ALIGNMENT);
+  header.indexOffset =
+      AlignUp(header.vertexOffset + vertices.size() * sizeof(Vertex),
+              BLOCK_ALIGNMENT);
+  header.meshletOffset =
+      AlignUp(header.indexOffset + indices.size() * sizeof(uint32_t),
+              BLOCK_ALIGNMENT);
+  std::string headerBytes = SerializeHeader(header);
+
+  // Written next to the cache and renamed over it, so that a cache which is
+  // mapped or being read is never seen half written
+  std::string tempPath = PathUtil::GetUniquePath(cachePath) + ".tmp";
+  std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    SPDLOG_WARN("Failed to create mesh cache: {}", cachePath);
+    return false;
+  }
+
+  const char padding[BLOCK_ALIGNMENT] = {};
+  uint32_t formatVersion = FORMAT_VERSION;
+  uint32_t headerBytesSize = static_cast<uint32_t>(headerBytes.size());
+  file.write(MAGIC, sizeof(MAGIC));
+  file.write(reinterpret_cast<const char*>(&formatVersion),
+             sizeof(formatVersion));
+  file.write(reinterpret_cast<const char*>(&headerBytesSize),
+             sizeof(headerBytesSize));
+  file.write(headerBytes.data(), headerBytes.size());
+  file.write(padding, header.vertexOffset - (PREFIX_SIZE + headerBytes.size()));
+  file.write(reinterpret_cast<const char*>(vertices.data()),
+             vertices.size() * sizeof(Vertex));
+  file.write(padding, header.indexOffset - (header.vertexOffset +
+                                            vertices.size() * sizeof(Vertex)));
+  file.write(reinterpret_cast<const char*>(indices.data()),
+             indices.size() * sizeof(uint32_t));
+  file.write(padding,
+             header.meshletOffset -
+                 (header.indexOffset + indices.size() * sizeof(uint32_t)));
+  file.write(reinterpret_cast<const char*>(meshlets.data()),
+             meshlets.size() * sizeof(Meshlet));
+
+  file.close();
+  if (!file) {
+    SPDLOG_WARN("Failed to write mesh cache: {}", cachePath);
+    std::remove(tempPath.c_str());
+    return false;
+  }
+  std::error_code error;
+  std::filesystem::rename(tempPath, cachePath, error);
+  if (error) {
+    SPDLOG_WARN("Failed to replace mesh cache: {} ({})", cachePath,
+                error.message());
+    std::remove(tempPath.c_str());
+    return false;
+  }
+  SPDLOG_INFO("Mesh cache written: {}", cachePath);
+  return true;
+}
+
+bool MeshCache::open(const std::string& cachePath,
+                     const std::string& sourcePath, uint64_t optionsHash) {
+  std::error_code error;
+  if (!std::filesystem::exists(cachePath, error)) {
+    return false;
+  }
+
+  m_FileView = FileView::New(cachePath);
+  if (!m_FileView || !read()) {
+    return false;
+  }
+
+  if (!sourcePath.empty()) {
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (!GetSourceStamp(sourcePath, sourceSize, sourceTime) ||
+        sourceSize != m_Header.sourceSize ||
+        sourceTime != m_Header.sourceTime) {
+      SPDLOG_INFO("Mesh cache is stale: {}", cachePath);
+      return false;
+    }
+    if (optionsHash != m_Header.optionsHash) {
+      SPDLOG_INFO("Mesh cache was built with other options: {}", cachePath);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool MeshCache::read() {
+  const std::string& cachePath = m_FileView->GetPath();
+  const uint8_t* data = m_FileView->GetData();
+  size_t size = m_FileView->GetSize();
+  uint32_t formatVersion = 0;
+  uint32_t headerSize = 0;
+  if (size < PREFIX_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+    SPDLOG_WARN("Not a mesh cache file: {}", cachePath);
+    return false;
+  }
+  std::memcpy(&formatVersion, data + sizeof(MAGIC), sizeof(formatVersion));
+  std::memcpy(&headerSize, data + sizeof(MAGIC) + sizeof(formatVersion),
+              sizeof(headerSize));
+  if (formatVersion != FORMAT_VERSION || PREFIX_SIZE + headerSize > size) {
+    SPDLOG_WARN("Outdated mesh cache: {}", cachePath);
+    return false;
+  }
+
+  MemoryStreamBuffer streamBuffer(data + PREFIX_SIZE, headerSize);
+  std::istream stream(&streamBuffer);
+  try {
+    cereal::BinaryInputArchive archive(stream);
+    archive(m_Header);
+  } catch (const cereal::Exception& e) {
+    SPDLOG_WARN("Failed to read mesh cache header: {} ({})", cachePath,
+                e.what());
+    return false;
+  }
+
+  bool validLayout =
+      m_Header.vertexStride == sizeof(Vertex) &&
+      m_Header.vertexOffset % BLOCK_ALIGNMENT == 0 &&
+      m_Header.indexOffset % BLOCK_ALIGNMENT == 0 &&
+      m_Header.meshletOffset % BLOCK_ALIGNMENT == 0 &&
+      m_FileView->Contains(m_Header.vertexOffset, m_Header.vertexCount,
+                           sizeof(Vertex)) &&
+      m_FileView->Contains(m_Header.indexOffset, m_Header.indexCount,
+                           sizeof(uint32_t)) &&
+      m_FileView->Contains(m_Header.meshletOffset, m_Header.meshletCount,
+                           sizeof(Meshlet));
+  if (!validLayout) {
+    SPDLOG_WARN("Corrupted mesh cache: {}", cachePath);
+    return false;
+  }
+
+  // Indices are trusted by the upload, the LOD and BVH builders and the
+  // GPU, and caches may be opened directly
+  const uint32_t* indices = GetIndices();
+  for (uint64_t i = 0; i < m_Header.indexCount; ++i) {
+    if (indices[i] >= m_Header.vertexCount) {
+      SPDLOG_WARN("Corrupted mesh cache, index out of range: {}", cachePath);
+      return false;
+    }
+  }
+  return true;
+}
+
+const Vertex* MeshCache::GetVertices() const {
+  return reinterpret_cast<const Vertex*>(m_FileView->GetData() +
+                                         m_Header.vertexOffset);
+}
+
+const uint32_t* MeshCache::GetIndices() const {
+  return reinterpret_cast<const uint32_t*>(m_FileView->GetData() +
+                                           m_Header.indexOffset);
+}
+
+const Meshlet* MeshCache::GetMeshlets() const {
+  return reinterpret_cast<const Meshlet*>(m_FileView->GetData() +
+                                          m_Header.meshletOffset);
+}
+
+glm::vec3 MeshCache::GetBoundsMin() const {
+  return glm::vec3(m_Header.boundsMin[0], m_Header.boundsMin[1],
+                   m_Header.boundsMin[2]);
+}
+
+glm::vec3 MeshCache::GetBoundsMax() const {
+  return glm::vec3(m_Header.boundsMax[0], m_Header.boundsMax[1],
+                   m_Header.boundsMax[2]);
+}
+
+MeshUPtr MeshCache::CreateMesh(const VertexFormat& format) const {
+  MeshUPtr mesh = Mesh::New(GetVertices(), GetVertexCount(), GetIndices(),
+                            GetIndexCount(), GetPrimitiveType(),
+                            GetBoundsMin(), GetBoundsMax(), format);
+  if (mesh && GetMeshletCount() > 0) {
+    mesh->SetMeshlets(GetMeshlets(), GetMeshletCount());
+  }
+  return std::move(mesh);
+}
\ No newline at end of file
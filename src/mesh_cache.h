@@ -0,0 +1,105 @@
+#pragma once
+
+#include "macro/ptr_macro.h"
+#include "mesh.h"
+#include "util/file_view.h"
+
+// Standard library
+#include <string>
+
+// Binary mesh cache (.cmesh)
+// File layout:
+// - Magic "CMESH" + format version (uint32) + header size (uint32)
+// - Header serialized with cereal (versioned): source file stamp, import
+//   options hash, counts, bounds and block offsets
+// - Vertex block: raw Vertex array (tangents included)
+// - Index block: raw uint32_t array
+// - Meshlet block: raw Meshlet array, may be empty
+// Blocks start at BLOCK_ALIGNMENT, so a mapped cache can be handed to
+// glBufferData without any per-vertex work.
+DECLARE_PTR(MeshCache)
+class MeshCache {
+ public:
+  static constexpr uint32_t FORMAT_VERSION = 3;
+  static constexpr size_t BLOCK_ALIGNMENT = 64;
+
+  // Size and modification time of the source file. A cache is valid only
+  // for the source it was written from.
+  static bool GetSourceStamp(const std::string& sourcePath, uint64_t& size,
+                             int64_t& time);
+
+  // Cache file path for a source mesh file
+  static std::string GetCachePath(const std::string& sourcePath);
+
+  // Open a cache file. If sourcePath is not empty, the cache is rejected
+  // when it was not written for the current version of the source file with
+  // the same import options.
+  static MeshCacheUPtr New(const std::string& cachePath,
+                           const std::string& sourcePath = "",
+                           uint64_t optionsHash = 0);
+  // Read a cache which is already in memory
+  static MeshCacheUPtr New(FileViewUPtr fileView);
+
+  // Write to a temporary file renamed over cachePath
+  static bool Write(const std::string& cachePath,
+                    const std::string& sourcePath,
+                    const std::vector<Vertex>& vertices,
+                    const std::vector<uint32_t>& indices,
+                    uint32_t primitiveType, uint64_t optionsHash = 0,
+                    const std::vector<Meshlet>& meshlets = {});
+
+  ~MeshCache() = default;
+
+  const Vertex* GetVertices() const;
+  size_t GetVertexCount() const { return m_Header.vertexCount; }
+  const uint32_t* GetIndices() const;
+  size_t GetIndexCount() const { return m_Header.indexCount; }
+  const Meshlet* GetMeshlets() const;
+  size_t GetMeshletCount() const { return m_Header.meshletCount; }
+  uint32_t GetPrimitiveType() const { return m_Header.primitiveType; }
+  glm::vec3 GetBoundsMin() const;
+  glm::vec3 GetBoundsMax() const;
+
+  // Upload the mapped blocks into a new mesh, with its meshlets
+  MeshUPtr CreateMesh(const VertexFormat& format = VertexFormat()) const;
+
+  struct Header {
+    uint64_t sourceSize{0};
+    int64_t sourceTime{0};
+    uint32_t primitiveType{0};
+    float boundsMin[3]{};
+    float boundsMax[3]{};
+    uint64_t vertexStride{0};
+    uint64_t vertexCount{0};
+    uint64_t vertexOffset{0};
+    uint64_t indexCount{0};
+    uint64_t indexOffset{0};
+    uint64_t optionsHash{0};
+    uint64_t meshletCount{0};
+    uint64_t meshletOffset{0};
+
+    template <class Archive>
+    void serialize(Archive& archive, const uint32_t version) {
+      archive(sourceSize, sourceTime, primitiveType, boundsMin, boundsMax,
+              vertexStride, vertexCount, vertexOffset, indexCount,
+              indexOffset);
+      if (version >= 2) {
+        archive(optionsHash);
+      }
+      if (version >= 3) {
+        archive(meshletCount, meshletOffset);
+      }
+    }
+  };
+
+ private:
+  MeshCache() = default;
+
+  bool open(const std::string& cachePath, const std::string& sourcePath,
+            uint64_t optionsHash);
+  // Validate m_FileView and read its header
+  bool read();
+
+  FileViewUPtr m_FileView;
+  Header m_Header;
+};
\ No newline at end of file
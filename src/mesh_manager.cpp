@@ -0,0 +1,109 @@
+#include "mesh_manager.h"
+
+MeshManager::MeshManager() { m_MeshTree = LcrsTree::New(ROOT_ID, "Scene"); }
+
+MeshManager::~MeshManager() {}
+
+int32_t MeshManager::AddMesh(const char* label, MeshPtr mesh,
+                             TreeNode* parent) {
+  if (!mesh) {
+    SPDLOG_ERROR("Cannot add an empty mesh: {}", label);
+    return -1;
+  }
+
+  int32_t id = insertNode(label, parent);
+  if (id < 0) {
+    return -1;
+  }
+
+  m_Meshes[id] = mesh;
+  SPDLOG_INFO("Mesh added - [Id]: {}, [Label]: {}", id, label);
+  return id;
+}
+
+int32_t MeshManager::AddGroup(const char* label, TreeNode* parent) {
+  return insertNode(label, parent);
+}
+
+int32_t MeshManager::insertNode(const char* label, TreeNode* parent) {
+  int32_t id = m_NextId;
+  TreeNode* node = m_MeshTree->InsertItem(id, label, parent);
+  if (!node) {
+    SPDLOG_ERROR("Failed to insert node into the mesh tree: {}", label);
+    return -1;
+  }
+  ++m_NextId;
+  m_TreeNodes[id] = node;
+  return id;
+}
+
+bool MeshManager::DeleteMesh(int32_t id) {
+  // Collect the node and its children before they are deleted from the tree,
+  // then release what belongs to them.
+  TreeNode* node = GetTreeNode(id);
+  if (!node) {
+    return false;
+  }
+  std::vector<int32_t> ids;
+  m_MeshTree->TraverseTree(
+      [&ids](const TreeNode* node, void*) { ids.push_back(node->GetId()); },
+      node);
+  if (!m_MeshTree->DeleteItem(id)) {
+    return false;
+  }
+  for (int32_t deletedId : ids) {
+    m_Meshes.erase(deletedId);
+    m_LocalTransforms.erase(deletedId);
+    m_TreeNodes.erase(deletedId);
+  }
+  return true;
+}
+
+MeshPtr MeshManager::GetMesh(int32_t id) const {
+  auto it = m_Meshes.find(id);
+  return it != m_Meshes.end() ? it->second : nullptr;
+}
+
+TreeNode* MeshManager::GetTreeNode(int32_t id) const {
+  if (id == ROOT_ID) {
+    return m_MeshTree->GetRootMutable();
+  }
+  auto it = m_TreeNodes.find(id);
+  return it != m_TreeNodes.end() ? it->second : nullptr;
+}
+
+void MeshManager::SetLocalTransform(int32_t id, const glm::mat4& transform) {
+  if (transform == glm::mat4(1.0f)) {
+    m_LocalTransforms.erase(id);
+  } else {
+    m_LocalTransforms[id] = transform;
+  }
+}
+
+void MeshManager::ForEachMesh(
+    const std::function<void(int32_t id, const Mesh& mesh,
+                             const glm::mat4& worldTransform)>& func) const {
+  forEachMeshRecursive(m_MeshTree->GetRoot(), glm::mat4(1.0f), func);
+}
+
+void MeshManager::forEachMeshRecursive(
+    const TreeNode* node, const glm::mat4& parentTransform,
+    const std::function<void(int32_t, const Mesh&, const glm::mat4&)>& func)
+    const {
+  for (; node; node = node->GetRightSibling()) {
+    if (node->GetIconState() == IconState::HIDDEN) continue;
+
+    int32_t id = node->GetId();
+    glm::mat4 transform = parentTransform;
+    auto transformIt = m_LocalTransforms.find(id);
+    if (transformIt != m_LocalTransforms.end()) {
+      transform = parentTransform * transformIt->second;
+    }
+
+    auto meshIt = m_Meshes.find(id);
+    if (meshIt != m_Meshes.end()) {
+      func(id, *meshIt->second, transform);
+    }
+    forEachMeshRecursive(node->GetLeftChild(), transform, func);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "lcrs_tree.h"
+#include "macro/singleton_macro.h"
+#include "mesh.h"
+
+// Standard library
+#include <functional>
+#include <map>
+#include <unordered_map>
+
+// Mesh manager class
+// - Own all imported meshes
+// - Keep the scene hierarchy in a LcrsTree. Tree node ids are mesh ids.
+//   Group nodes have no mesh.
+// - Each node has a local transform relative to its parent.
+class MeshManager {
+  DECLARE_SINGLETON(MeshManager)
+
+ public:
+  LcrsTree* GetMeshTree() { return m_MeshTree.get(); }
+  const LcrsTree* GetMeshTree() const { return m_MeshTree.get(); }
+
+  // Insert the mesh under the parent node. If the parent is nullptr, the root
+  // will be used. Return the new mesh id, or -1 on failure.
+  int32_t AddMesh(const char* label, MeshPtr mesh, TreeNode* parent = nullptr);
+  // Insert a node without a mesh, e.g. a node of an imported scene
+  int32_t AddGroup(const char* label, TreeNode* parent = nullptr);
+  bool DeleteMesh(int32_t id);
+
+  MeshPtr GetMesh(int32_t id) const;
+  // Constant time, unlike LcrsTree::GetTreeNodeById()
+  TreeNode* GetTreeNode(int32_t id) const;
+  const std::map<int32_t, MeshPtr>& GetMeshes() const { return m_Meshes; }
+
+  void SetLocalTransform(int32_t id, const glm::mat4& transform);
+
+  // Call func for every visible mesh with its world transform, the product
+  // of the local transforms from the root. The tree is walked once.
+  void ForEachMesh(
+      const std::function<void(int32_t id, const Mesh& mesh,
+                               const glm::mat4& worldTransform)>& func) const;
+
+ private:
+  const int32_t ROOT_ID = 0;
+
+  LcrsTreeUPtr m_MeshTree;
+  std::map<int32_t, MeshPtr> m_Meshes;
+  std::map<int32_t, glm::mat4> m_LocalTransforms;  // Identity if not set
+  std::unordered_map<int32_t, TreeNode*> m_TreeNodes;
+  int32_t m_NextId{1};
+
+  int32_t insertNode(const char* label, TreeNode* parent);
+  void forEachMeshRecursive(
+      const TreeNode* node, const glm::mat4& parentTransform,
+      const std::function<void(int32_t, const Mesh&, const glm::mat4&)>& func)
+      const;
+};
\ No newline at end of file
@@ -0,0 +1,322 @@
+#include "mesh_optimizer.h"
+
+#include "thread_pool.h"
+
+// Standard library
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+namespace MeshOptimizer {
+
+namespace {
+
+constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+constexpr size_t VALENCE_TABLE_SIZE = 64;
+
+// Forsyth's vertex score: recently used vertices score higher, except the
+// last triangle's corners, which are weighted down to avoid strips of
+// slivers. Vertices with few remaining triangles score higher, so that
+// vertices are finished off instead of left behind.
+struct ScoreTable {
+  float cache[CACHE_SIZE];
+  float valence[VALENCE_TABLE_SIZE];
+
+  ScoreTable() {
+    for (size_t i = 0; i < CACHE_SIZE; ++i) {
+      cache[i] = i < 3 ? 0.75f
+                       : std::pow(1.0f - float(i - 3) / (CACHE_SIZE - 3),
+                                  1.5f);
+    }
+    valence[0] = 0.0f;
+    for (size_t i = 1; i < VALENCE_TABLE_SIZE; ++i) {
+      valence[i] = 2.0f / std::sqrt(float(i));
+    }
+  }
+
+  float Get(int32_t cachePosition, uint32_t liveCount) const {
+    if (liveCount == 0) return -1.0f;  // Done
+    float score = cachePosition >= 0 ? cache[cachePosition] : 0.0f;
+    return score + (liveCount < VALENCE_TABLE_SIZE
+                        ? valence[liveCount]
+                        : 2.0f / std::sqrt(float(liveCount)));
+  }
+};
+
+const ScoreTable s_ScoreTable;
+
+size_t CountCacheMisses(const uint32_t* indices, size_t indexCount,
+                        size_t vertexCount, size_t cacheSize) {
+  std::vector<uint32_t> timestamps(vertexCount, 0);
+  uint32_t time = static_cast<uint32_t>(cacheSize) + 1;
+  size_t misses = 0;
+  for (size_t i = 0; i < indexCount; ++i) {
+    uint32_t& timestamp = timestamps[indices[i]];
+    if (time - timestamp > cacheSize) {
+      timestamp = time++;
+      ++misses;
+    }
+  }
+  return misses;
+}
+
+// Reorder the triangles of a local index buffer into out
+void OptimizeVertexCache(const std::vector<uint32_t>& indices,
+                         size_t vertexCount, uint32_t* out) {
+  const size_t triangleCount = indices.size() / 3;
+
+  // Triangles around each vertex. The live ones come first.
+  std::vector<uint32_t> liveCounts(vertexCount, 0);
+  for (uint32_t index : indices) {
+    ++liveCounts[index];
+  }
+  std::vector<uint32_t> offsets(vertexCount + 1, 0);
+  std::partial_sum(liveCounts.begin(), liveCounts.end(), offsets.begin() + 1);
+  std::vector<uint32_t> adjacency(indices.size());
+  {
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i) {
+      adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+  }
+
+  std::vector<int32_t> cachePositions(vertexCount, -1);
+  std::vector<float> vertexScores(vertexCount);
+  for (size_t i = 0; i < vertexCount; ++i) {
+    vertexScores[i] = s_ScoreTable.Get(-1, liveCounts[i]);
+  }
+  std::vector<bool> emitted(triangleCount, false);
+
+  std::array<uint32_t, CACHE_SIZE + 3> cache;
+  std::array<uint32_t, CACHE_SIZE + 3> newCache;
+  size_t cacheCount = 0;
+  size_t nextInput = 0;  // Restart point when the cache has no candidate
+  int64_t best = -1;
+  for (size_t written = 0; written < triangleCount; ++written) {
+    if (best < 0) {
+      while (emitted[nextInput]) ++nextInput;
+      best = static_cast<int64_t>(nextInput);
+    }
+    const uint32_t* triangle = &indices[best * 3];
+    std::copy(triangle, triangle + 3, out + written * 3);
+    emitted[best] = true;
+
+    // The corners move to the front of the cache.
+    size_t newCount = 0;
+    for (int i = 0; i < 3; ++i) {
+      uint32_t vertex = triangle[i];
+      uint32_t* begin = &adjacency[offsets[vertex]];
+      uint32_t* end = begin + liveCounts[vertex];
+      std::iter_swap(std::find(begin, end, uint32_t(best)), end - 1);
+      --liveCounts[vertex];
+      if (std::find(triangle, triangle + i, vertex) == triangle + i) {
+        newCache[newCount++] = vertex;
+      }
+    }
+    for (size_t i = 0; i < cacheCount; ++i) {
+      uint32_t vertex = cache[i];
+      if (vertex != triangle[0] && vertex != triangle[1] &&
+          vertex != triangle[2]) {
+        newCache[newCount++] = vertex;
+      }
+    }
+
+    // Rescore the vertices that entered, moved in or left the cache
+    for (size_t i = 0; i < newCount; ++i) {
+      uint32_t vertex = newCache[i];
+      cachePositions[vertex] = i < CACHE_SIZE ? int32_t(i) : -1;
+      vertexScores[vertex] =
+          s_ScoreTable.Get(cachePositions[vertex], liveCounts[vertex]);
+    }
+    cacheCount = std::min(newCount, CACHE_SIZE);
+    std::copy(newCache.begin(), newCache.begin() + cacheCount, cache.begin());
+
+    // The next triangle is the best one around the cache.
+    best = -1;
+    float bestScore = -1.0f;
+    for (size_t i = 0; i < newCount; ++i) {
+      uint32_t vertex = newCache[i];
+      for (uint32_t j = 0; j < liveCounts[vertex]; ++j) {
+        uint32_t candidate = adjacency[offsets[vertex] + j];
+        const uint32_t* corners = &indices[candidate * 3];
+        float score = vertexScores[corners[0]] + vertexScores[corners[1]] +
+                      vertexScores[corners[2]];
+        if (score > bestScore) {
+          bestScore = score;
+          best = candidate;
+        }
+      }
+    }
+  }
+}
+
+// Reorder clusters of the cache-ordered triangles in indices. The new order
+// is kept if its ACMR is within OVERDRAW_THRESHOLD of the cache order.
+void OptimizeOverdraw(std::vector<uint32_t>& indices,
+                      const std::vector<glm::vec3>& positions,
+                      const glm::vec3& meshCenter) {
+  const size_t triangleCount = indices.size() / 3;
+
+  // A cluster starts wherever all three corners miss the cache.
+  std::vector<uint32_t> clusterStarts;
+  {
+    std::vector<uint32_t> timestamps(positions.size(), 0);
+    uint32_t time = FIFO_CACHE_SIZE + 1;
+    for (size_t i = 0; i < triangleCount; ++i) {
+      int misses = 0;
+      for (int j = 0; j < 3; ++j) {
+        uint32_t& timestamp = timestamps[indices[i * 3 + j]];
+        if (time - timestamp > FIFO_CACHE_SIZE) {
+          timestamp = time++;
+          ++misses;
+        }
+      }
+      if (misses == 3 || i == 0) {
+        clusterStarts.push_back(static_cast<uint32_t>(i));
+      }
+    }
+  }
+  const size_t clusterCount = clusterStarts.size();
+  if (clusterCount < 2) return;
+  clusterStarts.push_back(static_cast<uint32_t>(triangleCount));
+
+  // Clusters facing away from the center are in front of the rest of the
+  // mesh from most view directions, so they are drawn first.
+  std::vector<float> sortKeys(clusterCount);
+  for (size_t i = 0; i < clusterCount; ++i) {
+    glm::vec3 centroid(0.0f);
+    glm::vec3 normal(0.0f);
+    float area = 0.0f;
+    for (uint32_t j = clusterStarts[i]; j < clusterStarts[i + 1]; ++j) {
+      const glm::vec3& p0 = positions[indices[j * 3]];
+      const glm::vec3& p1 = positions[indices[j * 3 + 1]];
+      const glm::vec3& p2 = positions[indices[j * 3 + 2]];
+      glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+      float triangleArea = glm::length(cross);
+      centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+      normal += cross;
+      area += triangleArea;
+    }
+    float normalLength = glm::length(normal);
+    if (area > 0.0f && normalLength > 0.0f) {
+      sortKeys[i] =
+          glm::dot(centroid / area - meshCenter, normal / normalLength);
+    } else {
+      sortKeys[i] = -FLT_MAX;
+    }
+  }
+
+  std::vector<uint32_t> clusters(clusterCount);
+  std::iota(clusters.begin(), clusters.end(), 0u);
+  std::stable_sort(clusters.begin(), clusters.end(),
+                   [&sortKeys](uint32_t a, uint32_t b) {
+                     return sortKeys[a] > sortKeys[b];
+                   });
+
+  std::vector<uint32_t> sorted;
+  sorted.reserve(indices.size());
+  for (uint32_t cluster : clusters) {
+    sorted.insert(sorted.end(), indices.begin() + clusterStarts[cluster] * 3,
+                  indices.begin() + clusterStarts[cluster + 1] * 3);
+  }
+
+  size_t misses = CountCacheMisses(indices.data(), indices.size(),
+                                   positions.size(), FIFO_CACHE_SIZE);
+  size_t sortedMisses = CountCacheMisses(sorted.data(), sorted.size(),
+                                         positions.size(), FIFO_CACHE_SIZE);
+  if (sortedMisses <= misses * OVERDRAW_THRESHOLD) {
+    indices.swap(sorted);
+  }
+}
+
+// Optimize triangles [begin, end) of indices in place
+void OptimizeBlock(const std::vector<Vertex>& vertices, uint32_t* begin,
+                   uint32_t* end, const glm::vec3& meshCenter) {
+  // Renumber the vertices used by the block densely
+  std::vector<uint32_t> globalIndices(begin, end);
+  std::sort(globalIndices.begin(), globalIndices.end());
+  globalIndices.erase(std::unique(globalIndices.begin(), globalIndices.end()),
+                      globalIndices.end());
+
+  std::vector<uint32_t> localIndices(end - begin);
+  for (size_t i = 0; i < localIndices.size(); ++i) {
+    localIndices[i] = static_cast<uint32_t>(
+        std::lower_bound(globalIndices.begin(), globalIndices.end(),
+                         begin[i]) -
+        globalIndices.begin());
+  }
+
+  std::vector<uint32_t> ordered(localIndices.size());
+  OptimizeVertexCache(localIndices, globalIndices.size(), ordered.data());
+
+  std::vector<glm::vec3> positions(globalIndices.size());
+  for (size_t i = 0; i < globalIndices.size(); ++i) {
+    positions[i] = vertices[globalIndices[i]].position;
+  }
+  OptimizeOverdraw(ordered, positions, meshCenter);
+
+  for (size_t i = 0; i < ordered.size(); ++i) {
+    begin[i] = globalIndices[ordered[i]];
+  }
+}
+
+}  // namespace
+
+Statistics Analyze(const std::vector<uint32_t>& indices, size_t vertexCount,
+                   size_t cacheSize) {
+  Statistics statistics;
+  if (indices.empty() || vertexCount == 0) return statistics;
+
+  size_t misses =
+      CountCacheMisses(indices.data(), indices.size(), vertexCount, cacheSize);
+  statistics.acmr = float(misses) / (indices.size() / 3);
+  statistics.atvr = float(misses) / vertexCount;
+  return statistics;
+}
+
+void Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+  const size_t triangleCount = indices.size() / 3;
+  if (triangleCount == 0 || vertices.empty()) return;
+
+  glm::vec3 boundsMin = vertices.front().position;
+  glm::vec3 boundsMax = boundsMin;
+  for (const auto& vertex : vertices) {
+    boundsMin = glm::min(boundsMin, vertex.position);
+    boundsMax = glm::max(boundsMax, vertex.position);
+  }
+  const glm::vec3 meshCenter = (boundsMin + boundsMax) * 0.5f;
+
+  // Blocks keep the order they arrived in, which is usually coherent.
+  const size_t blockCount =
+      (triangleCount + BLOCK_TRIANGLES - 1) / BLOCK_TRIANGLES;
+  ThreadPool::Instance().ParallelFor(
+      blockCount, 1, [&](size_t blockBegin, size_t blockEnd) {
+        for (size_t i = blockBegin; i < blockEnd; ++i) {
+          size_t begin = i * BLOCK_TRIANGLES * 3;
+          size_t end = std::min((i + 1) * BLOCK_TRIANGLES, triangleCount) * 3;
+          OptimizeBlock(vertices, indices.data() + begin,
+                        indices.data() + end, meshCenter);
+        }
+      });
+
+  // Vertex fetch: Number vertices in order of first use
+  std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+  uint32_t usedCount = 0;
+  for (uint32_t& index : indices) {
+    if (remap[index] == INVALID_INDEX) {
+      remap[index] = usedCount++;
+    }
+    index = remap[index];
+  }
+  std::vector<Vertex> remapped(usedCount);
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    if (remap[i] != INVALID_INDEX) {
+      remapped[remap[i]] = vertices[i];
+    }
+  }
+  vertices.swap(remapped);
+}
+
+}  // namespace MeshOptimizer
\ No newline at end of file
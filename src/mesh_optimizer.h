@@ -0,0 +1,39 @@
+#pragma once
+
+#include "mesh.h"
+
+// Standard library
+#include <vector>
+
+// Reorders indexed triangle lists for the GPU, in three passes:
+// - Vertex cache: Triangles are reordered with Forsyth's linear-speed
+//   algorithm against a simulated LRU cache.
+// - Overdraw: The cache-ordered triangles are split into clusters where the
+//   cache restarts anyway (all three corners miss), and clusters facing out
+//   from the mesh center are drawn first. The order is kept only if the
+//   vertex cache efficiency stays within OVERDRAW_THRESHOLD.
+// - Vertex fetch: Vertices are renumbered in order of first use, so that
+//   vertex fetches walk the buffer forward. Unused vertices are dropped.
+// Large meshes are processed in blocks of BLOCK_TRIANGLES on the thread
+// pool. The result does not depend on the thread count.
+namespace MeshOptimizer {
+
+constexpr size_t CACHE_SIZE = 32;          // Simulated by the optimizer
+constexpr size_t FIFO_CACHE_SIZE = 16;     // Simulated by Analyze()
+constexpr size_t BLOCK_TRIANGLES = 64 * 1024;
+constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+struct Statistics {
+  float acmr{0.0f};  // Vertex shader invocations per triangle (0.5 ~ 3)
+  float atvr{0.0f};  // Vertex shader invocations per vertex (1 ~ )
+};
+
+// Simulate a FIFO post-transform cache of cacheSize vertices
+Statistics Analyze(const std::vector<uint32_t>& indices, size_t vertexCount,
+                   size_t cacheSize = FIFO_CACHE_SIZE);
+
+// Reorder triangles and vertices in place. Drawing the result gives the
+// same image up to the order of overlapping triangles.
+void Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+}  // namespace MeshOptimizer
\ No newline at end of file
@@ -0,0 +1,380 @@
+#include "mesh_simplifier.h"
+
+// Standard library
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+namespace MeshSimplifier {
+
+namespace {
+
+constexpr uint32_t NO_EDGE = UINT32_MAX;            // openIn / openOut
+constexpr uint32_t MULTIPLE_EDGES = UINT32_MAX - 1;  // openIn / openOut
+
+enum class VertexKind : uint8_t { MANIFOLD, BORDER, SEAM, LOCKED };
+
+// Sum of squared distances to weighted planes:
+// Q(p) = p^T A p + 2 b^T p + c, A symmetric
+struct Quadric {
+  double a00{0}, a10{0}, a11{0}, a20{0}, a21{0}, a22{0};
+  double b0{0}, b1{0}, b2{0};
+  double c{0};
+  double weight{0};
+
+  void AddPlane(const glm::vec3& normal, float distance, double planeWeight) {
+    double x = normal.x, y = normal.y, z = normal.z, d = distance;
+    a00 += planeWeight * x * x;
+    a10 += planeWeight * y * x;
+    a11 += planeWeight * y * y;
+    a20 += planeWeight * z * x;
+    a21 += planeWeight * z * y;
+    a22 += planeWeight * z * z;
+    b0 += planeWeight * x * d;
+    b1 += planeWeight * y * d;
+    b2 += planeWeight * z * d;
+    c += planeWeight * d * d;
+    weight += planeWeight;
+  }
+
+  void Add(const Quadric& other) {
+    a00 += other.a00;
+    a10 += other.a10;
+    a11 += other.a11;
+    a20 += other.a20;
+    a21 += other.a21;
+    a22 += other.a22;
+    b0 += other.b0;
+    b1 += other.b1;
+    b2 += other.b2;
+    c += other.c;
+    weight += other.weight;
+  }
+
+  // Squared distance, averaged over the plane weights
+  double Evaluate(const glm::vec3& p) const {
+    double x = p.x, y = p.y, z = p.z;
+    double value = a00 * x * x + a11 * y * y + a22 * z * z +
+                   2.0 * (a10 * x * y + a20 * x * z + a21 * y * z) +
+                   2.0 * (b0 * x + b1 * y + b2 * z) + c;
+    return weight > 0.0 ? std::abs(value) / weight : 0.0;
+  }
+};
+
+struct Collapse {
+  uint32_t from;
+  uint32_t to;
+  float error;  // Squared
+};
+
+// Outgoing half-edges of each vertex, rebuilt for every pass
+struct EdgeTable {
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> targets;
+  std::vector<uint32_t> triangles;
+
+  void Build(const std::vector<uint32_t>& indices, size_t vertexCount) {
+    offsets.assign(vertexCount + 1, 0);
+    for (uint32_t index : indices) {
+      ++offsets[index + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    targets.resize(indices.size());
+    triangles.resize(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i) {
+      size_t next = i % 3 == 2 ? i - 2 : i + 1;
+      uint32_t slot = fill[indices[i]]++;
+      targets[slot] = indices[next];
+      triangles[slot] = static_cast<uint32_t>(i / 3);
+    }
+  }
+
+  bool Has(uint32_t from, uint32_t to) const {
+    for (uint32_t i = offsets[from]; i < offsets[from + 1]; ++i) {
+      if (targets[i] == to) return true;
+    }
+    return false;
+  }
+};
+
+// Vertices with the same position: remap points to the first one and wedge
+// links them in a ring.
+void BuildWedges(const std::vector<glm::vec3>& positions,
+                 std::vector<uint32_t>& remap, std::vector<uint32_t>& wedge) {
+  const size_t vertexCount = positions.size();
+  std::vector<uint32_t> order(vertexCount);
+  std::iota(order.begin(), order.end(), 0u);
+  auto less = [&positions](uint32_t a, uint32_t b) {
+    const glm::vec3& p = positions[a];
+    const glm::vec3& q = positions[b];
+    if (p.x != q.x) return p.x < q.x;
+    if (p.y != q.y) return p.y < q.y;
+    if (p.z != q.z) return p.z < q.z;
+    return a < b;
+  };
+  std::sort(order.begin(), order.end(), less);
+
+  remap.resize(vertexCount);
+  wedge.resize(vertexCount);
+  for (size_t begin = 0; begin < vertexCount;) {
+    size_t end = begin + 1;
+    while (end < vertexCount &&
+           positions[order[end]] == positions[order[begin]]) {
+      ++end;
+    }
+    for (size_t i = begin; i < end; ++i) {
+      remap[order[i]] = order[begin];
+      wedge[order[i]] = order[i + 1 < end ? i + 1 : begin];
+    }
+    begin = end;
+  }
+}
+
+// Record the open half-edges of each vertex: edges without a twin in the
+// opposite direction.
+void FindOpenEdges(const std::vector<uint32_t>& indices,
+                   const EdgeTable& edges, std::vector<uint32_t>& openIn,
+                   std::vector<uint32_t>& openOut) {
+  for (size_t i = 0; i < indices.size(); ++i) {
+    uint32_t from = indices[i];
+    uint32_t to = indices[i % 3 == 2 ? i - 2 : i + 1];
+    if (edges.Has(to, from)) continue;
+    openOut[from] = openOut[from] == NO_EDGE ? to : MULTIPLE_EDGES;
+    openIn[to] = openIn[to] == NO_EDGE ? from : MULTIPLE_EDGES;
+  }
+}
+
+bool IsSingle(uint32_t edge) { return edge < MULTIPLE_EDGES; }
+
+std::vector<VertexKind> ClassifyVertices(const std::vector<uint32_t>& remap,
+                                         const std::vector<uint32_t>& wedge,
+                                         const std::vector<uint32_t>& openIn,
+                                         const std::vector<uint32_t>& openOut) {
+  std::vector<VertexKind> kinds(remap.size(), VertexKind::LOCKED);
+  for (size_t i = 0; i < remap.size(); ++i) {
+    if (wedge[i] == i) {
+      if (openIn[i] == NO_EDGE && openOut[i] == NO_EDGE) {
+        kinds[i] = VertexKind::MANIFOLD;
+      } else if (IsSingle(openIn[i]) && IsSingle(openOut[i])) {
+        kinds[i] = VertexKind::BORDER;
+      }
+    } else if (wedge[wedge[i]] == i) {
+      // Two wedges whose open edges are the two sides of one seam
+      uint32_t w = wedge[i];
+      if (IsSingle(openIn[i]) && IsSingle(openOut[i]) && IsSingle(openIn[w]) &&
+          IsSingle(openOut[w]) && remap[openIn[i]] == remap[openOut[w]] &&
+          remap[openOut[i]] == remap[openIn[w]]) {
+        kinds[i] = VertexKind::SEAM;
+      }
+    }
+  }
+  return kinds;
+}
+
+glm::vec3 GetNormal(const glm::vec3& p0, const glm::vec3& p1,
+                    const glm::vec3& p2) {
+  return glm::cross(p1 - p0, p2 - p0);
+}
+
+// Whether moving from onto the position of to turns a triangle around from
+// over
+bool HasFlips(const std::vector<glm::vec3>& positions,
+              const std::vector<uint32_t>& indices, const EdgeTable& edges,
+              uint32_t from, uint32_t to) {
+  const glm::vec3& target = positions[to];
+  for (uint32_t i = edges.offsets[from]; i < edges.offsets[from + 1]; ++i) {
+    const uint32_t* triangle = &indices[edges.triangles[i] * 3];
+    if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+      continue;  // Removed by the collapse
+    }
+    glm::vec3 corners[3];
+    glm::vec3 moved[3];
+    for (int j = 0; j < 3; ++j) {
+      corners[j] = positions[triangle[j]];
+      moved[j] = triangle[j] == from ? target : corners[j];
+    }
+    glm::vec3 before = GetNormal(corners[0], corners[1], corners[2]);
+    glm::vec3 after = GetNormal(moved[0], moved[1], moved[2]);
+    if (glm::dot(before, after) <= 0.0f) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+std::vector<uint32_t> Simplify(const std::vector<glm::vec3>& positions,
+                               const std::vector<uint32_t>& indices,
+                               size_t targetIndexCount, float maxError,
+                               float& error) {
+  const size_t vertexCount = positions.size();
+  std::vector<uint32_t> result(indices.begin(),
+                               indices.begin() + indices.size() / 3 * 3);
+  error = 0.0f;
+  if (result.size() <= targetIndexCount) return result;
+
+  std::vector<uint32_t> remap;
+  std::vector<uint32_t> wedge;
+  BuildWedges(positions, remap, wedge);
+
+  EdgeTable edges;
+  edges.Build(result, vertexCount);
+  std::vector<uint32_t> openIn(vertexCount, NO_EDGE);
+  std::vector<uint32_t> openOut(vertexCount, NO_EDGE);
+  FindOpenEdges(result, edges, openIn, openOut);
+  std::vector<VertexKind> kinds =
+      ClassifyVertices(remap, wedge, openIn, openOut);
+
+  // Quadrics per position: the planes of the triangles around it, weighted
+  // by area, and planes through border edges perpendicular to the surface
+  std::vector<Quadric> quadrics(vertexCount);
+  for (size_t i = 0; i < result.size(); i += 3) {
+    const glm::vec3& p0 = positions[result[i]];
+    glm::vec3 normal = GetNormal(p0, positions[result[i + 1]],
+                                 positions[result[i + 2]]);
+    float length = glm::length(normal);
+    if (length == 0.0f) continue;
+    normal = normal / length;
+    float distance = -glm::dot(normal, p0);
+    for (int j = 0; j < 3; ++j) {
+      uint32_t from = result[i + j];
+      uint32_t to = result[i + (j + 1) % 3];
+      quadrics[remap[from]].AddPlane(normal, distance, length * 0.5f);
+
+      if (edges.Has(to, from) || kinds[from] == VertexKind::SEAM) continue;
+      glm::vec3 edge = positions[to] - positions[from];
+      glm::vec3 edgeNormal = glm::cross(edge, normal);
+      float edgeLength = glm::length(edgeNormal);
+      if (edgeLength == 0.0f) continue;
+      edgeNormal = edgeNormal / edgeLength;
+      float edgeDistance = -glm::dot(edgeNormal, positions[from]);
+      double weight = BORDER_WEIGHT * glm::dot(edge, edge);
+      quadrics[remap[from]].AddPlane(edgeNormal, edgeDistance, weight);
+      quadrics[remap[to]].AddPlane(edgeNormal, edgeDistance, weight);
+    }
+  }
+
+  auto canCollapse = [&](uint32_t from, uint32_t to) {
+    if (remap[from] == remap[to]) return false;
+    switch (kinds[from]) {
+      case VertexKind::MANIFOLD:
+        return true;
+      case VertexKind::BORDER:
+      case VertexKind::SEAM:
+        return kinds[to] == kinds[from] &&
+               (openOut[from] == to || openIn[from] == to);
+      default:
+        return false;
+    }
+  };
+  auto getCost = [&](uint32_t from, uint32_t to) {
+    Quadric quadric = quadrics[remap[from]];
+    quadric.Add(quadrics[remap[to]]);
+    return static_cast<float>(quadric.Evaluate(positions[to]));
+  };
+  // Reconnect the open edges around from to to
+  auto relink = [&](uint32_t from, uint32_t to) {
+    if (openOut[from] == to) {
+      uint32_t previous = openIn[from];
+      if (IsSingle(previous) && openOut[previous] == from) {
+        openOut[previous] = to;
+      }
+      openIn[to] = previous;
+    } else if (openIn[from] == to) {
+      uint32_t next = openOut[from];
+      if (IsSingle(next) && openIn[next] == from) {
+        openIn[next] = to;
+      }
+      openOut[to] = next;
+    }
+  };
+
+  const float maxErrorSquared = maxError * maxError;
+  std::vector<Collapse> collapses;
+  std::vector<uint32_t> collapseRemap(vertexCount);
+  std::vector<uint8_t> locked(vertexCount);
+  while (result.size() > targetIndexCount) {
+    edges.Build(result, vertexCount);
+
+    // Cheaper direction of every edge. Interior edges appear twice, so only
+    // the half-edge with the smaller source is taken.
+    collapses.clear();
+    for (size_t i = 0; i < result.size(); ++i) {
+      uint32_t a = result[i];
+      uint32_t b = result[i % 3 == 2 ? i - 2 : i + 1];
+      if (a > b && edges.Has(b, a)) continue;
+      Collapse best{0, 0, FLT_MAX};
+      for (auto [from, to] : {std::pair(a, b), std::pair(b, a)}) {
+        if (!canCollapse(from, to)) continue;
+        float cost = getCost(from, to);
+        if (cost < best.error) best = {from, to, cost};
+      }
+      if (best.error <= maxErrorSquared) {
+        collapses.push_back(best);
+      }
+    }
+    if (collapses.empty()) break;
+    std::sort(collapses.begin(), collapses.end(),
+              [](const Collapse& a, const Collapse& b) {
+                return a.error < b.error ||
+                       (a.error == b.error &&
+                        (a.from < b.from ||
+                         (a.from == b.from && a.to < b.to)));
+              });
+
+    // Independent collapses, cheapest first. Borders remove one triangle
+    // per collapse and other edges about two.
+    std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+    std::fill(locked.begin(), locked.end(), 0);
+    size_t triangleGoal = (result.size() - targetIndexCount) / 3;
+    size_t removed = 0;
+    size_t applied = 0;
+    for (const Collapse& collapse : collapses) {
+      if (removed >= triangleGoal) break;
+      uint32_t from = collapse.from;
+      uint32_t to = collapse.to;
+      if (locked[remap[from]] || locked[remap[to]]) continue;
+      bool seam = kinds[from] == VertexKind::SEAM;
+      if (HasFlips(positions, result, edges, from, to) ||
+          (seam && HasFlips(positions, result, edges, wedge[from],
+                            wedge[to]))) {
+        continue;
+      }
+
+      collapseRemap[from] = to;
+      quadrics[remap[to]].Add(quadrics[remap[from]]);
+      if (kinds[from] != VertexKind::MANIFOLD) {
+        relink(from, to);
+      }
+      if (seam) {
+        collapseRemap[wedge[from]] = wedge[to];
+        relink(wedge[from], wedge[to]);
+      }
+      locked[remap[from]] = locked[remap[to]] = 1;
+      error = std::max(error, collapse.error);
+      removed += kinds[from] == VertexKind::BORDER ? 1 : 2;
+      ++applied;
+    }
+    if (applied == 0) break;
+
+    // Drop the triangles which lost an edge
+    size_t out = 0;
+    for (size_t i = 0; i < result.size(); i += 3) {
+      uint32_t a = collapseRemap[result[i]];
+      uint32_t b = collapseRemap[result[i + 1]];
+      uint32_t c = collapseRemap[result[i + 2]];
+      if (a == b || b == c || c == a) continue;
+      result[out++] = a;
+      result[out++] = b;
+      result[out++] = c;
+    }
+    result.resize(out);
+  }
+
+  error = std::sqrt(error);
+  return result;
+}
+
+}  // namespace MeshSimplifier
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+// Standard library
+#include <cstdint>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// Quadric error edge collapse for indexed triangle lists (Garland-Heckbert)
+// - Vertices are not moved. Each collapse merges a vertex into a neighbor,
+//   so the result indexes the same vertex buffer as the input.
+// - Vertices at the same position with different attributes are UV seams,
+//   and edges used by one triangle are borders. Seam and border vertices
+//   only collapse along their seam or border onto another vertex of the
+//   same kind, so the attribute split and the outline are kept. Borders
+//   also add planes along their edges to the quadrics.
+// - Collapses which flip a triangle are rejected.
+// Passes collapse the cheapest independent edges until the target is
+// reached or no edge is under maxError.
+namespace MeshSimplifier {
+
+constexpr float BORDER_WEIGHT = 10.0f;
+
+// error: Largest distance from the input surface of the collapses applied,
+// in position units
+std::vector<uint32_t> Simplify(const std::vector<glm::vec3>& positions,
+                               const std::vector<uint32_t>& indices,
+                               size_t targetIndexCount, float maxError,
+                               float& error);
+
+}  // namespace MeshSimplifier
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "meshlet_builder.h"
+
+#include "thread_pool.h"
+
+// Standard library
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+namespace MeshletBuilder {
+
+namespace {
+
+// Whether every edge is shared by two triangles in opposite directions.
+// Vertices are compared by position, so UV seams do not open the mesh.
+bool IsClosed(const std::vector<Vertex>& vertices,
+              const std::vector<uint32_t>& indices) {
+  std::vector<uint32_t> order(vertices.size());
+  std::iota(order.begin(), order.end(), 0u);
+  auto less = [&vertices](uint32_t a, uint32_t b) {
+    const glm::vec3& p = vertices[a].position;
+    const glm::vec3& q = vertices[b].position;
+    if (p.x != q.x) return p.x < q.x;
+    if (p.y != q.y) return p.y < q.y;
+    return p.z < q.z;
+  };
+  std::sort(order.begin(), order.end(), less);
+  std::vector<uint32_t> remap(vertices.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    bool same = i > 0 && vertices[order[i]].position ==
+                             vertices[order[i - 1]].position;
+    remap[order[i]] = same ? remap[order[i - 1]] : order[i];
+  }
+
+  std::vector<uint64_t> edges(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    uint64_t from = remap[indices[i]];
+    uint64_t to = remap[indices[i % 3 == 2 ? i - 2 : i + 1]];
+    edges[i] = from << 32 | to;
+  }
+  std::sort(edges.begin(), edges.end());
+  for (uint64_t edge : edges) {
+    uint64_t twin = edge << 32 | edge >> 32;
+    if (!std::binary_search(edges.begin(), edges.end(), twin)) return false;
+  }
+  return true;
+}
+
+// Partition the triangles of [begin, end) into meshlets and reorder them in
+// place. Offsets of the meshlets are relative to begin.
+void BuildBlock(const std::vector<Vertex>& vertices, uint32_t* begin,
+                uint32_t* end, bool closed, std::vector<Meshlet>& meshlets) {
+  const size_t triangleCount = (end - begin) / 3;
+  const std::vector<uint32_t> source(begin, end);
+
+  std::vector<glm::vec3> normals(triangleCount);
+  for (size_t i = 0; i < triangleCount; ++i) {
+    const glm::vec3& p0 = vertices[source[i * 3]].position;
+    glm::vec3 normal = glm::cross(vertices[source[i * 3 + 1]].position - p0,
+                                  vertices[source[i * 3 + 2]].position - p0);
+    float length = glm::length(normal);
+    normals[i] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+  }
+
+  // Local vertex ids and the triangles around each of them
+  std::vector<uint32_t> corners(source.size());
+  std::iota(corners.begin(), corners.end(), 0u);
+  std::sort(corners.begin(), corners.end(), [&source](uint32_t a, uint32_t b) {
+    return source[a] < source[b] || (source[a] == source[b] && a < b);
+  });
+  std::vector<uint32_t> localIds(source.size());
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> adjacency(source.size());
+  for (size_t i = 0; i < corners.size(); ++i) {
+    if (i == 0 || source[corners[i]] != source[corners[i - 1]]) {
+      offsets.push_back(static_cast<uint32_t>(i));
+    }
+    localIds[corners[i]] = static_cast<uint32_t>(offsets.size() - 1);
+    adjacency[i] = corners[i] / 3;
+  }
+  offsets.push_back(static_cast<uint32_t>(corners.size()));
+
+  std::vector<uint32_t> meshletIds(offsets.size() - 1, UINT32_MAX);
+  std::vector<uint8_t> assigned(triangleCount, 0);
+  std::vector<uint32_t> candidateIds(triangleCount, UINT32_MAX);
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> members;
+  uint32_t* out = begin;
+  size_t seed = 0;
+  while (true) {
+    while (seed < triangleCount && assigned[seed]) ++seed;
+    if (seed == triangleCount) break;
+
+    const uint32_t meshletId = static_cast<uint32_t>(meshlets.size());
+    glm::vec3 normalSum(0.0f);
+    candidates.assign(1, static_cast<uint32_t>(seed));
+    members.clear();
+    while (members.size() < MAX_TRIANGLES) {
+      // Best unassigned candidate. Assigned ones are dropped on the way.
+      glm::vec3 axis = glm::length(normalSum) > 0.0f
+                           ? glm::normalize(normalSum)
+                           : glm::vec3(0.0f);
+      size_t best = SIZE_MAX;
+      float bestScore = -FLT_MAX;
+      float bestDot = 1.0f;
+      for (size_t i = 0; i < candidates.size();) {
+        uint32_t triangle = candidates[i];
+        if (assigned[triangle]) {
+          candidates[i] = candidates.back();
+          candidates.pop_back();
+          continue;
+        }
+        int shared = 0;
+        for (int j = 0; j < 3; ++j) {
+          shared += meshletIds[localIds[triangle * 3 + j]] == meshletId;
+        }
+        float dot = members.empty() ? 1.0f : glm::dot(normals[triangle], axis);
+        float score = shared + 2.0f * dot;
+        if (score > bestScore || (score == bestScore && triangle < best)) {
+          best = triangle;
+          bestScore = score;
+          bestDot = dot;
+        }
+        ++i;
+      }
+      if (best == SIZE_MAX ||
+          (members.size() >= MIN_TRIANGLES && bestDot < CONE_DOT)) {
+        break;
+      }
+
+      assigned[best] = 1;
+      members.push_back(static_cast<uint32_t>(best));
+      normalSum += normals[best];
+      for (int j = 0; j < 3; ++j) {
+        uint32_t localId = localIds[best * 3 + j];
+        if (meshletIds[localId] == meshletId) continue;
+        meshletIds[localId] = meshletId;
+        for (uint32_t k = offsets[localId]; k < offsets[localId + 1]; ++k) {
+          uint32_t triangle = adjacency[k];
+          if (assigned[triangle] || candidateIds[triangle] == meshletId) {
+            continue;
+          }
+          candidateIds[triangle] = meshletId;
+          candidates.push_back(triangle);
+        }
+      }
+    }
+
+    std::sort(members.begin(), members.end());
+    Meshlet meshlet;
+    meshlet.indexOffset = static_cast<uint32_t>(out - begin);
+    meshlet.indexCount = static_cast<uint32_t>(members.size() * 3);
+    glm::vec3 boxMin(FLT_MAX);
+    glm::vec3 boxMax(-FLT_MAX);
+    for (uint32_t triangle : members) {
+      for (int j = 0; j < 3; ++j) {
+        uint32_t index = source[triangle * 3 + j];
+        boxMin = glm::min(boxMin, vertices[index].position);
+        boxMax = glm::max(boxMax, vertices[index].position);
+        *out++ = index;
+      }
+    }
+    glm::vec3 center = 0.5f * (boxMin + boxMax);
+    float radius = 0.0f;
+    for (uint32_t triangle : members) {
+      for (int j = 0; j < 3; ++j) {
+        radius = std::max(radius, glm::length(vertices[source[triangle * 3 + j]]
+                                                  .position -
+                                              center));
+      }
+    }
+    std::copy(&center.x, &center.x + 3, meshlet.center);
+    meshlet.radius = radius;
+
+    if (closed && glm::length(normalSum) > 0.0f) {
+      glm::vec3 axis = glm::normalize(normalSum);
+      float minDot = 1.0f;
+      for (uint32_t triangle : members) {
+        if (normals[triangle] != glm::vec3(0.0f)) {
+          minDot = std::min(minDot, glm::dot(normals[triangle], axis));
+        }
+      }
+      std::copy(&axis.x, &axis.x + 3, meshlet.coneAxis);
+      if (minDot > 0.0f) {
+        meshlet.coneSin = std::sqrt(std::max(0.0f, 1.0f - minDot * minDot));
+      }
+    }
+    meshlets.push_back(meshlet);
+  }
+}
+
+}  // namespace
+
+std::vector<Meshlet> Build(const std::vector<Vertex>& vertices,
+                           std::vector<uint32_t>& indices) {
+  const size_t triangleCount = indices.size() / 3;
+  if (triangleCount == 0) return {};
+  const bool closed = IsClosed(vertices, indices);
+
+  const size_t blockCount =
+      (triangleCount + BLOCK_TRIANGLES - 1) / BLOCK_TRIANGLES;
+  std::vector<std::vector<Meshlet>> blockMeshlets(blockCount);
+  ThreadPool::Instance().ParallelFor(
+      blockCount, 1, [&](size_t blockBegin, size_t blockEnd) {
+        for (size_t i = blockBegin; i < blockEnd; ++i) {
+          size_t begin = i * BLOCK_TRIANGLES * 3;
+          size_t end = std::min((i + 1) * BLOCK_TRIANGLES, triangleCount) * 3;
+          BuildBlock(vertices, indices.data() + begin, indices.data() + end,
+                     closed, blockMeshlets[i]);
+        }
+      });
+
+  std::vector<Meshlet> meshlets;
+  for (size_t i = 0; i < blockCount; ++i) {
+    uint32_t blockOffset = static_cast<uint32_t>(i * BLOCK_TRIANGLES * 3);
+    for (Meshlet& meshlet : blockMeshlets[i]) {
+      meshlet.indexOffset += blockOffset;
+      meshlets.push_back(meshlet);
+    }
+  }
+  return meshlets;
+}
+
+}  // namespace MeshletBuilder
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "mesh.h"
+
+// Standard library
+#include <vector>
+
+// Splits triangle lists into meshlets for per-cluster culling
+// - Each meshlet grows from the first unassigned triangle over triangles
+//   sharing its vertices, preferring those which share the most vertices and
+//   face the same way. It is closed at MAX_TRIANGLES, or from MIN_TRIANGLES
+//   on when the best candidate deviates more than CONE_DOT from its normal.
+// - The triangles of a meshlet keep their relative order, so the vertex
+//   cache order of MeshOptimizer mostly survives.
+// - Normal cones are only kept for closed meshes. Back faces are drawn, so
+//   a back-facing part of an open mesh may be visible through its holes.
+// Large meshes are processed in blocks of BLOCK_TRIANGLES on the thread
+// pool. The result does not depend on the thread count.
+namespace MeshletBuilder {
+
+constexpr size_t MIN_TRIANGLES = 64;
+constexpr size_t MAX_TRIANGLES = 128;
+constexpr float CONE_DOT = 0.7f;
+constexpr size_t BLOCK_TRIANGLES = 64 * 1024;
+
+// Reorder the triangles so that each meshlet is one range of indices
+std::vector<Meshlet> Build(const std::vector<Vertex>& vertices,
+                           std::vector<uint32_t>& indices);
+
+}  // namespace MeshletBuilder
\ No newline at end of file
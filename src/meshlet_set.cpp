@@ -0,0 +1,143 @@
+#include "meshlet_set.h"
+
+#include "config/gl_config.h"
+#include "util/frustum.h"
+
+// Standard library
+#include <cmath>
+
+MeshletSetUPtr MeshletSet::New(const Meshlet* meshlets, size_t count,
+                               uint32_t indexType) {
+  auto meshletSet = MeshletSetUPtr(new MeshletSet());
+  if (!meshlets || count == 0) return nullptr;
+  meshletSet->init(meshlets, count, indexType);
+  return std::move(meshletSet);
+}
+
+void MeshletSet::init(const Meshlet* meshlets, size_t count,
+                      uint32_t indexType) {
+  m_IndexType = indexType;
+  m_IndexSize =
+      indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+  for (size_t i = 0; i < count; ++i) {
+    const Meshlet& meshlet = meshlets[i];
+    m_CenterX.push_back(meshlet.center[0]);
+    m_CenterY.push_back(meshlet.center[1]);
+    m_CenterZ.push_back(meshlet.center[2]);
+    m_Radii.push_back(meshlet.radius);
+    m_AxisX.push_back(meshlet.coneAxis[0]);
+    m_AxisY.push_back(meshlet.coneAxis[1]);
+    m_AxisZ.push_back(meshlet.coneAxis[2]);
+    m_ConeSins.push_back(meshlet.coneSin);
+    m_IndexOffsets.push_back(meshlet.indexOffset);
+    m_IndexCounts.push_back(meshlet.indexCount);
+  }
+  m_Visible.assign(count, 1);
+  buildRanges();
+}
+
+void MeshletSet::Cull(const glm::mat4& localToClip) {
+  // Planes normalized, so that sphere radii can be compared
+  Frustum frustum = Frustum::FromMatrix(localToClip);
+  float planeX[6], planeY[6], planeZ[6], planeW[6];
+  for (int i = 0; i < 6; ++i) {
+    glm::vec4 plane = frustum.planes[i];
+    float length = glm::length(glm::vec3(plane));
+    if (length > 0.0f) plane = plane / length;
+    planeX[i] = plane.x;
+    planeY[i] = plane.y;
+    planeZ[i] = plane.z;
+    planeW[i] = plane.w;
+  }
+
+  // The camera is the point mapped to clip (0, 0, z, 0). Orthographic
+  // projections have none, and no meshlet is back-facing.
+  glm::vec4 eye = glm::inverse(localToClip) * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+  const float coneScale = std::abs(eye.w) > 1e-12f ? 1.0f : 0.0f;
+  const float eyeX = coneScale > 0.0f ? eye.x / eye.w : 0.0f;
+  const float eyeY = coneScale > 0.0f ? eye.y / eye.w : 0.0f;
+  const float eyeZ = coneScale > 0.0f ? eye.z / eye.w : 0.0f;
+
+  const size_t count = m_Radii.size();
+  const float* centerX = m_CenterX.data();
+  const float* centerY = m_CenterY.data();
+  const float* centerZ = m_CenterZ.data();
+  const float* radii = m_Radii.data();
+  const float* axisX = m_AxisX.data();
+  const float* axisY = m_AxisY.data();
+  const float* axisZ = m_AxisZ.data();
+  const float* coneSins = m_ConeSins.data();
+  uint8_t* visible = m_Visible.data();
+  for (size_t i = 0; i < count; ++i) {
+    float x = centerX[i];
+    float y = centerY[i];
+    float z = centerZ[i];
+    float radius = radii[i];
+    bool inside = true;
+    for (int j = 0; j < 6; ++j) {
+      inside &= planeX[j] * x + planeY[j] * y + planeZ[j] * z + planeW[j] >=
+                -radius;
+    }
+
+    // Back-facing if every direction from the camera into the sphere is
+    // within 90 degrees minus the cone angle of the axis
+    float dx = x - eyeX;
+    float dy = y - eyeY;
+    float dz = z - eyeZ;
+    float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+    float coneSin = coneSins[i];
+    bool backFacing = (dx * axisX[i] + dy * axisY[i] + dz * axisZ[i]) *
+                          coneScale >
+                      coneSin * distance + radius * (1.0f + coneSin);
+    visible[i] = inside & !backFacing;
+  }
+  buildRanges();
+}
+
+void MeshletSet::buildRanges() {
+  m_DrawCounts.clear();
+  m_DrawOffsets.clear();
+  m_VisibleTriangleCount = 0;
+  uint32_t rangeEnd = UINT32_MAX;
+  for (size_t i = 0; i < m_Visible.size(); ++i) {
+    if (!m_Visible[i]) continue;
+    uint32_t offset = m_IndexOffsets[i];
+    uint32_t indexCount = m_IndexCounts[i];
+    if (offset == rangeEnd) {
+      m_DrawCounts.back() += static_cast<int32_t>(indexCount);
+    } else {
+      m_DrawCounts.push_back(static_cast<int32_t>(indexCount));
+      m_DrawOffsets.push_back(
+          reinterpret_cast<const void*>(offset * m_IndexSize));
+    }
+    rangeEnd = offset + indexCount;
+    m_VisibleTriangleCount += indexCount / 3;
+  }
+}
+
+void MeshletSet::Draw(uint32_t primitiveType,
+                      const ShaderProgram* program) const {
+  if (m_DrawCounts.empty()) return;
+  if (program) {
+    auto primitiveBase = program->GetDrawUniforms().primitiveBase;
+    for (size_t i = 0; i < m_DrawCounts.size(); ++i) {
+      size_t offset = reinterpret_cast<size_t>(m_DrawOffsets[i]);
+      program->SetUniform(primitiveBase,
+                          static_cast<int>(offset / m_IndexSize / 3));
+      glDrawElements(primitiveType, m_DrawCounts[i], m_IndexType,
+                     m_DrawOffsets[i]);
+    }
+    return;
+  }
+#ifdef __EMSCRIPTEN__
+  // WebGL 2 has no multi-draw without WEBGL_multi_draw
+  for (size_t i = 0; i < m_DrawCounts.size(); ++i) {
+    glDrawElements(primitiveType, m_DrawCounts[i], m_IndexType,
+                   m_DrawOffsets[i]);
+  }
+#else
+  glMultiDrawElements(primitiveType, m_DrawCounts.data(), m_IndexType,
+                      m_DrawOffsets.data(),
+                      static_cast<GLsizei>(m_DrawCounts.size()));
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "macro/ptr_macro.h"
+#include "mesh.h"
+#include "shader_program.h"
+
+// Standard library
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// Per-frame culling of the meshlets of a mesh (see MeshletBuilder)
+// Meshlets outside the frustum or whose normal cone faces away from the
+// camera are skipped, and the visible ones are drawn with one multi-draw,
+// adjacent meshlets merged into one range. The bounds are kept as structure
+// of arrays and tested without branches, so the loop is vectorized by the
+// compiler (SSE, NEON or wasm SIMD).
+DECLARE_PTR(MeshletSet)
+class MeshletSet {
+ public:
+  // indexType: Index type of the mesh
+  static MeshletSetUPtr New(const Meshlet* meshlets, size_t count,
+                            uint32_t indexType);
+
+  size_t GetMeshletCount() const { return m_Radii.size(); }
+  size_t GetVisibleTriangleCount() const { return m_VisibleTriangleCount; }
+
+  // Main thread only
+  // Select the meshlets visible for localToClip (projection * view * model).
+  // All are visible until the first call.
+  void Cull(const glm::mat4& localToClip);
+  // Draw the visible meshlets with the layout of the mesh bound. With a
+  // program, the ranges are drawn one by one with u_primitiveBase set to
+  // their first triangle (see Mesh::Draw).
+  void Draw(uint32_t primitiveType,
+            const ShaderProgram* program = nullptr) const;
+
+ private:
+  MeshletSet() = default;
+
+  void init(const Meshlet* meshlets, size_t count, uint32_t indexType);
+
+  uint32_t m_IndexType{0};
+  size_t m_IndexSize{0};
+
+  // Bounds by component
+  std::vector<float> m_CenterX;
+  std::vector<float> m_CenterY;
+  std::vector<float> m_CenterZ;
+  std::vector<float> m_Radii;
+  std::vector<float> m_AxisX;
+  std::vector<float> m_AxisY;
+  std::vector<float> m_AxisZ;
+  std::vector<float> m_ConeSins;
+  std::vector<uint32_t> m_IndexOffsets;
+  std::vector<uint32_t> m_IndexCounts;
+
+  std::vector<uint8_t> m_Visible;
+  // Ranges for glMultiDrawElements
+  std::vector<int32_t> m_DrawCounts;
+  std::vector<const void*> m_DrawOffsets;
+  size_t m_VisibleTriangleCount{0};
+
+  void buildRanges();
+};
\ No newline at end of file
@@ -0,0 +1,397 @@
+#include "paged_mesh.h"
+
+#include "config/log_config.h"
+#include "mesh_cache.h"
+#include "util/frustum.h"
+#include "util/memory_stream_buffer.h"
+#include "util/path_util.h"
+
+// Standard library
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+// cereal
+#include <cereal/archives/binary.hpp>
+#include <cereal/cereal.hpp>
+#include <cereal/types/vector.hpp>
+
+CEREAL_CLASS_VERSION(PagedMesh::Chunk, 1);
+CEREAL_CLASS_VERSION(PagedMesh::Header, 1);
+
+namespace {
+
+constexpr char MAGIC[8] = {'C', 'P', 'A', 'G', 'E', '\0', '\0', '\0'};
+constexpr size_t PREFIX_SIZE =
+    sizeof(MAGIC) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+
+glm::vec3 ToVec3(const float (&values)[3]) {
+  return glm::vec3(values[0], values[1], values[2]);
+}
+
+}  // namespace
+
+PagedMesh::ResidentList PagedMesh::s_Residents;
+size_t PagedMesh::s_ResidentSize = 0;
+size_t PagedMesh::s_ResidentBudget = PagedMesh::DEFAULT_RESIDENT_BUDGET;
+size_t PagedMesh::s_UploadSize = 0;
+uint64_t PagedMesh::s_Frame = 1;
+
+PagedMesh::Writer::~Writer() {
+  if (m_File.is_open()) {
+    m_File.close();
+    std::remove(m_TempPath.c_str());
+  }
+}
+
+bool PagedMesh::Writer::Open(const std::string& pagePath) {
+  m_Path = pagePath;
+  m_TempPath = PathUtil::GetUniquePath(pagePath) + ".tmp";
+  m_File.open(m_TempPath, std::ios::binary | std::ios::trunc);
+  if (!m_File.is_open()) {
+    SPDLOG_WARN("Failed to create page file: {}", pagePath);
+    return false;
+  }
+
+  // The prefix is rewritten by Close() once the header offset is known.
+  const char prefix[PREFIX_SIZE] = {};
+  m_File.write(prefix, sizeof(prefix));
+  m_Offset = PREFIX_SIZE;
+  m_Header = Header();
+  m_Header.vertexStride = sizeof(Vertex);
+  return static_cast<bool>(m_File);
+}
+
+void PagedMesh::Writer::pad() {
+  const char padding[BLOCK_ALIGNMENT] = {};
+  size_t size = (BLOCK_ALIGNMENT - m_Offset % BLOCK_ALIGNMENT) %
+                BLOCK_ALIGNMENT;
+  m_File.write(padding, size);
+  m_Offset += size;
+}
+
+bool PagedMesh::Writer::AddChunk(const std::vector<Vertex>& vertices,
+                                 const std::vector<uint32_t>& indices) {
+  if (vertices.empty() || indices.empty()) {
+    return true;
+  }
+
+  Chunk chunk;
+  glm::vec3 boundsMin = vertices.front().position;
+  glm::vec3 boundsMax = vertices.front().position;
+  for (const auto& vertex : vertices) {
+    boundsMin = glm::min(boundsMin, vertex.position);
+    boundsMax = glm::max(boundsMax, vertex.position);
+  }
+  std::memcpy(chunk.boundsMin, &boundsMin, sizeof(chunk.boundsMin));
+  std::memcpy(chunk.boundsMax, &boundsMax, sizeof(chunk.boundsMax));
+  if (m_Header.chunks.empty()) {
+    std::memcpy(m_Header.boundsMin, &boundsMin, sizeof(m_Header.boundsMin));
+    std::memcpy(m_Header.boundsMax, &boundsMax, sizeof(m_Header.boundsMax));
+  } else {
+    for (int i = 0; i < 3; ++i) {
+      m_Header.boundsMin[i] = std::min(m_Header.boundsMin[i], boundsMin[i]);
+      m_Header.boundsMax[i] = std::max(m_Header.boundsMax[i], boundsMax[i]);
+    }
+  }
+
+  pad();
+  chunk.vertexOffset = m_Offset;
+  chunk.vertexCount = vertices.size();
+  m_File.write(reinterpret_cast<const char*>(vertices.data()),
+               vertices.size() * sizeof(Vertex));
+  m_Offset += vertices.size() * sizeof(Vertex);
+
+  pad();
+  chunk.indexOffset = m_Offset;
+  chunk.indexCount = indices.size();
+  m_File.write(reinterpret_cast<const char*>(indices.data()),
+               indices.size() * sizeof(uint32_t));
+  m_Offset += indices.size() * sizeof(uint32_t);
+
+  m_Header.chunks.push_back(chunk);
+  return static_cast<bool>(m_File);
+}
+
+bool PagedMesh::Writer::Close(const std::string& sourcePath,
+                              uint64_t optionsHash) {
+  if (!m_File.is_open() || m_Header.chunks.empty()) {
+    return false;
+  }
+
+  MeshCache::GetSourceStamp(sourcePath, m_Header.sourceSize,
+                            m_Header.sourceTime);
+  m_Header.optionsHash = optionsHash;
+
+  std::ostringstream stream(std::ios::binary);
+  {
+    cereal::BinaryOutputArchive archive(stream);
+    archive(m_Header);
+  }
+  std::string headerBytes = stream.str();
+
+  pad();
+  uint64_t headerOffset = m_Offset;
+  m_File.write(headerBytes.data(), headerBytes.size());
+
+  uint32_t formatVersion = FORMAT_VERSION;
+  uint32_t headerSize = static_cast<uint32_t>(headerBytes.size());
+  m_File.seekp(0);
+  m_File.write(MAGIC, sizeof(MAGIC));
+  m_File.write(reinterpret_cast<const char*>(&formatVersion),
+               sizeof(formatVersion));
+  m_File.write(reinterpret_cast<const char*>(&headerSize),
+               sizeof(headerSize));
+  m_File.write(reinterpret_cast<const char*>(&headerOffset),
+               sizeof(headerOffset));
+  if (!m_File) {
+    SPDLOG_WARN("Failed to write page file: {}", m_Path);
+    return false;  // Removed by the destructor
+  }
+
+  m_File.close();
+  if (!m_File) {
+    SPDLOG_WARN("Failed to write page file: {}", m_Path);
+    std::remove(m_TempPath.c_str());
+    return false;
+  }
+  std::error_code error;
+  std::filesystem::rename(m_TempPath, m_Path, error);
+  if (error) {
+    SPDLOG_WARN("Failed to replace page file: {} ({})", m_Path,
+                error.message());
+    std::remove(m_TempPath.c_str());
+    return false;
+  }
+  SPDLOG_INFO("Page file written: {} ({} chunks)", m_Path,
+              m_Header.chunks.size());
+  return true;
+}
+
+std::string PagedMesh::GetPagePath(const std::string& sourcePath) {
+  return sourcePath + ".cpage";
+}
+
+PagedMeshUPtr PagedMesh::New(const std::string& pagePath,
+                             const std::string& sourcePath,
+                             uint64_t optionsHash) {
+  auto pagedMesh = PagedMeshUPtr(new PagedMesh());
+  if (!pagedMesh->open(pagePath, sourcePath, optionsHash)) {
+    return nullptr;
+  }
+  return std::move(pagedMesh);
+}
+
+void PagedMesh::BeginFrame() {
+  ++s_Frame;
+  s_UploadSize = 0;
+}
+
+PagedMesh::~PagedMesh() {
+  for (uint32_t i = 0; i < m_Chunks.size(); ++i) {
+    evict(i);
+  }
+}
+
+bool PagedMesh::open(const std::string& pagePath,
+                     const std::string& sourcePath, uint64_t optionsHash) {
+  std::error_code error;
+  if (!std::filesystem::exists(pagePath, error)) {
+    return false;
+  }
+
+  m_FileView = FileView::New(pagePath);
+  if (!m_FileView) {
+    return false;
+  }
+
+  const uint8_t* data = m_FileView->GetData();
+  size_t size = m_FileView->GetSize();
+  uint32_t formatVersion = 0;
+  uint32_t headerSize = 0;
+  uint64_t headerOffset = 0;
+  if (size < PREFIX_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+    SPDLOG_WARN("Not a page file: {}", pagePath);
+    return false;
+  }
+  const uint8_t* field = data + sizeof(MAGIC);
+  std::memcpy(&formatVersion, field, sizeof(formatVersion));
+  field += sizeof(formatVersion);
+  std::memcpy(&headerSize, field, sizeof(headerSize));
+  field += sizeof(headerSize);
+  std::memcpy(&headerOffset, field, sizeof(headerOffset));
+  if (formatVersion != FORMAT_VERSION || headerOffset > size ||
+      headerSize > size - headerOffset) {
+    SPDLOG_WARN("Outdated page file: {}", pagePath);
+    return false;
+  }
+
+  MemoryStreamBuffer streamBuffer(data + headerOffset, headerSize);
+  std::istream stream(&streamBuffer);
+  try {
+    cereal::BinaryInputArchive archive(stream);
+    archive(m_Header);
+  } catch (const cereal::Exception& e) {
+    SPDLOG_WARN("Failed to read page file header: {} ({})", pagePath,
+                e.what());
+    return false;
+  }
+
+  bool validLayout =
+      m_Header.vertexStride == sizeof(Vertex) && !m_Header.chunks.empty();
+  for (const auto& chunk : m_Header.chunks) {
+    validLayout =
+        validLayout && chunk.vertexOffset % BLOCK_ALIGNMENT == 0 &&
+        chunk.indexOffset % BLOCK_ALIGNMENT == 0 &&
+        m_FileView->Contains(chunk.vertexOffset, chunk.vertexCount,
+                             sizeof(Vertex)) &&
+        m_FileView->Contains(chunk.indexOffset, chunk.indexCount,
+                             sizeof(uint32_t));
+  }
+  if (!validLayout) {
+    SPDLOG_WARN("Corrupted page file: {}", pagePath);
+    return false;
+  }
+
+  // Indices go to the GPU unchecked on upload, and page files may be
+  // opened directly. The scanned pages are released again.
+  for (const auto& chunk : m_Header.chunks) {
+    const uint32_t* indices =
+        reinterpret_cast<const uint32_t*>(data + chunk.indexOffset);
+    for (uint64_t i = 0; i < chunk.indexCount; ++i) {
+      if (indices[i] >= chunk.vertexCount) {
+        SPDLOG_WARN("Corrupted page file, index out of range: {}", pagePath);
+        return false;
+      }
+    }
+    m_FileView->ReleasePages(chunk.indexOffset,
+                             chunk.indexCount * sizeof(uint32_t));
+  }
+
+  if (!sourcePath.empty()) {
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (!MeshCache::GetSourceStamp(sourcePath, sourceSize, sourceTime) ||
+        sourceSize != m_Header.sourceSize ||
+        sourceTime != m_Header.sourceTime) {
+      SPDLOG_INFO("Page file is stale: {}", pagePath);
+      return false;
+    }
+    if (optionsHash != m_Header.optionsHash) {
+      SPDLOG_INFO("Page file was built with other options: {}", pagePath);
+      return false;
+    }
+  }
+
+  m_Chunks.resize(m_Header.chunks.size());
+  return true;
+}
+
+glm::vec3 PagedMesh::GetBoundsMin() const {
+  return ToVec3(m_Header.boundsMin);
+}
+
+glm::vec3 PagedMesh::GetBoundsMax() const {
+  return ToVec3(m_Header.boundsMax);
+}
+
+void PagedMesh::Update(const glm::mat4& localToClip) {
+  Frustum frustum = Frustum::FromMatrix(localToClip);
+  glm::vec4 depthRow(localToClip[0][3], localToClip[1][3], localToClip[2][3],
+                     localToClip[3][3]);
+
+  std::vector<std::pair<float, uint32_t>> visible;
+  for (uint32_t i = 0; i < m_Header.chunks.size(); ++i) {
+    const Chunk& chunk = m_Header.chunks[i];
+    glm::vec3 boundsMin = ToVec3(chunk.boundsMin);
+    glm::vec3 boundsMax = ToVec3(chunk.boundsMax);
+    if (frustum.Intersects(boundsMin, boundsMax)) {
+      glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+      visible.emplace_back(glm::dot(depthRow, glm::vec4(center, 1.0f)), i);
+    }
+  }
+  std::sort(visible.begin(), visible.end());
+
+  m_VisibleChunks.clear();
+  for (const auto& [depth, i] : visible) {
+    ChunkState& state = m_Chunks[i];
+    state.visibleFrame = s_Frame;
+    if (state.mesh) {
+      s_Residents.splice(s_Residents.begin(), s_Residents, state.resident);
+    }
+    m_VisibleChunks.push_back(i);
+  }
+
+  // Nearest chunks first, until the frame or resident budget runs out
+  for (uint32_t i : m_VisibleChunks) {
+    if (m_Chunks[i].mesh) continue;
+    if (s_UploadSize >= UPLOAD_BUDGET || !upload(i)) break;
+  }
+}
+
+void PagedMesh::Draw(const ShaderProgram* program) const {
+  for (uint32_t i : m_VisibleChunks) {
+    const ChunkState& state = m_Chunks[i];
+    if (state.mesh && state.visibleFrame == s_Frame) {
+      state.mesh->Draw(program);
+    }
+  }
+}
+
+bool PagedMesh::upload(uint32_t chunk) {
+  const Chunk& info = m_Header.chunks[chunk];
+  size_t vertexSize = info.vertexCount * sizeof(Vertex);
+  size_t indexSize = info.indexCount * sizeof(uint32_t);
+  // Mesh stores the indices as uint16 whenever it can.
+  size_t indexStride =
+      info.vertexCount > UINT16_MAX ? sizeof(uint32_t) : sizeof(uint16_t);
+  size_t gpuSize = info.vertexCount * m_VertexFormat.GetStride() +
+                   info.indexCount * indexStride;
+  if (!makeRoom(gpuSize)) {
+    return false;
+  }
+
+  const uint8_t* data = m_FileView->GetData();
+  ChunkState& state = m_Chunks[chunk];
+  state.mesh = Mesh::New(
+      reinterpret_cast<const Vertex*>(data + info.vertexOffset),
+      info.vertexCount,
+      reinterpret_cast<const uint32_t*>(data + info.indexOffset),
+      info.indexCount, GL_TRIANGLES, ToVec3(info.boundsMin),
+      ToVec3(info.boundsMax), m_VertexFormat);
+  // The bytes are in VRAM now and are paged in again if evicted.
+  m_FileView->ReleasePages(info.vertexOffset, vertexSize);
+  m_FileView->ReleasePages(info.indexOffset, indexSize);
+  if (!state.mesh) {
+    return false;
+  }
+
+  state.size = gpuSize;
+  state.resident = s_Residents.emplace(s_Residents.begin(), this, chunk);
+  s_ResidentSize += state.size;
+  s_UploadSize += state.size;
+  return true;
+}
+
+void PagedMesh::evict(uint32_t chunk) {
+  ChunkState& state = m_Chunks[chunk];
+  if (!state.mesh) return;
+
+  state.mesh.reset();
+  s_Residents.erase(state.resident);
+  s_ResidentSize -= state.size;
+  state.size = 0;
+}
+
+bool PagedMesh::makeRoom(size_t size) {
+  while (s_ResidentSize + size > s_ResidentBudget && !s_Residents.empty()) {
+    auto [pagedMesh, chunk] = s_Residents.back();
+    if (pagedMesh->m_Chunks[chunk].visibleFrame == s_Frame) {
+      // Everything left is on screen
+      return false;
+    }
+    pagedMesh->evict(chunk);
+  }
+  return s_ResidentSize + size <= s_ResidentBudget || s_Residents.empty();
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "macro/ptr_macro.h"
+#include "mesh.h"
+#include "util/file_view.h"
+
+// Standard library
+#include <fstream>
+#include <list>
+#include <string>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// Out-of-core mesh split into spatial chunks (.cpage)
+// File layout:
+// - Magic "CPAGE" + format version (uint32) + header size (uint32) + header
+//   offset (uint64)
+// - Chunk blocks: raw Vertex array and uint32_t array per chunk, with indices
+//   local to the chunk
+// - Header serialized with cereal (versioned) at the end, so that chunks can
+//   be written one at a time: source file stamp, import options hash,
+//   bounds and the chunk table
+// Blocks start at BLOCK_ALIGNMENT. The file is mapped and only the chunks
+// inside the view frustum are uploaded, nearest first and within a per-frame
+// budget. Uploaded chunks are shared by all paged meshes in one LRU list, and
+// the least recently visible ones are deleted when the resident size is over
+// budget. Pages of uploaded chunks are released, so neither RAM nor VRAM
+// needs to hold the whole mesh.
+DECLARE_PTR(PagedMesh)
+class PagedMesh {
+ public:
+  static constexpr uint32_t FORMAT_VERSION = 2;
+  static constexpr size_t BLOCK_ALIGNMENT = 64;
+  static constexpr size_t DEFAULT_RESIDENT_BUDGET = 1024 * 1024 * 1024;
+  static constexpr size_t UPLOAD_BUDGET = 64 * 1024 * 1024;  // Per frame
+
+  struct Chunk {
+    float boundsMin[3]{};
+    float boundsMax[3]{};
+    uint64_t vertexOffset{0};
+    uint64_t vertexCount{0};
+    uint64_t indexOffset{0};
+    uint64_t indexCount{0};
+
+    template <class Archive>
+    void serialize(Archive& archive, const uint32_t version) {
+      archive(boundsMin, boundsMax, vertexOffset, vertexCount, indexOffset,
+              indexCount);
+    }
+  };
+
+  struct Header {
+    uint64_t sourceSize{0};
+    int64_t sourceTime{0};
+    uint64_t optionsHash{0};
+    float boundsMin[3]{};
+    float boundsMax[3]{};
+    uint64_t vertexStride{0};
+    std::vector<Chunk> chunks;
+
+    template <class Archive>
+    void serialize(Archive& archive, const uint32_t version) {
+      archive(sourceSize, sourceTime, optionsHash, boundsMin, boundsMax,
+              vertexStride, chunks);
+    }
+  };
+
+  // Writes a page file chunk by chunk. An unfinished file is removed.
+  class Writer {
+   public:
+    ~Writer();
+
+    // Written to a temporary file renamed over pagePath by Close(), so that
+    // a page file mapped by a live PagedMesh is never truncated
+    bool Open(const std::string& pagePath);
+    // Indices are local to the chunk
+    bool AddChunk(const std::vector<Vertex>& vertices,
+                  const std::vector<uint32_t>& indices);
+    bool Close(const std::string& sourcePath, uint64_t optionsHash);
+
+   private:
+    std::string m_Path;
+    std::string m_TempPath;
+    std::ofstream m_File;
+    uint64_t m_Offset{0};
+    Header m_Header;
+
+    void pad();
+  };
+
+  // Page file path for a source mesh file
+  static std::string GetPagePath(const std::string& sourcePath);
+
+  // Open a page file. If sourcePath is not empty, the file is rejected when
+  // it was not written for the current version of the source file with the
+  // same import options. Does not touch GL.
+  static PagedMeshUPtr New(const std::string& pagePath,
+                           const std::string& sourcePath = "",
+                           uint64_t optionsHash = 0);
+
+  // Main thread only
+  // Reset the upload budget. Call once per frame before Update().
+  static void BeginFrame();
+  static void SetResidentBudget(size_t size) { s_ResidentBudget = size; }
+  static size_t GetResidentSize() { return s_ResidentSize; }
+
+  ~PagedMesh();
+
+  glm::vec3 GetBoundsMin() const;
+  glm::vec3 GetBoundsMax() const;
+  size_t GetChunkCount() const { return m_Header.chunks.size(); }
+  // Encoding of chunks uploaded from now on
+  void SetVertexFormat(const VertexFormat& format) { m_VertexFormat = format; }
+
+  // Find the chunks inside the frustum of localToClip, upload the missing
+  // ones and evict the least recently visible chunks of all paged meshes.
+  void Update(const glm::mat4& localToClip);
+  // Draw the visible chunks which are uploaded, front to back
+  void Draw(const ShaderProgram* program) const;
+
+ private:
+  PagedMesh() = default;
+
+  using ResidentList = std::list<std::pair<PagedMesh*, uint32_t>>;
+
+  struct ChunkState {
+    MeshUPtr mesh;
+    size_t size{0};  // Bytes in VRAM
+    uint64_t visibleFrame{0};
+    ResidentList::iterator resident;
+  };
+
+  static ResidentList s_Residents;  // Most recently visible first
+  static size_t s_ResidentSize;
+  static size_t s_ResidentBudget;
+  static size_t s_UploadSize;
+  static uint64_t s_Frame;
+
+  FileViewUPtr m_FileView;
+  Header m_Header;
+  VertexFormat m_VertexFormat;
+  std::vector<ChunkState> m_Chunks;
+  std::vector<uint32_t> m_VisibleChunks;
+
+  bool open(const std::string& pagePath, const std::string& sourcePath,
+            uint64_t optionsHash);
+  bool upload(uint32_t chunk);
+  void evict(uint32_t chunk);
+  // Evict chunks not visible this frame until size more bytes fit
+  static bool makeRoom(size_t size);
+};
\ No newline at end of file
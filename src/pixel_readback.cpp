@@ -0,0 +1,69 @@
+#include "pixel_readback.h"
+
+#include "gl_state.h"
+
+PixelReadbackUPtr PixelReadback::New() {
+  auto readback = PixelReadbackUPtr(new PixelReadback());
+  if (!readback->init()) {
+    return nullptr;
+  }
+  return std::move(readback);
+}
+
+PixelReadback::~PixelReadback() { Reset(); }
+
+bool PixelReadback::init() {
+  for (Slot& slot : m_Slots) {
+    // RGBA_INTEGER with INT is the read format every implementation takes
+    // for signed integer attachments
+    slot.buffer = Buffer::New(GL_PIXEL_PACK_BUFFER, GL_STREAM_READ, nullptr,
+                              sizeof(glm::ivec4), 1);
+    if (!slot.buffer) return false;
+  }
+  GLState::Instance().BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  return true;
+}
+
+bool PixelReadback::Request(int32_t attachment, int32_t x, int32_t y) {
+  if (m_PendingCount == RING_SIZE) return false;
+
+  Slot& slot = m_Slots[m_NextSlot];
+  slot.buffer->Bind();
+  glReadBuffer(GL_COLOR_ATTACHMENT0 + attachment);
+  glReadPixels(x, y, 1, 1, GL_RGBA_INTEGER, GL_INT, nullptr);  // Into buffer
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  GLState::Instance().BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  m_NextSlot = (m_NextSlot + 1) % RING_SIZE;
+  ++m_PendingCount;
+  return true;
+}
+
+bool PixelReadback::Poll(glm::ivec4& value) {
+  bool finished = false;
+  while (m_PendingCount > 0) {
+    size_t oldest = (m_NextSlot + RING_SIZE - m_PendingCount) % RING_SIZE;
+    Slot& slot = m_Slots[oldest];
+    GLenum status = glClientWaitSync(slot.fence, 0, 0);  // Does not wait
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+      break;
+    }
+    slot.buffer->GetSubData(0, &value, 1);
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    --m_PendingCount;
+    finished = true;
+  }
+  return finished;
+}
+
+void PixelReadback::Reset() {
+  for (Slot& slot : m_Slots) {
+    if (slot.fence) {
+      glDeleteSync(slot.fence);
+      slot.fence = nullptr;
+    }
+  }
+  m_PendingCount = 0;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "buffer.h"
+#include "config/gl_config.h"
+#include "macro/ptr_macro.h"
+
+// Standard library
+#include <array>
+
+// glm
+#include <glm/glm.hpp>
+
+// Asynchronous readback of single pixels of an integer color attachment
+// Each request copies the pixel into the next of RING_SIZE pixel pack
+// buffers and places a fence behind it. Copies are collected once their
+// fence has signaled, a frame or two later, so the CPU never waits for the
+// GPU. Requests are dropped while all buffers are in flight.
+DECLARE_PTR(PixelReadback)
+class PixelReadback {
+ public:
+  static constexpr size_t RING_SIZE = 3;
+
+  static PixelReadbackUPtr New();
+
+  ~PixelReadback();
+
+  // Main thread only
+  // Queue a copy of pixel (x, y) of GL_COLOR_ATTACHMENT0 + attachment of the
+  // bound framebuffer. The attachment must be a signed integer format.
+  // Return false if the request is dropped.
+  bool Request(int32_t attachment, int32_t x, int32_t y);
+  // Collect the finished copies without waiting. Return true if any has
+  // finished, with value set to the newest.
+  bool Poll(glm::ivec4& value);
+  // Forget the copies in flight
+  void Reset();
+
+ private:
+  PixelReadback() = default;
+
+  bool init();
+
+  struct Slot {
+    BufferUPtr buffer;
+    GLsync fence{nullptr};
+  };
+
+  std::array<Slot, RING_SIZE> m_Slots;
+  size_t m_NextSlot{0};
+  size_t m_PendingCount{0};
+};
\ No newline at end of file
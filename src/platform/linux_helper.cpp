@@ -0,0 +1,80 @@
+#include "linux_helper.h"
+
+#include "../config/log_config.h"
+
+// Standard library
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+const char* FILE_PATTERNS = "*.obj *.stl *.ply *.gltf *.glb *.cmesh *.cpage";
+
+// Run the command and return its standard output
+std::string RunCommand(const std::string& command) {
+  std::string output;
+  FILE* pipe = popen(command.c_str(), "r");
+  if (!pipe) {
+    return output;
+  }
+  char buffer[4096];
+  size_t size;
+  while ((size = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+    output.append(buffer, size);
+  }
+  pclose(pipe);
+  return output;
+}
+
+bool HasCommand(const char* name) {
+  std::string command = std::string("command -v ") + name + " >/dev/null 2>&1";
+  return std::system(command.c_str()) == 0;
+}
+
+std::vector<std::string> SplitLines(const std::string& text) {
+  std::vector<std::string> lines;
+  size_t begin = 0;
+  while (begin < text.size()) {
+    size_t end = text.find('\n', begin);
+    if (end == std::string::npos) end = text.size();
+    if (end > begin) {
+      lines.push_back(text.substr(begin, end - begin));
+    }
+    begin = end + 1;
+  }
+  return lines;
+}
+
+}  // namespace
+
+std::vector<std::string> LinuxHelper::OpenFileDialog() {
+  // One path per line, so that paths with spaces survive
+  if (HasCommand("zenity")) {
+    return SplitLines(RunCommand(
+        std::string("zenity --file-selection --multiple --separator='\n' "
+                    "--title='Import Meshes' --file-filter='Meshes | ") +
+        FILE_PATTERNS + "' 2>/dev/null"));
+  }
+  if (HasCommand("kdialog")) {
+    return SplitLines(RunCommand(
+        std::string("kdialog --getopenfilename . '") + FILE_PATTERNS +
+        "' --multiple --separate-output 2>/dev/null"));
+  }
+  SPDLOG_ERROR("Install zenity or kdialog to open the file dialog");
+  return {};
+}
+
+std::string LinuxHelper::OpenFolderDialog() {
+  std::vector<std::string> lines;
+  if (HasCommand("zenity")) {
+    lines = SplitLines(RunCommand(
+        "zenity --file-selection --directory --title='Import Folder' "
+        "2>/dev/null"));
+  } else if (HasCommand("kdialog")) {
+    lines = SplitLines(RunCommand("kdialog --getexistingdirectory . "
+                                  "2>/dev/null"));
+  } else {
+    SPDLOG_ERROR("Install zenity or kdialog to open the folder dialog");
+  }
+  return lines.empty() ? "" : lines.front();
+}
\ No newline at end of file
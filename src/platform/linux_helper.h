@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Native dialogs through zenity or kdialog, whichever is installed
+namespace LinuxHelper {
+
+std::vector<std::string> OpenFileDialog();
+// Return "" if cancelled
+std::string OpenFolderDialog();
+
+}  // namespace LinuxHelper
\ No newline at end of file
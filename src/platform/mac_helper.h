@@ -7,5 +7,7 @@ namespace MacHelper {
 
 float DevicePixelRatio();
 std::vector<std::string> OpenFileDialog();
+// Return "" if cancelled
+std::string OpenFolderDialog();
 
 }  // namespace MacHelper
\ No newline at end of file
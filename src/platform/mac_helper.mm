@@ -18,16 +18,21 @@ std::vector<std::string> MacHelper::OpenFileDialog() {
     [panel setAllowsMultipleSelection:YES];
     if (@available(macOS 12.0, *)) {
       NSMutableArray *contentTypes = [NSMutableArray array];
-      [contentTypes addObject:[UTType typeWithFilenameExtension:@"jpg"]];
-      [contentTypes addObject:[UTType typeWithFilenameExtension:@"png"]];
-      [contentTypes addObject:[UTType typeWithFilenameExtension:@"txt"]];
-      [contentTypes addObject:[UTType typeWithFilenameExtension:@"pdf"]];
+      for (NSString *extension in
+           @[@"obj", @"stl", @"ply", @"gltf", @"glb", @"cmesh", @"cpage"]) {
+        UTType *type = [UTType typeWithFilenameExtension:extension];
+        if (type) {
+          [contentTypes addObject:type];
+        }
+      }
       [panel setAllowedContentTypes:contentTypes];
     }
     else {
       #pragma clang diagnostic push
       #pragma clang diagnostic ignored "-Wdeprecated-declarations"
-      [panel setAllowedFileTypes:@[@"jpg", @"png", @"txt", @"pdf"]];
+      [panel setAllowedFileTypes:@[
+        @"obj", @"stl", @"ply", @"gltf", @"glb", @"cmesh", @"cpage"
+      ]];
       #pragma clang diagnostic pop
     }
 
@@ -40,4 +45,21 @@ std::vector<std::string> MacHelper::OpenFileDialog() {
   }
 
   return selectedFiles;
+}
+
+std::string MacHelper::OpenFolderDialog() {
+  std::string selectedFolder;
+
+  @autoreleasepool {
+    NSOpenPanel* panel = [NSOpenPanel openPanel];
+    [panel setCanChooseFiles:NO];
+    [panel setCanChooseDirectories:YES];
+    [panel setAllowsMultipleSelection:NO];
+
+    if ([panel runModal] == NSModalResponseOK) {
+      selectedFolder = std::string([[[panel URL] path] UTF8String]);
+    }
+  }
+
+  return selectedFolder;
 }
\ No newline at end of file
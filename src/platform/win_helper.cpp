@@ -3,6 +3,7 @@
 // Windows api headers
 #include <commdlg.h>
 #include <shellscalingapi.h>  // for GetDpiForMonitor
+#include <shlobj.h>           // for SHBrowseForFolder
 #include <windows.h>
 
 #pragma comment(lib, "Shcore.lib")
@@ -10,22 +11,23 @@
 std::vector<std::string> WinHelper::OpenFileDialog() {
   std::vector<std::string> fileList;
 
-  char buffer[4096] = {0};
+  // Large enough for hundreds of selected files
+  std::vector<char> buffer(256 * 1024, '\0');
 
   OPENFILENAMEA ofn;
   ZeroMemory(&ofn, sizeof(ofn));
   ofn.lStructSize = sizeof(ofn);
   ofn.hwndOwner = NULL;
-  ofn.lpstrFile = buffer;
-  ofn.nMaxFile = sizeof(buffer);
+  ofn.lpstrFile = buffer.data();
+  ofn.nMaxFile = static_cast<DWORD>(buffer.size());
   ofn.lpstrFilter =
-      "All Files\0*.*\0Text Files\0*.txt\0Images\0*.jpg;*.png;*.bmp\0";
+      "Meshes\0*.obj;*.stl;*.ply;*.gltf;*.glb;*.cmesh;*.cpage\0All Files\0*.*\0";
   ofn.nFilterIndex = 1;
   ofn.Flags = OFN_EXPLORER | OFN_FILEMUSTEXIST | OFN_ALLOWMULTISELECT;
 
   if (GetOpenFileNameA(&ofn)) {
-    std::string directory = buffer;
-    char* ptr = buffer + directory.length() + 1;
+    std::string directory = buffer.data();
+    char* ptr = buffer.data() + directory.length() + 1;
 
     if (*ptr == '\0') {
       // For single file selection
@@ -43,6 +45,23 @@ std::vector<std::string> WinHelper::OpenFileDialog() {
   return fileList;
 }
 
+std::string WinHelper::OpenFolderDialog() {
+  char path[MAX_PATH] = {0};
+
+  BROWSEINFOA browseInfo;
+  ZeroMemory(&browseInfo, sizeof(browseInfo));
+  browseInfo.lpszTitle = "Import Folder";
+  browseInfo.ulFlags = BIF_RETURNONLYFSDIRS | BIF_NEWDIALOGSTYLE;
+
+  LPITEMIDLIST idList = SHBrowseForFolderA(&browseInfo);
+  if (!idList) {
+    return "";
+  }
+  bool found = SHGetPathFromIDListA(idList, path);
+  CoTaskMemFree(idList);
+  return found ? std::string(path) : "";
+}
+
 float WinHelper::DevicePixelRatio() {
   HMONITOR hMonitor = MonitorFromPoint(POINT{0, 0}, MONITOR_DEFAULTTOPRIMARY);
   UINT dpiX = 96, dpiY = 96;
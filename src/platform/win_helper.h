@@ -7,5 +7,7 @@ namespace WinHelper {
 
 float DevicePixelRatio();
 std::vector<std::string> OpenFileDialog();
+// Return "" if cancelled
+std::string OpenFolderDialog();
 
 }  // namespace WinHelper
@@ -12,21 +12,22 @@ RenderMaterialUPtr RenderMaterial::New(TexturePtr diffuse, TexturePtr specular,
 }
 
 void RenderMaterial::SetToProgram(const ShaderProgram* program) const {
+  const ShaderProgram::DrawUniforms& uniforms = program->GetDrawUniforms();
   int textureCount = 0;
   if (m_Diffuse) {
-    glActiveTexture(GL_TEXTURE0 + textureCount);
-    program->SetUniform("material.diffuse", textureCount);
-    m_Diffuse->Bind();
+    program->SetUniform(uniforms.materialDiffuse, textureCount);
+    m_Diffuse->Bind(textureCount);
     textureCount++;
   }
   if (m_Specular) {
-    glActiveTexture(GL_TEXTURE0 + textureCount);
-    program->SetUniform("material.specular", textureCount);
-    m_Specular->Bind();
+    program->SetUniform(uniforms.materialSpecular, textureCount);
+    m_Specular->Bind(textureCount);
     textureCount++;
   }
-  glActiveTexture(GL_TEXTURE0);
-  program->SetUniform("material.shininess", m_Shininess);
+  program->SetUniform(uniforms.materialShininess, m_Shininess);
+  program->SetUniform(uniforms.materialDiffuseColor, m_DiffuseColor);
+  program->SetUniform(uniforms.materialUseDiffuseTexture,
+                      m_Diffuse && m_bUseDiffuseTexture ? 1 : 0);
 }
 
 void RenderMaterial::SetDiffuse(TexturePtr diffuse) {
@@ -0,0 +1,91 @@
+#include "render_queue.h"
+
+// Standard library
+#include <algorithm>
+#include <array>
+
+static_assert(RenderQueue::PASS_BITS + RenderQueue::PROGRAM_BITS +
+                      RenderQueue::TEXTURE_SET_BITS +
+                      RenderQueue::DEPTH_BITS +
+                      RenderQueue::VERTEX_ARRAY_BITS ==
+                  64,
+              "Key fields must fill 64 bits");
+
+namespace {
+
+constexpr size_t RADIX_BITS = 8;
+constexpr size_t RADIX_SIZE = 1 << RADIX_BITS;
+constexpr size_t RADIX_PASSES = 64 / RADIX_BITS;
+
+uint64_t Field(uint32_t value, uint32_t bits) {
+  return value & ((uint64_t(1) << bits) - 1);
+}
+
+}  // namespace
+
+RenderQueueUPtr RenderQueue::New() {
+  auto queue = RenderQueueUPtr(new RenderQueue());
+  return std::move(queue);
+}
+
+uint64_t RenderQueue::MakeKey(RenderPass pass, uint32_t program,
+                              uint32_t textureSet, uint32_t vertexArray,
+                              float depth) {
+  const uint32_t maxDepth = (uint32_t(1) << DEPTH_BITS) - 1;
+  uint32_t quantizedDepth = static_cast<uint32_t>(
+      std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(maxDepth));
+  uint64_t state = (Field(program, PROGRAM_BITS) << TEXTURE_SET_BITS) |
+                   Field(textureSet, TEXTURE_SET_BITS);
+  uint64_t key = Field(static_cast<uint32_t>(pass), PASS_BITS)
+                 << (64 - PASS_BITS);
+  if (pass == RenderPass::TRANSPARENT_GEOMETRY) {
+    key |= Field(maxDepth - quantizedDepth, DEPTH_BITS)
+           << (64 - PASS_BITS - DEPTH_BITS);
+    key |= state << VERTEX_ARRAY_BITS;
+  } else {
+    key |= state << (DEPTH_BITS + VERTEX_ARRAY_BITS);
+    key |= uint64_t(quantizedDepth) << VERTEX_ARRAY_BITS;
+  }
+  key |= Field(vertexArray, VERTEX_ARRAY_BITS);
+  return key;
+}
+
+void RenderQueue::Sort() {
+  const size_t count = m_Items.size();
+  if (count < 2) return;
+
+  // Histograms of all key bytes in one pass
+  std::array<std::array<uint32_t, RADIX_SIZE>, RADIX_PASSES> histograms{};
+  for (const Item& item : m_Items) {
+    uint64_t key = item.key;
+    for (size_t pass = 0; pass < RADIX_PASSES; ++pass) {
+      ++histograms[pass][key & (RADIX_SIZE - 1)];
+      key >>= RADIX_BITS;
+    }
+  }
+
+  m_SortBuffer.resize(count);
+  Item* source = m_Items.data();
+  Item* target = m_SortBuffer.data();
+  for (size_t pass = 0; pass < RADIX_PASSES; ++pass) {
+    const size_t shift = pass * RADIX_BITS;
+    std::array<uint32_t, RADIX_SIZE>& offsets = histograms[pass];
+    if (offsets[(source[0].key >> shift) & (RADIX_SIZE - 1)] == count) {
+      continue;  // The same byte in every key
+    }
+    uint32_t offset = 0;
+    for (uint32_t& bucket : offsets) {
+      uint32_t bucketCount = bucket;
+      bucket = offset;
+      offset += bucketCount;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      const Item& item = source[i];
+      target[offsets[(item.key >> shift) & (RADIX_SIZE - 1)]++] = item;
+    }
+    std::swap(source, target);
+  }
+  if (source != m_Items.data()) {
+    m_Items.swap(m_SortBuffer);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "enum/render_enums.h"
+#include "macro/ptr_macro.h"
+
+// Standard library
+#include <cstdint>
+#include <vector>
+
+// Draw items of a frame, sorted by a packed 64-bit key before submission
+// Keys hold, from the highest bits:
+// - Opaque, overlay: Pass, program, texture set, depth, vertex array
+// - Transparent: Pass, inverted depth, program, texture set, vertex array
+// so that opaque items are grouped by program and textures and front to
+// back within a group, and transparent items are back to front. Every mesh
+// has its own vertex array, so it only breaks ties. Ids wider than their
+// field are truncated, which only weakens the grouping. Sorting is a
+// stable LSD radix sort over the key bytes, which skips the bytes that all
+// keys share.
+DECLARE_PTR(RenderQueue)
+class RenderQueue {
+ public:
+  static constexpr uint32_t PASS_BITS = 2;
+  static constexpr uint32_t PROGRAM_BITS = 8;
+  static constexpr uint32_t TEXTURE_SET_BITS = 14;
+  static constexpr uint32_t DEPTH_BITS = 24;
+  static constexpr uint32_t VERTEX_ARRAY_BITS = 16;
+
+  struct Item {
+    uint64_t key;
+    uint32_t payload;  // Index of the draw of the caller
+  };
+
+  static RenderQueueUPtr New();
+
+  // textureSet: Dense index of the textures of the frame, 0 for none
+  // depth: 0 at the near plane to 1 at the far plane, clamped
+  static uint64_t MakeKey(RenderPass pass, uint32_t program,
+                          uint32_t textureSet, uint32_t vertexArray,
+                          float depth);
+
+  void Clear() { m_Items.clear(); }
+  void Submit(uint64_t key, uint32_t payload) {
+    m_Items.push_back({key, payload});
+  }
+  void Sort();
+
+  size_t GetCount() const { return m_Items.size(); }
+  // In key order after Sort()
+  const std::vector<Item>& GetItems() const { return m_Items; }
+
+ private:
+  RenderQueue() = default;
+
+  std::vector<Item> m_Items;
+  std::vector<Item> m_SortBuffer;
+};
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "lcrs_tree.h"
 #include "font_manager.h"
 #include "custom_ui.h"
+#include "mesh_manager.h"
 #include "config/size_config.h"
 
 // ImGui
@@ -63,12 +64,73 @@ void SceneTree::renderMeshTable(ImGuiTableFlags tableFlags) {
       ImGui::PopID();
     }
 
-    // MeshManager& meshManager = MeshManager::Instance();
-    // TreeNode* rootNode = meshManager.GetMeshTree()->GetRootMutable();
-    // renderMeshTree(rootNode);
+    MeshManager& meshManager = MeshManager::Instance();
+    TreeNode* rootNode = meshManager.GetMeshTree()->GetRootMutable();
+    renderMeshTree(rootNode);
 
     ImGui::EndTable();
   }
 
-  // TODO: Handle deletion of meshes
+  // Delete after the table is rendered, so that no row refers to a deleted
+  // node.
+  if (s_DeleteMeshId >= 0) {
+    MeshManager& meshManager = MeshManager::Instance();
+    meshManager.DeleteMesh(s_DeleteMeshId);
+    if (!meshManager.GetTreeNode(s_SelectedMeshId)) {
+      s_SelectedMeshId = -1;
+    }
+    s_DeleteMeshId = -1;
+  }
+}
+
+void SceneTree::renderMeshTree(TreeNode* node) {
+  for (; node; node = node->GetRightSiblingMutable()) {
+    const int32_t id = node->GetId();
+    const bool isRoot = node->GetParent() == nullptr;
+    TreeNode* child = node->GetLeftChildMutable();
+
+    ImGui::TableNextRow();
+    ImGui::TableSetColumnIndex(0);
+    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow |
+                               ImGuiTreeNodeFlags_OpenOnDoubleClick |
+                               ImGuiTreeNodeFlags_SpanAvailWidth;
+    if (isRoot) flags |= ImGuiTreeNodeFlags_DefaultOpen;
+    if (!child) flags |= ImGuiTreeNodeFlags_Leaf;
+    if (id == s_SelectedMeshId) flags |= ImGuiTreeNodeFlags_Selected;
+    bool isOpen = ImGui::TreeNodeEx(reinterpret_cast<void*>(intptr_t(id)),
+                                    flags, "%s", node->GetLabel());
+    if (ImGui::IsItemClicked() && !ImGui::IsItemToggledOpen()) {
+      s_SelectedMeshId = id;
+    }
+
+    ImGui::TableSetColumnIndex(1);
+    ImGui::Text("%d", id);
+
+    ImGui::PushID(id);
+    ImGui::TableSetColumnIndex(2);
+    bool isVisible = node->GetIconState() != IconState::HIDDEN;
+    if (ImGui::SmallButton(isVisible ? ICON_FA6_EYE : ICON_FA6_EYE_SLASH)) {
+      setVisibility(node, !isVisible);
+    }
+    if (!isRoot) {
+      ImGui::TableSetColumnIndex(3);
+      ImGui::SmallButton(ICON_FA6_TRASH_CAN);
+      if (ImGui::IsItemHovered() &&
+          ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+        s_DeleteMeshId = id;
+      }
+    }
+    ImGui::PopID();
+
+    if (isOpen) {
+      renderMeshTree(child);
+      ImGui::TreePop();
+    }
+  }
+}
+
+void SceneTree::setVisibility(TreeNode* node, bool visible) {
+  IconState state = visible ? IconState::VISIBLE : IconState::HIDDEN;
+  MeshManager::Instance().GetMeshTree()->TraverseTreeMutable(
+      [state](TreeNode* node, void*) { node->SetIconState(state); }, node);
 }
\ No newline at end of file
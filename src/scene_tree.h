@@ -24,5 +24,7 @@ class SceneTree {
 
   // Mesh table rendering
   void renderMeshTable(ImGuiTableFlags tableFlags);
-  // static void renderMeshTree(TreeNode* node);
+  // One row per node, for the node and its right siblings
+  static void renderMeshTree(TreeNode* node);
+  static void setVisibility(TreeNode* node, bool visible);
 };
\ No newline at end of file
@@ -4,12 +4,36 @@
 #include "config/log_config.h"
 #include "config/size_config.h"
 #include "font_manager.h"
+#include "gl_state.h"
+#include "mesh_manager.h"
+#include "paged_mesh.h"
+#include "triangle_bvh.h"
+#include "util/frustum.h"
+
+// Standard library
+#include <cfloat>
+#include <chrono>
 
 // ImGui
 #include <imgui.h>
 
 #include <glm/gtc/matrix_transform.hpp>
 
+namespace {
+
+UniformBlocks::Object MakeObjectBlock(const glm::mat4& viewProjection,
+                                      const glm::mat4& modelTransform,
+                                      int32_t id) {
+  UniformBlocks::Object object;
+  object.transform = viewProjection * modelTransform;
+  object.modelTransform = modelTransform;
+  object.normalTransform = glm::transpose(glm::inverse(modelTransform));
+  object.ids = glm::ivec4(id, 0, 0, 0);
+  return object;
+}
+
+}  // namespace
+
 SceneWindow::SceneWindow() { init(); }
 
 SceneWindow::~SceneWindow() {}
@@ -27,6 +51,15 @@ void SceneWindow::init() {
                                            "resources/shader/phong_lighting.fs");
   m_LightProgram = ShaderProgram::New("resources/shader/light.vs",
                                       "resources/shader/light.fs");
+  if (m_PhongLightProgram) {
+    m_UseMaterialUniform =
+        m_PhongLightProgram->GetUniform<int>("u_useMaterial");
+  }
+  m_FrameUniforms = UniformBuffer::New(UniformBlocks::FRAME_BINDING,
+                                       sizeof(UniformBlocks::Frame));
+  m_ObjectUniforms = UniformBuffer::New(UniformBlocks::OBJECT_BINDING,
+                                        sizeof(UniformBlocks::Object));
+  m_RenderQueue = RenderQueue::New();
 }
 
 void SceneWindow::initFramebuffer() {
@@ -38,8 +71,16 @@ void SceneWindow::initFramebuffer() {
     return;
   }
 
+  std::vector<TexturePtr> colorAttachments{m_ColorTexture};
+  m_IdTexture = nullptr;
+  if (m_bIdBuffer) {
+    m_IdTexture = Texture::New(m_FramebufferWidth, m_FramebufferHeight,
+                               GL_RG32I, GL_INT);
+    colorAttachments.push_back(m_IdTexture);
+  }
+
   // Create framebuffer. The old framebuffer is deleted by losing the reference.
-  m_Framebuffer = Framebuffer::New({m_ColorTexture});
+  m_Framebuffer = Framebuffer::New(colorAttachments);
   if (!m_Framebuffer) {
     SPDLOG_ERROR("Failed to create framebuffer!");
     return;
@@ -59,14 +100,28 @@ void SceneWindow::resizeFramebuffer(int32_t width, int32_t height) {
   initFramebuffer();
 }
 
+void SceneWindow::SetIdBufferEnabled(bool enabled) {
+  if (m_bIdBuffer == enabled) return;
+  m_bIdBuffer = enabled;
+  m_IdReadback = enabled ? PixelReadback::New() : nullptr;
+  m_HoveredId = 0;
+  m_HoveredTriangle = -1;
+  if (m_Framebuffer) {
+    initFramebuffer();
+  }
+}
+
 void SceneWindow::renderMesh() {
-  glEnable(GL_DEPTH_TEST);
+  GLState& state = GLState::Instance();
+  state.SetEnabled(GL_DEPTH_TEST, true);
 
   // Projection matrix
   float aspectRatio = static_cast<float>(m_FramebufferWidth) /
                       static_cast<float>(m_FramebufferHeight);
-  glm::mat4 projection =
-      glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 100.0f);
+  const float nearPlane = 0.1f;
+  const float farPlane = 100.0f;
+  glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspectRatio,
+                                          nearPlane, farPlane);
   // glm::mat4 projection = glm::ortho(-aspectRatio, aspectRatio,  // left, right
   //                                   -1.0f, 1.0f,                // bottom, top
   //                                   0.1f, 100.0f);
@@ -85,54 +140,177 @@ void SceneWindow::renderMesh() {
   modelTransform = glm::rotate(modelTransform, glm::radians(rotationAngle),
                                glm::vec3(0.0f, 1.0f, 0.0f));
 
-  // Set uniforms for Phong lighting program
-  m_PhongLightProgram->Use();
-  m_PhongLightProgram->SetUniform("u_transform",
-                              projection * view * modelTransform);
-  m_PhongLightProgram->SetUniform("u_modelTransform", modelTransform);
-  m_PhongLightProgram->SetUniform("u_lightPosition", m_LightPosition);
-  m_PhongLightProgram->SetUniform("u_lightColor", m_LightColor);
-  m_PhongLightProgram->SetUniform("u_objectColor", m_BoxColor);
-  m_PhongLightProgram->SetUniform("u_ambientStrength", m_AmbientStrength);
-  m_PhongLightProgram->SetUniform("u_specularStrength", m_SpecularStrength);
-  m_PhongLightProgram->SetUniform("u_specularShiness", m_SpecularShiness);
-  m_PhongLightProgram->SetUniform("u_viewPosition", m_CameraPosition);
+  // Frame block, bound once for all programs
+  glm::mat4 viewProjection = projection * view;
+  UniformBlocks::Frame frame;
+  frame.projection = projection;
+  frame.view = view;
+  frame.cameraPosition = glm::vec4(m_CameraPosition, 1.0f);
+  frame.lightPosition = glm::vec4(m_LightPosition, 1.0f);
+  frame.lightColor = glm::vec4(m_LightColor, m_LightBrightness);
+  frame.lighting = glm::vec4(m_AmbientStrength, m_SpecularStrength,
+                             m_SpecularShiness, 0.0f);
+  frame.highlight = glm::ivec4(m_HoveredId, m_HoveredTriangle, 0, 0);
+  m_FrameUniforms->Set(0, frame);
+  m_FrameUniforms->Upload();
+  m_FrameUniforms->Bind();
+
+  // Visible objects are submitted to the render queue with their blocks
+  // staged, and drawn in key order once the blocks are uploaded
+  MeshManager& meshManager = MeshManager::Instance();
+  m_ObjectUniforms->Clear();
+  m_RenderQueue->Clear();
+  m_DrawItems.clear();
+  m_TextureSets.clear();
+  size_t objectCount = 0;
+  auto submit = [&](const Mesh& mesh, const ShaderProgram* program,
+                    const UniformBlocks::Object& object, bool primitiveIds) {
+    const glm::vec3& boundsMin = mesh.GetBoundsMin();
+    const glm::vec3& boundsMax = mesh.GetBoundsMax();
+    if (!Frustum::FromMatrix(object.transform)
+             .Intersects(boundsMin, boundsMax)) {
+      return;
+    }
+    // Linear view depth of the bounds center, 0 at the near plane
+    glm::vec4 clip =
+        object.transform * glm::vec4(0.5f * (boundsMin + boundsMax), 1.0f);
+    float depth = (clip.w - nearPlane) / (farPlane - nearPlane);
+    size_t index = objectCount++;
+    m_ObjectUniforms->Set(index, object);
+    m_RenderQueue->Submit(
+        RenderQueue::MakeKey(RenderPass::OPAQUE_GEOMETRY, program->Get(),
+                             getTextureSet(mesh), mesh.GetVertexArray(),
+                             depth),
+        static_cast<uint32_t>(m_DrawItems.size()));
+    m_DrawItems.push_back({&mesh, program, index, primitiveIds});
+  };
+  if (meshManager.GetMeshes().empty()) {
+    submit(*m_Box, m_PhongLightProgram.get(),
+           MakeObjectBlock(viewProjection, modelTransform, 0), false);
+  }
 
-  // Render the box mesh
-  m_Box->Draw(m_PhongLightProgram.get());
+  // Render imported meshes with their node transforms. The whole scene is
+  // fitted into the unit cube around the origin so that it is visible
+  // regardless of its original scale.
+  glm::vec3 sceneMin(FLT_MAX);
+  glm::vec3 sceneMax(-FLT_MAX);
+  meshManager.ForEachMesh([&](int32_t, const Mesh& mesh,
+                              const glm::mat4& worldTransform) {
+    const glm::vec3& boundsMin = mesh.GetBoundsMin();
+    const glm::vec3& boundsMax = mesh.GetBoundsMax();
+    for (int32_t corner = 0; corner < 8; ++corner) {
+      glm::vec3 point((corner & 1) ? boundsMax.x : boundsMin.x,
+                      (corner & 2) ? boundsMax.y : boundsMin.y,
+                      (corner & 4) ? boundsMax.z : boundsMin.z);
+      point = glm::vec3(worldTransform * glm::vec4(point, 1.0f));
+      sceneMin = glm::min(sceneMin, point);
+      sceneMax = glm::max(sceneMax, point);
+    }
+  });
+  if (sceneMin.x > sceneMax.x) {
+    sceneMin = sceneMax = glm::vec3(0.0f);
+  }
+  glm::vec3 center = 0.5f * (sceneMin + sceneMax);
+  glm::vec3 extent = sceneMax - sceneMin;
+  float maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+  float scale = maxExtent > 0.0f ? 1.0f / maxExtent : 1.0f;
+  glm::mat4 sceneTransform =
+      modelTransform * glm::scale(glm::mat4(1.0f), glm::vec3(scale)) *
+      glm::translate(glm::mat4(1.0f), -center);
+  m_Projection = projection;
+  m_View = view;
+  m_SceneTransform = sceneTransform;
+
+  PagedMesh::BeginFrame();
+  meshManager.ForEachMesh([&](int32_t id, const Mesh& mesh,
+                              const glm::mat4& worldTransform) {
+    UniformBlocks::Object object = MakeObjectBlock(
+        viewProjection, sceneTransform * worldTransform, id);
+    mesh.UpdateResidency(object.transform,
+                         static_cast<float>(m_FramebufferHeight));
+    submit(mesh, m_PhongLightProgram.get(), object, m_IdTexture != nullptr);
+  });
 
   // Light model matrix
   glm::mat4 lightModelTransform =
       glm::translate(glm::mat4(1.0), m_LightPosition) *
       glm::scale(glm::mat4(1.0), glm::vec3(m_LightSphereScale));
+  submit(*m_LightSphere, m_LightProgram.get(),
+         MakeObjectBlock(viewProjection, lightModelTransform, 0), false);
+  m_ObjectUniforms->Upload();
+  m_RenderQueue->Sort();
 
-  // Set uniforms for light program
-  m_LightProgram->Use();
-  m_LightProgram->SetUniform("u_transform",
-                              projection * view * lightModelTransform);
-  m_LightProgram->SetUniform("u_lightColor", m_LightColor);
-  m_LightProgram->SetUniform("u_brightness", m_LightBrightness);
-  m_LightSphere->Draw(m_LightProgram.get());
+  m_PhongLightProgram->Use();
+  m_PhongLightProgram->SetUniform("u_objectColor", m_BoxColor);
+  for (const RenderQueue::Item& queued : m_RenderQueue->GetItems()) {
+    const DrawItem& item = m_DrawItems[queued.payload];
+    item.program->Use();  // Redundant switches are dropped by GLState
+    m_ObjectUniforms->Bind(item.object);
+    if (item.program == m_PhongLightProgram.get()) {
+      item.program->SetUniform(m_UseMaterialUniform,
+                               item.mesh->GetMaterial() ? 1 : 0);
+    }
+    item.mesh->Draw(item.program, item.primitiveIds);
+  }
 
-  glDisable(GL_DEPTH_TEST);
+  state.SetEnabled(GL_DEPTH_TEST, false);
+}
+
+uint32_t SceneWindow::getTextureSet(const Mesh& mesh) {
+  const RenderMaterial* material = mesh.GetMaterial().get();
+  if (!material) return 0;
+  auto inserted = m_TextureSets.emplace(
+      material, static_cast<uint32_t>(m_TextureSets.size() + 1));
+  return inserted.first->second;
 }
 
 void SceneWindow::clearFramebuffer() {
   // Bind scene framebuffer
   m_Framebuffer->Bind();
 
-  glViewport(0, 0, m_FramebufferWidth, m_FramebufferHeight);
-  glClearColor(m_BgColor.at(0), m_BgColor.at(1), m_BgColor.at(2), 1.0f);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  GLState::Instance().SetViewport(0, 0, m_FramebufferWidth,
+                                  m_FramebufferHeight);
+  if (m_IdTexture) {
+    // Integer attachments are only cleared by glClearBufferiv
+    const float bgColor[4] = {m_BgColor.at(0), m_BgColor.at(1),
+                              m_BgColor.at(2), 1.0f};
+    const int32_t noId[4] = {0, 0, 0, 0};
+    glClearBufferfv(GL_COLOR, 0, bgColor);
+    glClearBufferiv(GL_COLOR, 1, noId);
+    glClear(GL_DEPTH_BUFFER_BIT);
+  } else {
+    glClearColor(m_BgColor.at(0), m_BgColor.at(1), m_BgColor.at(2), 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  }
 
+  pollHoveredId();
   renderMesh();
+  if (m_IdTexture && m_IdReadback && m_HoverX >= 0 &&
+      m_HoverX < m_FramebufferWidth && m_HoverY >= 0 &&
+      m_HoverY < m_FramebufferHeight) {
+    m_IdReadback->Request(1, m_HoverX, m_HoverY);
+  }
 
   // Bind to default framebuffer
   m_Framebuffer->BindToDefault();
 }
 
+void SceneWindow::pollHoveredId() {
+  if (!m_IdReadback) return;
+  glm::ivec4 id;
+  if (m_IdReadback->Poll(id) && m_HoverX >= 0) {
+    m_HoveredId = id.x;
+    m_HoveredTriangle = id.y - 1;
+  }
+  if (m_HoverX < 0) {
+    m_HoveredId = 0;
+    m_HoveredTriangle = -1;
+  }
+}
+
 void SceneWindow::processEvents() {
   ImGuiIO& io = ImGui::GetIO();
+  m_HoverX = m_HoverY = -1;
 
   static bool isDraggingWindow = false;
   static ImVec2 dragStartPos;
@@ -185,6 +363,14 @@ void SceneWindow::processEvents() {
       1.0f -
       2.0f * (posY / static_cast<float>(m_SceneHeight));  // Inverted Y-axis
 
+  if (ImGui::IsWindowHovered() && posX >= 0 && posX < m_SceneWidth &&
+      posY >= 0 && posY < m_SceneHeight) {
+    // Framebuffer rows run bottom-up
+    m_HoverX = posX * m_FramebufferWidth / m_SceneWidth;
+    m_HoverY =
+        m_FramebufferHeight - 1 - posY * m_FramebufferHeight / m_SceneHeight;
+  }
+
   int32_t ctrl = static_cast<int32_t>(io.KeyCtrl);
   int32_t shift = static_cast<int32_t>(io.KeyShift);
   bool dclick = io.MouseDoubleClicked[0] || io.MouseDoubleClicked[1] ||
@@ -193,6 +379,7 @@ void SceneWindow::processEvents() {
   if (ImGui::IsWindowHovered()) {
     if (io.MouseClicked[ImGuiMouseButton_Left]) {
       SPDLOG_DEBUG("Mouse position: ({}, {})", ndcX, ndcY);
+      pickMesh(ndcX, ndcY);
     } else if (io.MouseClicked[ImGuiMouseButton_Right]) {
       ImGui::SetWindowFocus();  // make right-clicks bring window into focus
     } else if (io.MouseWheel > 0) {
@@ -205,6 +392,46 @@ void SceneWindow::processEvents() {
   }
 }
 
+void SceneWindow::pickMesh(float ndcX, float ndcY) {
+  auto start = std::chrono::steady_clock::now();
+  int32_t pickedId = -1;
+  TriangleBvh::Hit picked;
+  glm::vec3 worldPosition(0.0f);
+  MeshManager::Instance().ForEachMesh([&](int32_t id, const Mesh& mesh,
+                                          const glm::mat4& worldTransform) {
+    const TriangleBvh* bvh = mesh.GetBvh();
+    if (!bvh) return;
+
+    // Ray from the near plane to the far plane in model space. Hit distances
+    // are fractions of it, so they compare across meshes.
+    glm::mat4 clipToLocal = glm::inverse(m_Projection * m_View *
+                                         m_SceneTransform * worldTransform);
+    glm::vec4 nearPoint = clipToLocal * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    glm::vec4 farPoint = clipToLocal * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+    TriangleBvh::Hit hit;
+    if (bvh->Intersect(origin, direction, hit) &&
+        (pickedId < 0 || hit.distance < picked.distance)) {
+      pickedId = id;
+      picked = hit;
+      worldPosition = glm::vec3(worldTransform * glm::vec4(hit.position, 1.0f));
+    }
+  });
+  double milliseconds = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  if (pickedId < 0) {
+    SPDLOG_DEBUG("Nothing picked ({:.3f} ms)", milliseconds);
+    return;
+  }
+  SPDLOG_INFO(
+      "Picked mesh {}, triangle {}, barycentrics ({:.3f}, {:.3f}), position "
+      "({:.4f}, {:.4f}, {:.4f}) ({:.3f} ms)",
+      pickedId, picked.triangle, picked.barycentrics.x, picked.barycentrics.y,
+      worldPosition.x, worldPosition.y, worldPosition.z, milliseconds);
+}
+
 void SceneWindow::Render(bool* openWindow) {
   // Remove padding
   ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
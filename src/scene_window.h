@@ -3,11 +3,17 @@
 #include "framebuffer.h"
 #include "macro/singleton_macro.h"
 #include "mesh.h"
+#include "pixel_readback.h"
+#include "render_queue.h"
 #include "shader_program.h"
+#include "uniform_blocks.h"
+#include "uniform_buffer.h"
 
 // Standard library
 #include <array>
 #include <cstdint>
+#include <unordered_map>
+#include <vector>
 
 class SceneWindow {
   DECLARE_SINGLETON(SceneWindow)
@@ -16,9 +22,15 @@ class SceneWindow {
   void Render(bool* openWindow = nullptr);
   void RenderBgColorPopup(bool* openWindow = nullptr);
 
+  // Render the object id and triangle of each pixel into a second color
+  // attachment and highlight what is under the cursor
+  bool IsIdBufferEnabled() const { return m_bIdBuffer; }
+  void SetIdBufferEnabled(bool enabled);
+
  private:
   FramebufferUPtr m_Framebuffer{nullptr};
   TexturePtr m_ColorTexture{nullptr};
+  TexturePtr m_IdTexture{nullptr};  // Mesh id, triangle + 1. 0 for none.
 
   // In WebAssembly, the framebuffer and scene size are the same as the canvas
   // size. In native applications, the framebuffer size can be different from
@@ -39,10 +51,40 @@ class SceneWindow {
 
   ShaderProgramUPtr m_PhongLightProgram;
   ShaderProgramUPtr m_LightProgram;
+  UniformHandle<int> m_UseMaterialUniform;  // Of m_PhongLightProgram
+  // Uniform blocks shared by the programs (see UniformBlocks)
+  UniformBufferUPtr m_FrameUniforms;
+  UniformBufferUPtr m_ObjectUniforms;  // One block per object of the frame
+
+  // Draws of the frame, submitted to m_RenderQueue by their index
+  struct DrawItem {
+    const Mesh* mesh;
+    const ShaderProgram* program;
+    size_t object;  // Block of m_ObjectUniforms
+    bool primitiveIds;
+  };
+  RenderQueueUPtr m_RenderQueue;
+  std::vector<DrawItem> m_DrawItems;
+  // Dense index of the materials of the frame from 1, for the queue keys
+  std::unordered_map<const RenderMaterial*, uint32_t> m_TextureSets;
 
   // Camera
   glm::vec3 m_CameraPosition{glm::vec3{0.0f, 0.0f, 3.0f}};
 
+  // Matrices of the last frame, for picking
+  glm::mat4 m_Projection{1.0f};
+  glm::mat4 m_View{1.0f};
+  glm::mat4 m_SceneTransform{1.0f};  // Fits the scene into the unit cube
+
+  // Hover picking through the ID buffer. The result lags the cursor by the
+  // frames the readback takes.
+  bool m_bIdBuffer{false};
+  PixelReadbackUPtr m_IdReadback;
+  int32_t m_HoverX{-1};  // Framebuffer pixel under the cursor, -1 for none
+  int32_t m_HoverY{-1};
+  int32_t m_HoveredId{0};  // Mesh id, 0 for none
+  int32_t m_HoveredTriangle{-1};
+
   // Light
   MeshUPtr m_LightSphere;  // Sphere mesh for light representation
   float m_LightSphereScale{0.1f};
@@ -57,9 +99,13 @@ class SceneWindow {
   void initFramebuffer();
   void resizeFramebuffer(int32_t width, int32_t height);
   void clearFramebuffer();
+  void pollHoveredId();
   void processEvents();
 
   void renderMesh();
+  uint32_t getTextureSet(const Mesh& mesh);
+  // Log the nearest triangle under a point of the viewport
+  void pickMesh(float ndcX, float ndcY);
 
 #ifdef __EMSCRIPTEN__
   // void saveBgColorToLocalStorage(const float* color);
@@ -2,11 +2,11 @@
 
 #include "config/gl_config.h"
 #include "config/log_config.h"
-#include "util/file_util.h"
+#include "util/file_view.h"
 
 // Standard library
-#include <fstream>
-#include <sstream>
+#include <cstring>
+#include <vector>
 
 ShaderUPtr Shader::New(const std::string& filename, GLenum shaderType) {
   auto shader = ShaderUPtr(new Shader());
@@ -23,30 +23,43 @@ Shader::~Shader() {
 }
 
 bool Shader::loadFile(const std::string& filename, GLenum shaderType) {
-  auto content = FileUtil::ReadFileToString(filename);
-  if (!content.has_value()) {
+  FileViewUPtr fileView = FileView::New(filename);
+  if (!fileView) {
     return false;
   }
 
-  auto& code = content.value();
+  // The source is passed to GL straight from the mapped file
+  std::string_view code = fileView->GetString();
+  std::vector<const GLchar*> sources;
+  std::vector<GLint> lengths;
 #ifdef __EMSCRIPTEN__
   // Convert GLSL header
   // #version 330 core -> #version 300 es\nprecision mediump float;
-  std::string version = "#version 330 core";
-  int start = code.find(version);
-  code.replace(start, version.size(),
-               "#version 300 es\nprecision highp float;\n"
-               "precision mediump int;\n"
-               "precision highp sampler2D;");  // For better quality,
-                                               // change mediump into
-                                               // highp
+  // The new header is passed as a separate source string, so the file
+  // content does not need to be copied.
+  static const char* ES_HEADER =
+      "#version 300 es\nprecision highp float;\n"
+      "precision mediump int;\n"
+      "precision highp sampler2D;";  // For better quality,
+                                     // change mediump into
+                                     // highp
+  std::string_view version = "#version 330 core";
+  size_t start = code.find(version);
+  if (start != std::string_view::npos) {
+    sources.push_back(code.data());
+    lengths.push_back(static_cast<GLint>(start));
+    sources.push_back(ES_HEADER);
+    lengths.push_back(static_cast<GLint>(std::strlen(ES_HEADER)));
+    code.remove_prefix(start + version.size());
+  }
 #endif
-  const char* codePtr = code.c_str();
-  int32_t codeLength = (int32_t)code.length();
+  sources.push_back(code.data());
+  lengths.push_back(static_cast<GLint>(code.size()));
 
   // Create and compile shader
   m_Shader = glCreateShader(shaderType);
-  glShaderSource(m_Shader, 1, (const GLchar* const*)&codePtr, &codeLength);
+  glShaderSource(m_Shader, static_cast<GLsizei>(sources.size()),
+                 sources.data(), lengths.data());
   glCompileShader(m_Shader);
 
   // Check compile error
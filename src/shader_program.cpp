@@ -1,6 +1,61 @@
 #include "shader_program.h"
 
 #include "config/log_config.h"
+#include "gl_state.h"
+#include "uniform_blocks.h"
+
+// Standard library
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// GL type of a uniform that values of T set
+template <typename T>
+struct UniformType;
+template <>
+struct UniformType<int> {
+  static constexpr GLenum VALUE = GL_INT;
+};
+template <>
+struct UniformType<float> {
+  static constexpr GLenum VALUE = GL_FLOAT;
+};
+template <>
+struct UniformType<glm::vec2> {
+  static constexpr GLenum VALUE = GL_FLOAT_VEC2;
+};
+template <>
+struct UniformType<glm::vec3> {
+  static constexpr GLenum VALUE = GL_FLOAT_VEC3;
+};
+template <>
+struct UniformType<glm::vec4> {
+  static constexpr GLenum VALUE = GL_FLOAT_VEC4;
+};
+template <>
+struct UniformType<glm::mat4> {
+  static constexpr GLenum VALUE = GL_FLOAT_MAT4;
+};
+
+bool IsIntUniform(GLenum type) {
+  switch (type) {
+    case GL_INT:
+    case GL_BOOL:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
 
 ShaderProgramUPtr ShaderProgram::New(const std::vector<ShaderPtr>& shaders) {
   auto program = ShaderProgramUPtr(new ShaderProgram());
@@ -21,7 +76,10 @@ ShaderProgramUPtr ShaderProgram::New(const std::string& vertShaderFilename,
 }
 
 ShaderProgram::~ShaderProgram() {
-  if (m_Program) glDeleteProgram(m_Program);
+  if (m_Program) {
+    GLState::Instance().OnDeleteProgram(m_Program);
+    glDeleteProgram(m_Program);
+  }
 }
 
 bool ShaderProgram::link(const std::vector<ShaderPtr>& shaders) {
@@ -40,41 +98,205 @@ bool ShaderProgram::link(const std::vector<ShaderPtr>& shaders) {
     return false;
   }
 
+  reflectUniforms();
+  resolveDrawUniforms();
+  bindUniformBlocks();
   return true;
 }
 
-void ShaderProgram::Use() const { glUseProgram(m_Program); }
+void ShaderProgram::bindUniformBlocks() const {
+  int32_t blockCount = 0;
+  int32_t maxNameLength = 0;
+  glGetProgramiv(m_Program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+  glGetProgramiv(m_Program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH,
+                 &maxNameLength);
+  std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+  for (int32_t i = 0; i < blockCount; ++i) {
+    GLuint blockIndex = static_cast<GLuint>(i);
+    GLsizei nameLength = 0;
+    glGetActiveUniformBlockName(m_Program, blockIndex,
+                                static_cast<GLsizei>(nameBuffer.size()),
+                                &nameLength, nameBuffer.data());
+    std::string_view name(nameBuffer.data(), nameLength);
+    uint32_t binding = 0;
+    size_t size = 0;
+    if (!UniformBlocks::Find(name, binding, size)) {
+      SPDLOG_WARN("Unknown uniform block: {}", name);
+      continue;
+    }
+    int32_t dataSize = 0;
+    glGetActiveUniformBlockiv(m_Program, blockIndex,
+                              GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+    if (static_cast<size_t>(dataSize) > size) {
+      SPDLOG_ERROR("Uniform block {} is larger than its struct ({} > {})",
+                   name, dataSize, size);
+      continue;
+    }
+    glUniformBlockBinding(m_Program, blockIndex, binding);
+  }
+}
+
+void ShaderProgram::reflectUniforms() {
+  int32_t uniformCount = 0;
+  int32_t maxNameLength = 0;
+  glGetProgramiv(m_Program, GL_ACTIVE_UNIFORMS, &uniformCount);
+  glGetProgramiv(m_Program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+  std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+  for (int32_t i = 0; i < uniformCount; ++i) {
+    GLsizei nameLength = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(m_Program, static_cast<GLuint>(i),
+                       static_cast<GLsizei>(nameBuffer.size()), &nameLength,
+                       &size, &type, nameBuffer.data());
+    Uniform uniform;
+    uniform.name.assign(nameBuffer.data(), nameLength);
+    uniform.location = glGetUniformLocation(m_Program, uniform.name.c_str());
+    if (uniform.location < 0) continue;  // In a uniform block
+    if (uniform.name.size() > 3 &&
+        uniform.name.compare(uniform.name.size() - 3, 3, "[0]") == 0) {
+      uniform.name.resize(uniform.name.size() - 3);
+    }
+    uniform.type = type;
+    m_Uniforms.push_back(std::move(uniform));
+  }
+  std::sort(m_Uniforms.begin(), m_Uniforms.end(),
+            [](const Uniform& a, const Uniform& b) { return a.name < b.name; });
+}
+
+void ShaderProgram::resolveDrawUniforms() {
+  DrawUniforms& uniforms = m_DrawUniforms;
+  uniforms.positionOffset = GetUniform<glm::vec3>("u_positionOffset");
+  uniforms.positionScale = GetUniform<glm::vec3>("u_positionScale");
+  uniforms.octahedralNormal = GetUniform<int>("u_octahedralNormal");
+  uniforms.primitiveBase = GetUniform<int>("u_primitiveBase");
+  uniforms.materialDiffuse = GetUniform<int>("material.diffuse");
+  uniforms.materialSpecular = GetUniform<int>("material.specular");
+  uniforms.materialShininess = GetUniform<float>("material.shininess");
+  uniforms.materialDiffuseColor =
+      GetUniform<glm::vec3>("material.diffuseColor");
+  uniforms.materialUseDiffuseTexture =
+      GetUniform<int>("material.useDiffuseTexture");
+}
+
+int32_t ShaderProgram::findUniform(std::string_view name) const {
+  auto it = std::lower_bound(
+      m_Uniforms.begin(), m_Uniforms.end(), name,
+      [](const Uniform& uniform, std::string_view key) {
+        return std::string_view(uniform.name) < key;
+      });
+  if (it == m_Uniforms.end() || it->name != name) return -1;
+  return static_cast<int32_t>(it - m_Uniforms.begin());
+}
+
+template <typename T>
+UniformHandle<T> ShaderProgram::GetUniform(std::string_view name) const {
+  int32_t index = findUniform(name);
+  if (index < 0) return UniformHandle<T>();
+  Uniform& uniform = m_Uniforms[index];
+  if (uniform.type != UniformType<T>::VALUE &&
+      !(UniformType<T>::VALUE == GL_INT && IsIntUniform(uniform.type))) {
+    // Name-based setters resolve on every call
+    if (!uniform.typeWarned) {
+      SPDLOG_WARN("Uniform {} cannot be set with this type", name);
+      uniform.typeWarned = true;
+    }
+    return UniformHandle<T>();
+  }
+  return UniformHandle<T>(index);
+}
+
+template UniformHandle<int> ShaderProgram::GetUniform(std::string_view) const;
+template UniformHandle<float> ShaderProgram::GetUniform(
+    std::string_view) const;
+template UniformHandle<glm::vec2> ShaderProgram::GetUniform(
+    std::string_view) const;
+template UniformHandle<glm::vec3> ShaderProgram::GetUniform(
+    std::string_view) const;
+template UniformHandle<glm::vec4> ShaderProgram::GetUniform(
+    std::string_view) const;
+template UniformHandle<glm::mat4> ShaderProgram::GetUniform(
+    std::string_view) const;
+
+template <typename T>
+bool ShaderProgram::changeValue(int32_t index, const T& value) const {
+  static_assert(sizeof(T) <= sizeof(Uniform::value), "Uniform too large");
+  Uniform& uniform = m_Uniforms[index];
+  if (uniform.hasValue &&
+      std::memcmp(uniform.value.data(), &value, sizeof(T)) == 0) {
+    return false;
+  }
+  std::memcpy(uniform.value.data(), &value, sizeof(T));
+  uniform.hasValue = true;
+  return true;
+}
+
+void ShaderProgram::Use() const { GLState::Instance().UseProgram(m_Program); }
+
+void ShaderProgram::SetUniform(UniformHandle<int> handle, int value) const {
+  if (!handle.IsValid() || !changeValue(handle.m_Index, value)) return;
+  glUniform1i(m_Uniforms[handle.m_Index].location, value);
+}
+
+void ShaderProgram::SetUniform(UniformHandle<float> handle,
+                               float value) const {
+  if (!handle.IsValid() || !changeValue(handle.m_Index, value)) return;
+  glUniform1f(m_Uniforms[handle.m_Index].location, value);
+}
+
+void ShaderProgram::SetUniform(UniformHandle<glm::vec2> handle,
+                               const glm::vec2& value) const {
+  if (!handle.IsValid() || !changeValue(handle.m_Index, value)) return;
+  glUniform2fv(m_Uniforms[handle.m_Index].location, 1,
+               glm::value_ptr(value));
+}
+
+void ShaderProgram::SetUniform(UniformHandle<glm::vec3> handle,
+                               const glm::vec3& value) const {
+  if (!handle.IsValid() || !changeValue(handle.m_Index, value)) return;
+  glUniform3fv(m_Uniforms[handle.m_Index].location, 1,
+               glm::value_ptr(value));
+}
+
+void ShaderProgram::SetUniform(UniformHandle<glm::vec4> handle,
+                               const glm::vec4& value) const {
+  if (!handle.IsValid() || !changeValue(handle.m_Index, value)) return;
+  glUniform4fv(m_Uniforms[handle.m_Index].location, 1,
+               glm::value_ptr(value));
+}
+
+void ShaderProgram::SetUniform(UniformHandle<glm::mat4> handle,
+                               const glm::mat4& value) const {
+  if (!handle.IsValid() || !changeValue(handle.m_Index, value)) return;
+  glUniformMatrix4fv(m_Uniforms[handle.m_Index].location, 1, GL_FALSE,
+                     glm::value_ptr(value));
+}
 
-void ShaderProgram::SetUniform(const std::string& name, int value) const {
-  auto loc = glGetUniformLocation(m_Program, name.c_str());
-  glUniform1i(loc, value);
+// Type checked like handles, so a value GL rejects is never recorded
+void ShaderProgram::SetUniform(std::string_view name, int value) const {
+  SetUniform(GetUniform<int>(name), value);
 }
 
-void ShaderProgram::SetUniform(const std::string& name, float value) const {
-  auto loc = glGetUniformLocation(m_Program, name.c_str());
-  glUniform1f(loc, value);
+void ShaderProgram::SetUniform(std::string_view name, float value) const {
+  SetUniform(GetUniform<float>(name), value);
 }
 
-void ShaderProgram::SetUniform(const std::string& name,
+void ShaderProgram::SetUniform(std::string_view name,
                                const glm::vec2& value) const {
-  auto loc = glGetUniformLocation(m_Program, name.c_str());
-  glUniform2fv(loc, 1, glm::value_ptr(value));
+  SetUniform(GetUniform<glm::vec2>(name), value);
 }
 
-void ShaderProgram::SetUniform(const std::string& name,
+void ShaderProgram::SetUniform(std::string_view name,
                                const glm::vec3& value) const {
-  auto loc = glGetUniformLocation(m_Program, name.c_str());
-  glUniform3fv(loc, 1, glm::value_ptr(value));
+  SetUniform(GetUniform<glm::vec3>(name), value);
 }
 
-void ShaderProgram::SetUniform(const std::string& name,
+void ShaderProgram::SetUniform(std::string_view name,
                                const glm::vec4& value) const {
-  auto loc = glGetUniformLocation(m_Program, name.c_str());
-  glUniform4fv(loc, 1, glm::value_ptr(value));
+  SetUniform(GetUniform<glm::vec4>(name), value);
 }
 
-void ShaderProgram::SetUniform(const std::string& name,
+void ShaderProgram::SetUniform(std::string_view name,
                                const glm::mat4& value) const {
-  auto loc = glGetUniformLocation(m_Program, name.c_str());
-  glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(value));
+  SetUniform(GetUniform<glm::mat4>(name), value);
 }
\ No newline at end of file
@@ -4,12 +4,32 @@
 #include "shader.h"
 
 // Standard library
+#include <array>
+#include <string>
+#include <string_view>
 #include <vector>
 
 // glm
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// Uniform of a program resolved once by name (see ShaderProgram::GetUniform)
+// T is the type of the value. Setting an invalid handle does nothing.
+template <typename T>
+class UniformHandle {
+ public:
+  UniformHandle() = default;
+
+  bool IsValid() const { return m_Index >= 0; }
+
+ private:
+  friend class ShaderProgram;
+
+  explicit UniformHandle(int32_t index) : m_Index(index) {}
+
+  int32_t m_Index{-1};  // Into the uniform table of the program
+};
+
 DECLARE_PTR(ShaderProgram)
 class ShaderProgram {
  public:
@@ -22,18 +42,75 @@ class ShaderProgram {
   uint32_t Get() const { return m_Program; }
   void Use() const;
 
-  void SetUniform(const std::string& name, int value) const;
-  void SetUniform(const std::string& name, float value) const;
-  void SetUniform(const std::string& name, const glm::vec2& value) const;
-  void SetUniform(const std::string& name, const glm::vec3& value) const;
-  void SetUniform(const std::string& name, const glm::vec4& value) const;
-  void SetUniform(const std::string& name, const glm::mat4& value) const;
+  // The active uniforms are listed at link time into a table sorted by
+  // name, and the last value set to each is kept. Setting an unchanged
+  // value makes no GL call. The program must be in use when setting.
+
+  // Resolve a uniform for repeated setting, on this program only. The
+  // handle is invalid if there is no active uniform of the name, or T
+  // cannot set its type.
+  template <typename T>
+  UniformHandle<T> GetUniform(std::string_view name) const;
+
+  void SetUniform(UniformHandle<int> handle, int value) const;
+  void SetUniform(UniformHandle<float> handle, float value) const;
+  void SetUniform(UniformHandle<glm::vec2> handle,
+                  const glm::vec2& value) const;
+  void SetUniform(UniformHandle<glm::vec3> handle,
+                  const glm::vec3& value) const;
+  void SetUniform(UniformHandle<glm::vec4> handle,
+                  const glm::vec4& value) const;
+  void SetUniform(UniformHandle<glm::mat4> handle,
+                  const glm::mat4& value) const;
+
+  // By name, with a binary search of the table. Inactive names and names
+  // of another type are ignored, as with GetUniform.
+  void SetUniform(std::string_view name, int value) const;
+  void SetUniform(std::string_view name, float value) const;
+  void SetUniform(std::string_view name, const glm::vec2& value) const;
+  void SetUniform(std::string_view name, const glm::vec3& value) const;
+  void SetUniform(std::string_view name, const glm::vec4& value) const;
+  void SetUniform(std::string_view name, const glm::mat4& value) const;
+
+  // Uniforms set for every draw, resolved at link time
+  struct DrawUniforms {
+    UniformHandle<glm::vec3> positionOffset;
+    UniformHandle<glm::vec3> positionScale;
+    UniformHandle<int> octahedralNormal;
+    UniformHandle<int> primitiveBase;
+    UniformHandle<int> materialDiffuse;
+    UniformHandle<int> materialSpecular;
+    UniformHandle<float> materialShininess;
+    UniformHandle<glm::vec3> materialDiffuseColor;
+    UniformHandle<int> materialUseDiffuseTexture;
+  };
+  const DrawUniforms& GetDrawUniforms() const { return m_DrawUniforms; }
 
  private:
   // Constructor
   ShaderProgram() = default;
 
+  struct Uniform {
+    std::string name;  // Arrays without "[0]", set from their first element
+    int32_t location{-1};
+    uint32_t type{0};
+    bool hasValue{false};
+    bool typeWarned{false};  // A mismatched type was reported once
+    std::array<uint32_t, 16> value{};  // Bits of the last value set
+  };
+
   bool link(const std::vector<ShaderPtr>& shaders);
+  void reflectUniforms();
+  void resolveDrawUniforms();
+  // Bind the blocks to their points in UniformBlocks
+  void bindUniformBlocks() const;
+  int32_t findUniform(std::string_view name) const;
+  // Store value as the last one of a uniform. Return false if unchanged.
+  template <typename T>
+  bool changeValue(int32_t index, const T& value) const;
 
   uint32_t m_Program{0};
+  // Sorted by name. Uniforms of blocks have no location and are left out.
+  mutable std::vector<Uniform> m_Uniforms;
+  DrawUniforms m_DrawUniforms;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "texture.h"
 
 #include "config/log_config.h"
+#include "gl_state.h"
 #include "image.h"
 
 TextureUPtr Texture::New(const Image* image) {
@@ -23,11 +24,14 @@ Texture::Texture() {}
 
 Texture::~Texture() {
   if (m_Texture) {
+    GLState::Instance().OnDeleteTexture(m_Texture);
     glDeleteTextures(1, &m_Texture);
   }
 }
 
-void Texture::Bind() const { glBindTexture(GL_TEXTURE_2D, m_Texture); }
+void Texture::Bind(uint32_t unit) const {
+  GLState::Instance().BindTexture(unit, m_Texture);
+}
 
 void Texture::setFilter(uint32_t minFilter, uint32_t magFilter) const {
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
@@ -43,7 +47,7 @@ void Texture::setWrap(uint32_t sWrap, uint32_t tWrap) const {
 
 void Texture::createTexture() {
   glGenTextures(1, &m_Texture);
-  Bind();
+  GLState::Instance().SelectTexture(m_Texture);  // For the glTex* calls
   setFilter(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);  // Set default filter
   setWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
 }
@@ -143,6 +147,10 @@ static GLenum GetImageFormat(uint32_t internalFormat) {
   } else if (internalFormat == GL_RED || internalFormat == GL_R8 ||
              internalFormat == GL_R16F || internalFormat == GL_R32F) {
     imageFormat = GL_RED;
+  } else if (internalFormat == GL_RG32I || internalFormat == GL_RG32UI) {
+    imageFormat = GL_RG_INTEGER;
+  } else if (internalFormat == GL_R32I || internalFormat == GL_R32UI) {
+    imageFormat = GL_RED_INTEGER;
   }
 
   return imageFormat;
@@ -28,7 +28,8 @@ class Texture {
   uint32_t GetFormat() const { return m_Format; }
   uint32_t GetType() const { return m_Type; }
 
-  void Bind() const;
+  // Bind for drawing. The unit is not made active if already bound.
+  void Bind(uint32_t unit = 0) const;
 
  private:
   Texture();
@@ -0,0 +1,111 @@
+#include "thread_pool.h"
+
+#include "config/log_config.h"
+
+// Standard library
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool() {
+  uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+#ifdef __EMSCRIPTEN__
+  // Workers are taken from the pthread pool (-sPTHREAD_POOL_SIZE=5).
+  // Creating more threads than the pool holds would block the main thread.
+  threadCount = std::min(threadCount, 4u);
+#endif
+
+  m_Workers.reserve(threadCount);
+  for (uint32_t i = 0; i < threadCount; ++i) {
+    m_Workers.emplace_back(&ThreadPool::workerLoop, this);
+  }
+  SPDLOG_DEBUG("Thread pool started with {} workers", threadCount);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_bStop = true;
+  }
+  m_Condition.notify_all();
+  for (auto& worker : m_Workers) {
+    if (worker.joinable()) worker.join();
+  }
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> task) {
+  auto packagedTask =
+      std::make_shared<std::packaged_task<void()>>(std::move(task));
+  std::future<void> future = packagedTask->get_future();
+  enqueue([packagedTask]() { (*packagedTask)(); });
+  return future;
+}
+
+void ThreadPool::ParallelFor(
+    size_t count, size_t grainSize,
+    const std::function<void(size_t begin, size_t end)>& func) {
+  if (count == 0) return;
+
+  grainSize = std::max<size_t>(grainSize, 1);
+  size_t rangeCount = (count + grainSize - 1) / grainSize;
+  if (rangeCount == 1 || m_Workers.empty()) {
+    func(0, count);
+    return;
+  }
+
+  struct State {
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex mutex;
+    std::condition_variable condition;
+  };
+  auto state = std::make_shared<State>();
+
+  // A helper that starts after all ranges are taken returns without touching
+  // func, so func may go out of scope once the ranges are done.
+  auto run = [state, &func, count, grainSize, rangeCount]() {
+    size_t range;
+    while ((range = state->next.fetch_add(1)) < rangeCount) {
+      size_t begin = range * grainSize;
+      size_t end = std::min(begin + grainSize, count);
+      func(begin, end);
+      if (state->done.fetch_add(1) + 1 == rangeCount) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->condition.notify_all();
+      }
+    }
+  };
+
+  size_t helperCount = std::min(m_Workers.size(), rangeCount - 1);
+  for (size_t i = 0; i < helperCount; ++i) {
+    enqueue(run);
+  }
+  run();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->condition.wait(lock,
+                        [&state, rangeCount]() {
+                          return state->done.load() == rangeCount;
+                        });
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Tasks.push(std::move(task));
+  }
+  m_Condition.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_Mutex);
+      m_Condition.wait(lock, [this]() { return m_bStop || !m_Tasks.empty(); });
+      if (m_bStop && m_Tasks.empty()) return;
+      task = std::move(m_Tasks.front());
+      m_Tasks.pop();
+    }
+    task();
+  }
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "macro/singleton_macro.h"
+
+// Standard library
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Worker thread pool shared by all CPU-heavy work
+// - Submit(): Run a task on a worker thread.
+// - ParallelFor(): Split [0, count) into ranges of grainSize and run them on
+//   the workers. The calling thread works on the ranges too and only waits
+//   for the ranges already taken by workers, so ParallelFor() can be called
+//   from inside a submitted task without deadlock.
+class ThreadPool {
+  DECLARE_SINGLETON(ThreadPool)
+
+ public:
+  size_t GetThreadCount() const { return m_Workers.size(); }
+
+  std::future<void> Submit(std::function<void()> task);
+
+  void ParallelFor(size_t count, size_t grainSize,
+                   const std::function<void(size_t begin, size_t end)>& func);
+
+ private:
+  std::vector<std::thread> m_Workers;
+  std::queue<std::function<void()>> m_Tasks;
+  std::mutex m_Mutex;
+  std::condition_variable m_Condition;
+  bool m_bStop{false};
+
+  void enqueue(std::function<void()> task);
+  void workerLoop();
+};
\ No newline at end of file
@@ -0,0 +1,391 @@
+#include "triangle_bvh.h"
+
+#include "thread_pool.h"
+
+// Standard library
+#include <algorithm>
+#include <cfloat>
+
+namespace {
+
+struct Bounds {
+  glm::vec3 min{FLT_MAX};
+  glm::vec3 max{-FLT_MAX};
+
+  void Grow(const glm::vec3& point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+  void Grow(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    min = glm::min(min, boxMin);
+    max = glm::max(max, boxMax);
+  }
+  void Grow(const Bounds& other) { Grow(other.min, other.max); }
+  float GetArea() const {
+    glm::vec3 extent = max - min;
+    if (extent.x < 0.0f) return 0.0f;
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+  }
+};
+
+// Build record, partitioned in place so that binning reads memory in order
+struct Primitive {
+  glm::vec3 boundsMin;
+  uint32_t triangle;
+  glm::vec3 boundsMax;
+
+  glm::vec3 GetCentroid() const { return 0.5f * (boundsMin + boundsMax); }
+};
+
+struct Range {
+  uint32_t node;
+  uint32_t first;
+  uint32_t count;
+};
+
+class Builder {
+ public:
+  explicit Builder(std::vector<Primitive>& primitives)
+      : m_Primitives(primitives) {}
+
+  Bounds GetBounds(uint32_t first, uint32_t count) const {
+    Bounds bounds;
+    for (uint32_t i = first; i < first + count; ++i) {
+      bounds.Grow(m_Primitives[i].boundsMin, m_Primitives[i].boundsMax);
+    }
+    return bounds;
+  }
+
+  // Partition a range at the bin boundary with the lowest SAH cost. Return
+  // false for a leaf.
+  bool Split(uint32_t first, uint32_t count, uint32_t& mid) {
+    if (count <= TriangleBvh::MAX_LEAF_SIZE) return false;
+
+    Bounds centroidBounds;
+    for (uint32_t i = first; i < first + count; ++i) {
+      centroidBounds.Grow(m_Primitives[i].GetCentroid());
+    }
+    glm::vec3 lower = centroidBounds.min;
+    glm::vec3 extent = centroidBounds.max - lower;
+    glm::vec3 scale(0.0f);
+    for (int axis = 0; axis < 3; ++axis) {
+      if (extent[axis] > 0.0f) {
+        scale[axis] = TriangleBvh::BIN_COUNT / extent[axis];
+      }
+    }
+
+    // All three axes binned in one pass
+    Bounds binBounds[3][TriangleBvh::BIN_COUNT];
+    uint32_t binCounts[3][TriangleBvh::BIN_COUNT] = {};
+    for (uint32_t i = first; i < first + count; ++i) {
+      const Primitive& primitive = m_Primitives[i];
+      glm::vec3 centroid = primitive.GetCentroid();
+      for (int axis = 0; axis < 3; ++axis) {
+        size_t bin = getBin(centroid[axis], lower[axis], scale[axis]);
+        ++binCounts[axis][bin];
+        binBounds[axis][bin].Grow(primitive.boundsMin, primitive.boundsMax);
+      }
+    }
+
+    int bestAxis = -1;
+    size_t bestBin = 0;
+    float bestCost = FLT_MAX;
+    for (int axis = 0; axis < 3; ++axis) {
+      if (scale[axis] == 0.0f) continue;
+      // Costs of splitting after each bin, swept from both sides
+      float leftCosts[TriangleBvh::BIN_COUNT - 1];
+      Bounds left;
+      uint32_t leftCount = 0;
+      for (size_t i = 0; i + 1 < TriangleBvh::BIN_COUNT; ++i) {
+        left.Grow(binBounds[axis][i]);
+        leftCount += binCounts[axis][i];
+        leftCosts[i] = left.GetArea() * leftCount;
+      }
+      Bounds right;
+      uint32_t rightCount = 0;
+      for (size_t i = TriangleBvh::BIN_COUNT - 1; i > 0; --i) {
+        right.Grow(binBounds[axis][i]);
+        rightCount += binCounts[axis][i];
+        float cost = leftCosts[i - 1] + right.GetArea() * rightCount;
+        if (rightCount > 0 && rightCount < count && cost < bestCost) {
+          bestAxis = axis;
+          bestBin = i;
+          bestCost = cost;
+        }
+      }
+    }
+
+    if (bestAxis < 0) {
+      // All centroids coincide
+      mid = first + count / 2;
+      return true;
+    }
+
+    Primitive* begin = m_Primitives.data() + first;
+    Primitive* split =
+        std::partition(begin, begin + count, [&](const Primitive& primitive) {
+          return getBin(primitive.GetCentroid()[bestAxis], lower[bestAxis],
+                        scale[bestAxis]) < bestBin;
+        });
+    mid = first + static_cast<uint32_t>(split - begin);
+    return true;
+  }
+
+ private:
+  std::vector<Primitive>& m_Primitives;
+
+  static size_t getBin(float value, float lower, float scale) {
+    size_t bin = static_cast<size_t>((value - lower) * scale);
+    return std::min(bin, TriangleBvh::BIN_COUNT - 1);
+  }
+};
+
+// Ray parameter where the ray enters the box, or FLT_MAX if it misses it
+// within maxDistance
+float IntersectBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                   const glm::vec3& origin, const glm::vec3& inverseDirection,
+                   float maxDistance) {
+  glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+  glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+  glm::vec3 near = glm::min(t0, t1);
+  glm::vec3 far = glm::max(t0, t1);
+  float enter = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+  float exit = std::min(std::min(far.x, far.y), std::min(far.z, maxDistance));
+  return enter <= exit ? enter : FLT_MAX;
+}
+
+}  // namespace
+
+TriangleBvhUPtr TriangleBvh::New(
+    std::shared_ptr<const std::vector<glm::vec3>> positions,
+    std::shared_ptr<const std::vector<uint32_t>> indices) {
+  auto bvh = TriangleBvhUPtr(new TriangleBvh());
+  if (!positions || !indices || positions->empty() || indices->size() < 3) {
+    return nullptr;
+  }
+
+  auto data = std::make_shared<Data>();
+  data->positions = std::move(positions);
+  data->indices = std::move(indices);
+  data->triangleCount = static_cast<uint32_t>(data->indices->size() / 3);
+  bvh->m_Data = data;
+  ThreadPool::Instance().Submit([data]() { TriangleBvh::build(*data); });
+  return std::move(bvh);
+}
+
+TriangleBvh::~TriangleBvh() {
+  if (m_Data) {
+    m_Data->cancelled = true;
+  }
+}
+
+bool TriangleBvh::IsReady() const {
+  return m_Data->ready.load(std::memory_order_acquire);
+}
+
+size_t TriangleBvh::GetNodeCount() const {
+  return IsReady() ? m_Data->nodes.size() : 0;
+}
+
+void TriangleBvh::build(Data& data) {
+  const uint32_t triangleCount = data.triangleCount;
+  const std::vector<glm::vec3>& positions = *data.positions;
+  const std::vector<uint32_t>& indices = *data.indices;
+  std::vector<Primitive> primitives(triangleCount);
+  ThreadPool::Instance().ParallelFor(
+      triangleCount, 64 * 1024, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const uint32_t* triangle = &indices[i * 3];
+          Bounds bounds;
+          for (int j = 0; j < 3; ++j) {
+            bounds.Grow(positions[triangle[j]]);
+          }
+          primitives[i] = {bounds.min, static_cast<uint32_t>(i), bounds.max};
+        }
+      });
+  Builder builder(primitives);
+
+  // Split ranges into child pairs until they are small enough for a
+  // subtree. Leaves are finished.
+  auto splitRanges = [&builder](std::vector<Node>& nodes,
+                                std::vector<Range>& ranges,
+                                uint32_t subtreeSize,
+                                std::vector<Range>* subtrees) {
+    while (!ranges.empty()) {
+      Range range = ranges.back();
+      ranges.pop_back();
+      if (subtrees && range.count <= subtreeSize) {
+        subtrees->push_back(range);
+        continue;
+      }
+      uint32_t mid = 0;
+      if (!builder.Split(range.first, range.count, mid)) continue;
+      uint32_t left = static_cast<uint32_t>(nodes.size());
+      for (auto [first, count] : {std::pair(range.first, mid - range.first),
+                                  std::pair(mid, range.first + range.count -
+                                                     mid)}) {
+        Bounds bounds = builder.GetBounds(first, count);
+        nodes.push_back({bounds.min, first, bounds.max, count});
+      }
+      nodes[range.node].leftFirst = left;
+      nodes[range.node].count = 0;
+      ranges.push_back({left + 1, mid, range.first + range.count - mid});
+      ranges.push_back({left, range.first, mid - range.first});
+    }
+  };
+
+  Bounds rootBounds = builder.GetBounds(0, triangleCount);
+  std::vector<Node> nodes;
+  nodes.reserve(triangleCount / MAX_LEAF_SIZE * 2 + 1);
+  nodes.push_back({rootBounds.min, 0, rootBounds.max, triangleCount});
+  std::vector<Range> ranges{{0, 0, triangleCount}};
+  std::vector<Range> subtrees;
+  uint32_t subtreeSize = std::max<uint32_t>(
+      triangleCount / SUBTREE_COUNT, static_cast<uint32_t>(MAX_LEAF_SIZE));
+  splitRanges(nodes, ranges, subtreeSize, &subtrees);
+
+  // Subtrees are built with local node indices, 0 being the subtree root
+  std::vector<std::vector<Node>> subtreeNodes(subtrees.size());
+  ThreadPool::Instance().ParallelFor(
+      subtrees.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end && !data.cancelled; ++i) {
+          std::vector<Node>& local = subtreeNodes[i];
+          local.push_back(nodes[subtrees[i].node]);
+          std::vector<Range> localRanges{
+              {0, subtrees[i].first, subtrees[i].count}};
+          splitRanges(local, localRanges, 0, nullptr);
+        }
+      });
+  if (data.cancelled) return;
+
+  for (size_t i = 0; i < subtrees.size(); ++i) {
+    // Local node k > 0 moves to base + k - 1
+    const uint32_t base = static_cast<uint32_t>(nodes.size());
+    std::vector<Node>& local = subtreeNodes[i];
+    for (Node& node : local) {
+      if (node.count == 0) {
+        node.leftFirst += base - 1;
+      }
+    }
+    nodes[subtrees[i].node] = local.front();
+    nodes.insert(nodes.end(), local.begin() + 1, local.end());
+    std::vector<Node>().swap(local);
+  }
+
+  data.triangleIds.resize(triangleCount);
+  for (uint32_t i = 0; i < triangleCount; ++i) {
+    data.triangleIds[i] = primitives[i].triangle;
+  }
+  nodes.shrink_to_fit();
+  data.nodes = std::move(nodes);
+  data.ready.store(true, std::memory_order_release);
+}
+
+bool TriangleBvh::Intersect(const glm::vec3& origin,
+                            const glm::vec3& direction, Hit& hit) const {
+  if (!IsReady()) return false;
+  const std::vector<Node>& nodes = m_Data->nodes;
+  const std::vector<glm::vec3>& positions = *m_Data->positions;
+  const std::vector<uint32_t>& indices = *m_Data->indices;
+  const std::vector<uint32_t>& triangleIds = m_Data->triangleIds;
+
+  const glm::vec3 inverseDirection = glm::vec3(1.0f) / direction;
+  float nearest = FLT_MAX;
+  bool found = false;
+  if (IntersectBox(nodes[0].boundsMin, nodes[0].boundsMax, origin,
+                   inverseDirection, nearest) == FLT_MAX) {
+    return false;
+  }
+  // SAH trees are not balanced, so the depth is not bounded
+  std::vector<uint32_t> stack;
+  stack.reserve(STACK_SIZE);
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const Node& node = nodes[stack.back()];
+    stack.pop_back();
+    if (node.count > 0) {
+      // Moller-Trumbore, both faces
+      for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; ++i) {
+        uint32_t triangle = triangleIds[i];
+        const glm::vec3& p0 = positions[indices[triangle * 3]];
+        glm::vec3 edge1 = positions[indices[triangle * 3 + 1]] - p0;
+        glm::vec3 edge2 = positions[indices[triangle * 3 + 2]] - p0;
+        glm::vec3 p = glm::cross(direction, edge2);
+        float determinant = glm::dot(edge1, p);
+        if (determinant == 0.0f) continue;
+        float inverseDeterminant = 1.0f / determinant;
+        glm::vec3 s = origin - p0;
+        float u = glm::dot(s, p) * inverseDeterminant;
+        if (u < 0.0f || u > 1.0f) continue;
+        glm::vec3 q = glm::cross(s, edge1);
+        float v = glm::dot(direction, q) * inverseDeterminant;
+        if (v < 0.0f || u + v > 1.0f) continue;
+        float t = glm::dot(edge2, q) * inverseDeterminant;
+        if (t < 0.0f || t >= nearest) continue;
+        nearest = t;
+        found = true;
+        hit.triangle = triangle;
+        hit.distance = t;
+        hit.barycentrics = glm::vec2(u, v);
+      }
+      continue;
+    }
+
+    // Nearer child on top of the stack
+    uint32_t children[2] = {node.leftFirst, node.leftFirst + 1};
+    float distances[2];
+    for (int i = 0; i < 2; ++i) {
+      distances[i] =
+          IntersectBox(nodes[children[i]].boundsMin,
+                       nodes[children[i]].boundsMax, origin,
+                       inverseDirection, nearest);
+    }
+    if (distances[0] > distances[1]) {
+      std::swap(children[0], children[1]);
+      std::swap(distances[0], distances[1]);
+    }
+    for (int i = 1; i >= 0; --i) {
+      if (distances[i] != FLT_MAX) {
+        stack.push_back(children[i]);
+      }
+    }
+  }
+  if (found) {
+    hit.position = origin + hit.distance * direction;
+  }
+  return found;
+}
+
+bool TriangleBvh::Refit(std::vector<glm::vec3>&& positions) {
+  if (!IsReady() || positions.size() != m_Data->positions->size()) {
+    return false;
+  }
+  // The mesh keeps the positions it shared
+  m_Data->positions =
+      std::make_shared<const std::vector<glm::vec3>>(std::move(positions));
+
+  std::vector<Node>& nodes = m_Data->nodes;
+  const std::vector<glm::vec3>& vertexPositions = *m_Data->positions;
+  const std::vector<uint32_t>& indices = *m_Data->indices;
+  const std::vector<uint32_t>& triangleIds = m_Data->triangleIds;
+  for (size_t i = nodes.size(); i-- > 0;) {
+    Node& node = nodes[i];
+    Bounds bounds;
+    if (node.count > 0) {
+      for (uint32_t j = node.leftFirst; j < node.leftFirst + node.count; ++j) {
+        const uint32_t* triangle = &indices[triangleIds[j] * 3];
+        for (int k = 0; k < 3; ++k) {
+          bounds.Grow(vertexPositions[triangle[k]]);
+        }
+      }
+    } else {
+      for (uint32_t child = node.leftFirst; child < node.leftFirst + 2;
+           ++child) {
+        bounds.Grow(Bounds{nodes[child].boundsMin, nodes[child].boundsMax});
+      }
+    }
+    node.boundsMin = bounds.min;
+    node.boundsMax = bounds.max;
+  }
+  return true;
+}
\ No newline at end of file
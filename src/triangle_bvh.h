@@ -0,0 +1,84 @@
+#pragma once
+
+#include "macro/ptr_macro.h"
+
+// Standard library
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+// Bounding volume hierarchy over the triangles of a mesh for ray picking
+// - Built with the surface area heuristic over BIN_COUNT centroid bins per
+//   axis, down to leaves of MAX_LEAF_SIZE triangles. The top levels are
+//   split on the building thread, and the subtrees below are built in
+//   parallel on the thread pool. The tree does not depend on the thread
+//   count.
+// - Nodes are 32 bytes in one array, children after their parent. The two
+//   children of a node are adjacent, and leaves point into a triangle id
+//   array.
+// - Refit() updates the bounds for moved vertices without rebuilding.
+// The build runs in the background. Queries miss until it is finished.
+DECLARE_PTR(TriangleBvh)
+class TriangleBvh {
+ public:
+  static constexpr size_t BIN_COUNT = 16;
+  static constexpr size_t MAX_LEAF_SIZE = 4;
+  static constexpr size_t SUBTREE_COUNT = 64;  // Built in parallel
+  static constexpr size_t STACK_SIZE = 64;  // Reserved, grown if deeper
+
+  struct Hit {
+    uint32_t triangle{0};  // Index of the first index / 3
+    float distance{0.0f};  // In units of the ray direction
+    glm::vec2 barycentrics{0.0f};  // Weights of corners 1 and 2
+    glm::vec3 position{0.0f};
+  };
+
+  // Start building from the positions and triangles of a mesh. They are
+  // shared with the mesh rather than copied.
+  static TriangleBvhUPtr New(
+      std::shared_ptr<const std::vector<glm::vec3>> positions,
+      std::shared_ptr<const std::vector<uint32_t>> indices);
+
+  // Cancels the build
+  ~TriangleBvh();
+
+  bool IsReady() const;
+  size_t GetNodeCount() const;
+
+  // Nearest triangle hit by origin + t * direction for t >= 0. Both faces
+  // are hit, as both are drawn.
+  bool Intersect(const glm::vec3& origin, const glm::vec3& direction,
+                 Hit& hit) const;
+  // Replace the vertex positions and recompute the bounds bottom-up. The
+  // tree stays the same, so queries slow down if vertices move far. Return
+  // false if the build is not finished or the vertex count differs.
+  bool Refit(std::vector<glm::vec3>&& positions);
+
+ private:
+  TriangleBvh() = default;
+
+  struct Node {
+    glm::vec3 boundsMin;
+    uint32_t leftFirst;  // Left child, or first triangle id of a leaf
+    glm::vec3 boundsMax;
+    uint32_t count;  // Triangles of a leaf, 0 for inner nodes
+  };
+
+  // Shared with the worker, which may outlive the tree
+  struct Data {
+    std::shared_ptr<const std::vector<glm::vec3>> positions;
+    std::shared_ptr<const std::vector<uint32_t>> indices;
+    uint32_t triangleCount{0};
+    std::vector<uint32_t> triangleIds;
+    std::vector<Node> nodes;
+    std::atomic<bool> ready{false};
+    std::atomic<bool> cancelled{false};
+  };
+
+  std::shared_ptr<Data> m_Data;
+
+  static void build(Data& data);
+};
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+// Standard library
+#include <cstdint>
+#include <string_view>
+
+// glm
+#include <glm/glm.hpp>
+
+// std140 uniform blocks shared by the programs in resources/shader
+// ShaderProgram binds the blocks of these names to their binding points at
+// link time, so that a buffer bound once serves every program.
+namespace UniformBlocks {
+
+constexpr uint32_t FRAME_BINDING = 0;
+constexpr uint32_t OBJECT_BINDING = 1;
+
+// FrameBlock: Camera and light, set once per frame
+struct Frame {
+  glm::mat4 projection;
+  glm::mat4 view;
+  glm::vec4 cameraPosition;  // w unused
+  glm::vec4 lightPosition;   // w unused
+  glm::vec4 lightColor;      // w: Brightness of the light sphere
+  glm::vec4 lighting;        // Ambient, specular strength, shininess
+  glm::ivec4 highlight;      // Hovered object id (0 for none), triangle
+};
+
+// ObjectBlock: One per drawn object
+struct Object {
+  glm::mat4 transform;        // Local to clip
+  glm::mat4 modelTransform;   // Local to world
+  glm::mat4 normalTransform;  // Inverse transpose of modelTransform
+  glm::ivec4 ids;             // Object id (0 for none)
+};
+
+static_assert(sizeof(Frame) == 208, "Frame does not match std140");
+static_assert(sizeof(Object) == 208, "Object does not match std140");
+
+// Binding point and size of a block by its GLSL name. Return false for
+// other blocks.
+inline bool Find(std::string_view name, uint32_t& binding, size_t& size) {
+  if (name == "FrameBlock") {
+    binding = FRAME_BINDING;
+    size = sizeof(Frame);
+    return true;
+  }
+  if (name == "ObjectBlock") {
+    binding = OBJECT_BINDING;
+    size = sizeof(Object);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace UniformBlocks
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "uniform_buffer.h"
+
+#include "config/gl_config.h"
+#include "gl_state.h"
+
+UniformBufferUPtr UniformBuffer::New(uint32_t binding, size_t blockSize) {
+  auto buffer = UniformBufferUPtr(new UniformBuffer());
+  if (blockSize == 0) return nullptr;
+  buffer->init(binding, blockSize);
+  return std::move(buffer);
+}
+
+void UniformBuffer::init(uint32_t binding, size_t blockSize) {
+  int32_t alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  if (alignment <= 0) alignment = 256;  // Largest allowed by the spec
+  m_Binding = binding;
+  m_BlockSize = blockSize;
+  m_Stride = (blockSize + alignment - 1) / alignment * alignment;
+  m_Buffer = Buffer::New(GL_UNIFORM_BUFFER, GL_DYNAMIC_DRAW, nullptr,
+                         m_Stride, 1);
+}
+
+void UniformBuffer::Upload() {
+  if (m_Count == 0) return;
+  m_Buffer->SetData(m_Data.data(), m_Count);
+}
+
+void UniformBuffer::Bind(size_t index) const {
+  GLState::Instance().BindUniformBufferRange(m_Binding, m_Buffer->Get(),
+                                             index * m_Stride, m_BlockSize);
+}
\ No newline at end of file
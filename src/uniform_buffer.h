@@ -0,0 +1,51 @@
+#pragma once
+
+#include "buffer.h"
+#include "macro/ptr_macro.h"
+
+// Standard library
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Blocks of one uniform block type, staged on the CPU and uploaded at once
+// Each block starts at a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, so
+// that any of them can be bound to the binding point. The upload orphans
+// the previous storage instead of waiting for the draws that read it.
+DECLARE_PTR(UniformBuffer)
+class UniformBuffer {
+ public:
+  // blockSize: Size of the block type in std140 layout
+  static UniformBufferUPtr New(uint32_t binding, size_t blockSize);
+
+  size_t GetCount() const { return m_Count; }
+
+  // Main thread only
+  // Stage the blocks of the frame. Set() grows the count as needed.
+  void Clear() { m_Count = 0; }
+  template <typename T>
+  void Set(size_t index, const T& block) {
+    if (index >= m_Count) {
+      m_Count = index + 1;
+      m_Data.resize(m_Count * m_Stride);
+    }
+    std::memcpy(m_Data.data() + index * m_Stride, &block,
+                std::min(sizeof(T), m_BlockSize));
+  }
+  // Upload the staged blocks
+  void Upload();
+  // Bind block index to the binding point for the next draws
+  void Bind(size_t index = 0) const;
+
+ private:
+  UniformBuffer() = default;
+
+  void init(uint32_t binding, size_t blockSize);
+
+  uint32_t m_Binding{0};
+  size_t m_BlockSize{0};
+  size_t m_Stride{0};  // Block size rounded up to the offset alignment
+  size_t m_Count{0};
+  std::vector<uint8_t> m_Data;
+  BufferUPtr m_Buffer;
+};
\ No newline at end of file
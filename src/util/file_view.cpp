@@ -0,0 +1,146 @@
+#include "file_view.h"
+
+#include "../config/log_config.h"
+
+// Standard library
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FileViewUPtr FileView::New(const std::string& filePath, bool sequential) {
+  auto fileView = FileViewUPtr(new FileView());
+  if (!fileView->map(filePath, sequential)) {
+    return nullptr;
+  }
+  return std::move(fileView);
+}
+
+FileViewUPtr FileView::New(const std::string& path, uint8_t* data,
+                           size_t size) {
+  auto fileView = FileViewUPtr(new FileView());
+  fileView->m_Path = path;
+  fileView->m_Data = data;
+  fileView->m_Size = size;
+  fileView->m_bOwnsData = true;
+  return std::move(fileView);
+}
+
+#ifdef _WIN32
+FileView::~FileView() {
+  if (m_bOwnsData) {
+    std::free(m_Data);
+    return;
+  }
+  if (m_Data) UnmapViewOfFile(m_Data);
+  if (m_MappingHandle) CloseHandle(m_MappingHandle);
+  if (m_FileHandle && m_FileHandle != INVALID_HANDLE_VALUE) {
+    CloseHandle(m_FileHandle);
+  }
+}
+
+bool FileView::map(const std::string& filePath, bool sequential) {
+  m_Path = filePath;
+
+  DWORD flags = sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL;
+  m_FileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                             nullptr, OPEN_EXISTING, flags, nullptr);
+  if (m_FileHandle == INVALID_HANDLE_VALUE) {
+    SPDLOG_ERROR("Failed to open file: {}", filePath);
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(m_FileHandle, &fileSize)) {
+    SPDLOG_ERROR("Failed to get file size: {}", filePath);
+    return false;
+  }
+  m_Size = static_cast<size_t>(fileSize.QuadPart);
+  if (m_Size == 0) return true;  // Empty files cannot be mapped
+
+  m_MappingHandle =
+      CreateFileMappingA(m_FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!m_MappingHandle) {
+    SPDLOG_ERROR("Failed to create file mapping: {}", filePath);
+    return false;
+  }
+
+  m_Data = MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0);
+  if (!m_Data) {
+    SPDLOG_ERROR("Failed to map file: {}", filePath);
+    return false;
+  }
+  return true;
+}
+
+void FileView::ReleasePages(size_t offset, size_t size) const {
+  // Mapped file pages are clean and reclaimed by Windows on demand.
+}
+#else
+FileView::~FileView() {
+  if (m_bOwnsData) {
+    std::free(m_Data);
+  } else if (m_Data) {
+    munmap(m_Data, m_Size);
+  }
+}
+
+bool FileView::map(const std::string& filePath, bool sequential) {
+  m_Path = filePath;
+
+  int fd = open(filePath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    SPDLOG_ERROR("Failed to open file: {}", filePath);
+    return false;
+  }
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0) {
+    SPDLOG_ERROR("Failed to get file size: {}", filePath);
+    close(fd);
+    return false;
+  }
+  m_Size = static_cast<size_t>(fileStat.st_size);
+  if (m_Size == 0) {  // Empty files cannot be mapped
+    close(fd);
+    return true;
+  }
+
+  void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // The mapping keeps its own reference to the file.
+  if (data == MAP_FAILED) {
+    SPDLOG_ERROR("Failed to map file: {}", filePath);
+    return false;
+  }
+  m_Data = data;
+
+#ifndef __EMSCRIPTEN__
+  if (sequential) {
+    madvise(m_Data, m_Size, MADV_SEQUENTIAL);
+  }
+#endif
+  return true;
+}
+
+void FileView::ReleasePages(size_t offset, size_t size) const {
+#ifndef __EMSCRIPTEN__
+  // madvise() requires a page-aligned start address
+  if (m_bOwnsData) return;  // Heap pages cannot be handed back
+
+  const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t begin = (offset + pageSize - 1) / pageSize * pageSize;
+  size_t end = std::min(offset + size, m_Size) / pageSize * pageSize;
+  if (m_Data && begin < end) {
+    madvise(static_cast<uint8_t*>(m_Data) + begin, end - begin,
+            MADV_DONTNEED);
+  }
+#endif
+}
+#endif
\ No newline at end of file
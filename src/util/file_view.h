@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../macro/ptr_macro.h"
+
+// Standard library
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Read-only, zero-copy view of a whole file
+// - Linux, macOS: mmap
+// - Windows: file mapping object
+// - Emscripten: mmap on MemFS. The view points at the file buffer itself
+//   when the buffer lives in the wasm heap; otherwise Emscripten copies it
+//   once.
+// - Memory: A buffer allocated with malloc(), e.g. a file uploaded from the
+//   browser straight into the wasm heap. The view owns and frees it.
+// The bytes stay valid while the FileView is alive.
+DECLARE_PTR(FileView)
+class FileView {
+ public:
+  // sequential: Hint that the file is read front to back once
+  static FileViewUPtr New(const std::string& filePath,
+                          bool sequential = false);
+  // Take ownership of data. path only names the bytes in logs.
+  static FileViewUPtr New(const std::string& path, uint8_t* data,
+                          size_t size);
+
+  ~FileView();
+
+  const std::string& GetPath() const { return m_Path; }
+  const uint8_t* GetData() const { return static_cast<uint8_t*>(m_Data); }
+  size_t GetSize() const { return m_Size; }
+  std::string_view GetString() const {
+    return std::string_view(static_cast<const char*>(m_Data), m_Size);
+  }
+  // Whether count elements at offset lie in the view, without overflow
+  bool Contains(uint64_t offset, uint64_t count, size_t elementSize) const {
+    return offset <= m_Size && count <= (m_Size - offset) / elementSize;
+  }
+
+  // Tell the OS that [offset, offset + size) is not needed anymore, so that
+  // the resident memory of a sequential read stays bounded. The bytes are
+  // still readable afterwards.
+  void ReleasePages(size_t offset, size_t size) const;
+
+ private:
+  FileView() = default;
+
+  bool map(const std::string& filePath, bool sequential);
+
+  std::string m_Path;
+  void* m_Data{nullptr};
+  size_t m_Size{0};
+  bool m_bOwnsData{false};  // malloc() buffer instead of a mapping
+#ifdef _WIN32
+  void* m_FileHandle{nullptr};
+  void* m_MappingHandle{nullptr};
+#endif
+};
\ No newline at end of file
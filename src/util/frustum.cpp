@@ -0,0 +1,30 @@
+#include "frustum.h"
+
+Frustum Frustum::FromMatrix(const glm::mat4& clipMatrix) {
+  // Gribb-Hartmann: Each plane is the last row plus or minus another row.
+  auto row = [&clipMatrix](int i) {
+    return glm::vec4(clipMatrix[0][i], clipMatrix[1][i], clipMatrix[2][i],
+                     clipMatrix[3][i]);
+  };
+
+  Frustum frustum;
+  for (int i = 0; i < 3; ++i) {
+    frustum.planes[i * 2] = row(3) + row(i);
+    frustum.planes[i * 2 + 1] = row(3) - row(i);
+  }
+  return frustum;
+}
+
+bool Frustum::Intersects(const glm::vec3& boxMin,
+                         const glm::vec3& boxMax) const {
+  for (const glm::vec4& plane : planes) {
+    // Corner of the box farthest along the plane normal
+    glm::vec3 corner(plane.x >= 0.0f ? boxMax.x : boxMin.x,
+                     plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                     plane.z >= 0.0f ? boxMax.z : boxMin.z);
+    if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
\ No newline at end of file
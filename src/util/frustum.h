@@ -0,0 +1,16 @@
+#pragma once
+
+// glm
+#include <glm/glm.hpp>
+
+// View frustum as six planes (left, right, bottom, top, near, far) facing
+// inwards. Planes are taken from a clip matrix, so they are in the space the
+// matrix transforms from, e.g. model space for projection * view * model.
+struct Frustum {
+  glm::vec4 planes[6];
+
+  static Frustum FromMatrix(const glm::mat4& clipMatrix);
+
+  // Conservative: A box outside only because of a frustum corner is kept.
+  bool Intersects(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+};
\ No newline at end of file
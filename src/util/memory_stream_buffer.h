@@ -0,0 +1,15 @@
+#pragma once
+
+// Standard library
+#include <cstdint>
+#include <streambuf>
+
+// Read-only streambuf over mapped bytes, so cereal can read a header without
+// copying it.
+class MemoryStreamBuffer : public std::streambuf {
+ public:
+  MemoryStreamBuffer(const uint8_t* data, size_t size) {
+    char* begin = reinterpret_cast<char*>(const_cast<uint8_t*>(data));
+    setg(begin, begin, begin + size);
+  }
+};
\ No newline at end of file
@@ -1,9 +1,40 @@
 #include "path_util.h"
 
+// Standard library
+#include <atomic>
+#include <cstdio>
+#include <random>
+
 std::string PathUtil::GetExtension(const std::string& path) {
   size_t pos = path.find_last_of('.');
   if (pos == std::string::npos) {
     return "";
   }
   return path.substr(pos);
+}
+
+std::string PathUtil::GetFileName(const std::string& path) {
+  size_t pos = path.find_last_of("/\\");
+  if (pos == std::string::npos) {
+    return path;
+  }
+  return path.substr(pos + 1);
+}
+
+std::string PathUtil::GetDirectory(const std::string& path) {
+  size_t pos = path.find_last_of("/\\");
+  if (pos == std::string::npos) {
+    return "";
+  }
+  return path.substr(0, pos + 1);
+}
+
+std::string PathUtil::GetUniquePath(const std::string& path) {
+  // Random per process, counted per call
+  static const uint32_t s_ProcessId = std::random_device()();
+  static std::atomic<uint32_t> s_Counter{0};
+  char suffix[32];
+  std::snprintf(suffix, sizeof(suffix), ".%08x%08x", s_ProcessId,
+                s_Counter.fetch_add(1));
+  return path + suffix;
 }
\ No newline at end of file
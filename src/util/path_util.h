@@ -6,5 +6,11 @@
 namespace PathUtil {
 
 std::string GetExtension(const std::string& path);
+std::string GetFileName(const std::string& path);
+// Directory part including the trailing separator, or "" if there is none
+std::string GetDirectory(const std::string& path);
+// path with a suffix no other call returns, in this or another process, for
+// temporary files written next to path
+std::string GetUniquePath(const std::string& path);
 
 }
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include "vertex_format.h"
+
+#include "config/gl_config.h"
+#include "mesh.h"
+#include "thread_pool.h"
+
+// Standard library
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr size_t GRAIN_SIZE = 64 * 1024;
+constexpr size_t QUANTIZED_POSITION_SIZE = 4 * sizeof(uint16_t);  // Padded
+constexpr size_t OCTAHEDRAL_SIZE = 2 * sizeof(int16_t);
+
+size_t GetPositionSize(const VertexFormat& format) {
+  return format.quantizePositions ? QUANTIZED_POSITION_SIZE
+                                  : sizeof(glm::vec3);
+}
+
+size_t GetNormalSize(const VertexFormat& format) {
+  return format.octahedralNormals ? OCTAHEDRAL_SIZE : sizeof(glm::vec3);
+}
+
+size_t GetTexCoordSize(const VertexFormat& format) {
+  if (!format.texCoords) return 0;
+  return format.halfTexCoords ? 2 * sizeof(uint16_t) : sizeof(glm::vec2);
+}
+
+// Octahedral tangents are followed by the handedness and padding.
+size_t GetTangentSize(const VertexFormat& format) {
+  if (!format.texCoords) return 0;
+  return format.octahedralNormals ? 2 * OCTAHEDRAL_SIZE : sizeof(glm::vec4);
+}
+
+uint16_t ToHalf(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+  int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+  uint32_t mantissa = bits & 0x7fffff;
+
+  if (exponent >= 31) {
+    // Overflow and infinity saturate to infinity, NaN stays NaN.
+    bool isNan = ((bits >> 23) & 0xff) == 0xff && mantissa != 0;
+    return sign | 0x7c00 | (isNan ? 0x200 : 0);
+  }
+  if (exponent <= 0) {
+    if (exponent < -10) return sign;  // Too small even for a subnormal
+    mantissa |= 0x800000;
+    uint32_t shift = static_cast<uint32_t>(14 - exponent);
+    uint32_t half = mantissa >> shift;
+    uint32_t rest = mantissa & ((1u << shift) - 1);
+    uint32_t halfway = 1u << (shift - 1);
+    half += rest > halfway || (rest == halfway && (half & 1));
+    return sign | static_cast<uint16_t>(half);
+  }
+
+  // Round to nearest even. A carry into the exponent is still correct.
+  uint32_t half = (uint32_t(exponent) << 10) | (mantissa >> 13);
+  uint32_t rest = mantissa & 0x1fff;
+  half += rest > 0x1000 || (rest == 0x1000 && (half & 1));
+  return sign | static_cast<uint16_t>(std::min<uint32_t>(half, 0x7c00));
+}
+
+float FromHalf(uint16_t half) {
+  uint32_t sign = uint32_t(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  if (exponent == 0) {
+    // Zero or subnormal
+    float value = std::ldexp(float(mantissa), -24);
+    return sign ? -value : value;
+  }
+  uint32_t bits = exponent == 0x1f
+                      ? sign | 0x7f800000 | (mantissa << 13)  // Inf, NaN
+                      : sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+uint16_t ToUnorm16(float value) {
+  return static_cast<uint16_t>(std::lround(value * 65535.0f));
+}
+
+int16_t ToSnorm16(float value) {
+  value = std::clamp(value, -1.0f, 1.0f);
+  return static_cast<int16_t>(std::lround(value * 32767.0f));
+}
+
+// Octahedral mapping of a unit vector onto [-1, 1]^2
+void EncodeOctahedral(const glm::vec3& vector, int16_t* out) {
+  float sum = std::abs(vector.x) + std::abs(vector.y) + std::abs(vector.z);
+  if (sum == 0.0f) {
+    out[0] = out[1] = 0;
+    return;
+  }
+  glm::vec2 p(vector.x / sum, vector.y / sum);
+  if (vector.z < 0.0f) {
+    // Fold the lower hemisphere over the diagonals
+    glm::vec2 folded(1.0f - std::abs(p.y), 1.0f - std::abs(p.x));
+    p = glm::vec2(p.x >= 0.0f ? folded.x : -folded.x,
+                  p.y >= 0.0f ? folded.y : -folded.y);
+  }
+  out[0] = ToSnorm16(p.x);
+  out[1] = ToSnorm16(p.y);
+}
+
+float FromSnorm16(int16_t value) {
+  return std::max(value / 32767.0f, -1.0f);
+}
+
+glm::vec3 DecodeOctahedral(const int16_t* in) {
+  glm::vec2 p(FromSnorm16(in[0]), FromSnorm16(in[1]));
+  glm::vec3 vector(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y));
+  if (vector.z < 0.0f) {
+    vector.x = (1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f);
+    vector.y = (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f);
+  }
+  return glm::normalize(vector);
+}
+
+}  // namespace
+
+size_t VertexFormat::GetStride() const {
+  return GetPositionSize(*this) + GetNormalSize(*this) +
+         GetTexCoordSize(*this) + GetTangentSize(*this);
+}
+
+size_t VertexFormat::GetPositionStreamStride() const {
+  return splitPositions ? GetPositionSize(*this) : GetStride();
+}
+
+size_t VertexFormat::GetAttributeStreamStride() const {
+  return splitPositions ? GetStride() - GetPositionSize(*this) : GetStride();
+}
+
+void VertexFormat::Encode(const Vertex* vertices, size_t count,
+                          const glm::vec3& boundsMin,
+                          const glm::vec3& boundsMax,
+                          std::vector<uint8_t>& positionStream,
+                          std::vector<uint8_t>& attributeStream) const {
+  const size_t positionStride = GetPositionStreamStride();
+  const size_t attributeStride = GetAttributeStreamStride();
+  positionStream.resize(positionStride * count);
+  attributeStream.resize(splitPositions ? attributeStride * count : 0);
+
+  glm::vec3 extent = boundsMax - boundsMin;
+  glm::vec3 invExtent(extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+                      extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+                      extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+  ThreadPool::Instance().ParallelFor(count, GRAIN_SIZE, [&](size_t begin,
+                                                            size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const Vertex& vertex = vertices[i];
+      uint8_t* out = positionStream.data() + i * positionStride;
+
+      if (quantizePositions) {
+        glm::vec3 unit = glm::clamp((vertex.position - boundsMin) * invExtent,
+                                    glm::vec3(0.0f), glm::vec3(1.0f));
+        uint16_t values[4] = {ToUnorm16(unit.x), ToUnorm16(unit.y),
+                              ToUnorm16(unit.z), 0};
+        std::memcpy(out, values, sizeof(values));
+      } else {
+        std::memcpy(out, &vertex.position, sizeof(glm::vec3));
+      }
+      out += GetPositionSize(*this);
+      if (splitPositions) {
+        out = attributeStream.data() + i * attributeStride;
+      }
+
+      if (octahedralNormals) {
+        int16_t values[2];
+        EncodeOctahedral(vertex.normal, values);
+        std::memcpy(out, values, sizeof(values));
+      } else {
+        std::memcpy(out, &vertex.normal, sizeof(glm::vec3));
+      }
+      out += GetNormalSize(*this);
+
+      if (!texCoords) continue;
+      if (halfTexCoords) {
+        uint16_t values[2] = {ToHalf(vertex.texCoord.x),
+                              ToHalf(vertex.texCoord.y)};
+        std::memcpy(out, values, sizeof(values));
+      } else {
+        std::memcpy(out, &vertex.texCoord, sizeof(glm::vec2));
+      }
+      out += GetTexCoordSize(*this);
+      if (octahedralNormals) {
+        int16_t values[4] = {0, 0, 0, ToSnorm16(vertex.tangent.w)};
+        EncodeOctahedral(glm::vec3(vertex.tangent), values);
+        std::memcpy(out, values, sizeof(values));
+      } else {
+        std::memcpy(out, &vertex.tangent, sizeof(glm::vec4));
+      }
+    }
+  });
+}
+
+void VertexFormat::Decode(const uint8_t* positionStream,
+                          const uint8_t* attributeStream, size_t count,
+                          const glm::vec3& boundsMin,
+                          const glm::vec3& boundsMax,
+                          Vertex* vertices) const {
+  const size_t positionStride = GetPositionStreamStride();
+  const size_t attributeStride = GetAttributeStreamStride();
+  const glm::vec3 extent = boundsMax - boundsMin;
+
+  ThreadPool::Instance().ParallelFor(count, GRAIN_SIZE, [&](size_t begin,
+                                                            size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      Vertex& vertex = vertices[i];
+      vertex = Vertex{};
+      const uint8_t* in = positionStream + i * positionStride;
+
+      if (quantizePositions) {
+        uint16_t values[3];
+        std::memcpy(values, in, sizeof(values));
+        vertex.position =
+            boundsMin + glm::vec3(values[0], values[1], values[2]) *
+                            (1.0f / 65535.0f) * extent;
+      } else {
+        std::memcpy(&vertex.position, in, sizeof(glm::vec3));
+      }
+      in += GetPositionSize(*this);
+      if (splitPositions) {
+        in = attributeStream + i * attributeStride;
+      }
+
+      if (octahedralNormals) {
+        int16_t values[2];
+        std::memcpy(values, in, sizeof(values));
+        vertex.normal = DecodeOctahedral(values);
+      } else {
+        std::memcpy(&vertex.normal, in, sizeof(glm::vec3));
+      }
+      in += GetNormalSize(*this);
+
+      if (!texCoords) continue;
+      if (halfTexCoords) {
+        uint16_t values[2];
+        std::memcpy(values, in, sizeof(values));
+        vertex.texCoord = glm::vec2(FromHalf(values[0]), FromHalf(values[1]));
+      } else {
+        std::memcpy(&vertex.texCoord, in, sizeof(glm::vec2));
+      }
+      in += GetTexCoordSize(*this);
+      if (octahedralNormals) {
+        int16_t values[4];
+        std::memcpy(values, in, sizeof(values));
+        vertex.tangent =
+            glm::vec4(DecodeOctahedral(values), FromSnorm16(values[3]));
+      } else {
+        std::memcpy(&vertex.tangent, in, sizeof(glm::vec4));
+      }
+    }
+  });
+}
+
+void VertexFormat::SetAttribs(const VertexLayout& layout,
+                              const Buffer& positionStream,
+                              const Buffer& attributeStream) const {
+  positionStream.Bind();
+  if (quantizePositions) {
+    layout.SetAttrib(0, 3, GL_UNSIGNED_SHORT, true, GetPositionStreamStride(),
+                     0);
+  } else {
+    layout.SetAttrib(0, 3, GL_FLOAT, false, GetPositionStreamStride(), 0);
+  }
+
+  attributeStream.Bind();
+  const size_t stride = GetAttributeStreamStride();
+  uint64_t offset = splitPositions ? 0 : GetPositionSize(*this);
+  if (octahedralNormals) {
+    layout.SetAttrib(1, 2, GL_SHORT, true, stride, offset);
+  } else {
+    layout.SetAttrib(1, 3, GL_FLOAT, false, stride, offset);
+  }
+  offset += GetNormalSize(*this);
+
+  if (!texCoords) {
+    layout.DisableAttrib(2);
+    layout.DisableAttrib(3);
+    return;
+  }
+  if (halfTexCoords) {
+    layout.SetAttrib(2, 2, GL_HALF_FLOAT, false, stride, offset);
+  } else {
+    layout.SetAttrib(2, 2, GL_FLOAT, false, stride, offset);
+  }
+  offset += GetTexCoordSize(*this);
+  if (octahedralNormals) {
+    layout.SetAttrib(3, 4, GL_SHORT, true, stride, offset);
+  } else {
+    layout.SetAttrib(3, 4, GL_FLOAT, false, stride, offset);
+  }
+}
+
+void VertexFormat::GetPositionDecode(const glm::vec3& boundsMin,
+                                     const glm::vec3& boundsMax,
+                                     glm::vec3& offset,
+                                     glm::vec3& scale) const {
+  if (quantizePositions) {
+    offset = boundsMin;
+    scale = boundsMax - boundsMin;
+  } else {
+    offset = glm::vec3(0.0f);
+    scale = glm::vec3(1.0f);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "buffer.h"
+#include "vertex_layout.h"
+
+// Standard library
+#include <cstdint>
+#include <vector>
+
+// glm
+#include <glm/glm.hpp>
+
+struct Vertex;
+
+// Encoding of Vertex in GPU vertex buffers (48 bytes as floats)
+// - splitPositions: Positions go to a stream of their own and the other
+//   attributes are interleaved in a second one, for position-only passes
+//   (depth, shadows) to fetch only the positions. Off, as no pass draws
+//   positions only yet. Otherwise Vertex is interleaved in one stream, which
+//   is uploaded as is if nothing else is compacted.
+// Compact encodings, decoded by the vertex shaders:
+// - quantizePositions: 3x unorm16 relative to the mesh bounds (8 bytes).
+//   Decoded with u_positionOffset and u_positionScale.
+// - octahedralNormals: Normal as octahedral 2x snorm16 (4 bytes). Tangent as
+//   4x snorm16 (8 bytes): octahedral xy, 0 and the handedness in w. Decoded
+//   when u_octahedralNormal is set.
+// - halfTexCoords: 2x half float (4 bytes)
+// - texCoords: false omits texCoord and tangent, e.g. without textures
+// All compact: 24 bytes, or 12 bytes without texCoords.
+struct VertexFormat {
+  bool splitPositions{false};
+  bool quantizePositions{false};
+  bool octahedralNormals{false};
+  bool halfTexCoords{false};
+  bool texCoords{true};
+
+  // One stream laid out exactly like Vertex
+  bool IsInterleavedVertex() const {
+    return !splitPositions && !quantizePositions && !octahedralNormals &&
+           !halfTexCoords && texCoords;
+  }
+  size_t GetStride() const;  // Bytes per vertex over all streams
+  size_t GetPositionStreamStride() const;
+  size_t GetAttributeStreamStride() const;
+
+  // Encode count vertices. Positions are quantized over
+  // [boundsMin, boundsMax]. Without splitPositions, everything goes to
+  // positionStream and attributeStream is left empty.
+  void Encode(const Vertex* vertices, size_t count,
+              const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+              std::vector<uint8_t>& positionStream,
+              std::vector<uint8_t>& attributeStream) const;
+
+  // Inverse of Encode(), e.g. for streams read back from the GPU. Compact
+  // attributes come back with their quantization error, and omitted ones are
+  // zero. attributeStream is ignored without splitPositions.
+  void Decode(const uint8_t* positionStream, const uint8_t* attributeStream,
+              size_t count, const glm::vec3& boundsMin,
+              const glm::vec3& boundsMax, Vertex* vertices) const;
+
+  // Point attributes 0 ~ 3 of the bound layout at the streams, which are
+  // the same buffer without splitPositions. Omitted attributes are
+  // disabled.
+  void SetAttribs(const VertexLayout& layout, const Buffer& positionStream,
+                  const Buffer& attributeStream) const;
+
+  // Decoding uniforms: position = offset + attribute * scale
+  void GetPositionDecode(const glm::vec3& boundsMin,
+                         const glm::vec3& boundsMax, glm::vec3& offset,
+                         glm::vec3& scale) const;
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "vertex_layout.h"
 
 #include "config/gl_config.h"
+#include "gl_state.h"
 
 VertexLayoutUPtr VertexLayout::New() {
   auto vertexLayout = VertexLayoutUPtr(new VertexLayout());
@@ -10,11 +11,14 @@ VertexLayoutUPtr VertexLayout::New() {
 
 VertexLayout::~VertexLayout() {
   if (m_VertexArrayObject) {
+    GLState::Instance().OnDeleteVertexArray(m_VertexArrayObject);
     glDeleteVertexArrays(1, &m_VertexArrayObject);
   }
 }
 
-void VertexLayout::Bind() const { glBindVertexArray(m_VertexArrayObject); }
+void VertexLayout::Bind() const {
+  GLState::Instance().BindVertexArray(m_VertexArrayObject);
+}
 
 void VertexLayout::SetAttrib(uint32_t attribIndex, int32_t count, uint32_t type,
                              bool normalized, size_t stride,